@@ -0,0 +1,74 @@
+#include "box_utils.h"
+
+static float matchScore(const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b,
+    BoxMatchMetric metric)
+{
+    return metric == BoxMatchMetric::kIoS ? boxIoS(a, b) : boxIoU(a, b);
+}
+
+static void sortByConfidence(std::vector<NvDsInferParseObjectInfo>& objects)
+{
+    std::stable_sort(objects.begin(), objects.end(),
+        [](const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b) {
+            return a.detectionConfidence > b.detectionConfidence;
+        });
+}
+
+void nonMaximumSuppression(std::vector<NvDsInferParseObjectInfo>& objects,
+    float threshold, BoxMatchMetric metric)
+{
+    sortByConfidence(objects);
+    size_t numKept = 0;
+    for (size_t i = 0; i < objects.size(); i++) {
+        bool keep = true;
+        for (size_t j = 0; j < numKept; j++) {
+            if (objects[j].classId == objects[i].classId &&
+                matchScore(objects[j], objects[i], metric) > threshold) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            objects[numKept++] = objects[i];
+        }
+    }
+    objects.resize(numKept);
+}
+
+void fuseBoxes(std::vector<NvDsInferParseObjectInfo>& objects,
+    float threshold, BoxMatchMetric metric)
+{
+    sortByConfidence(objects);
+    std::vector<NvDsInferParseObjectInfo> fused;
+    std::vector<bool> used(objects.size(), false);
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (used[i]) {
+            continue;
+        }
+        const NvDsInferParseObjectInfo& best = objects[i];
+        float x1 = 0.F, y1 = 0.F, x2 = 0.F, y2 = 0.F, weight = 0.F;
+        for (size_t j = i; j < objects.size(); j++) {
+            const NvDsInferParseObjectInfo& obj = objects[j];
+            if (used[j] || obj.classId != best.classId ||
+                (j != i && matchScore(best, obj, metric) <= threshold)) {
+                continue;
+            }
+            used[j] = true;
+            float w = obj.detectionConfidence;
+            x1 += w * obj.left;
+            y1 += w * obj.top;
+            x2 += w * (obj.left + obj.width);
+            y2 += w * (obj.top + obj.height);
+            weight += w;
+        }
+        NvDsInferParseObjectInfo out = best;
+        if (weight > 0.F) {
+            out.left = x1 / weight;
+            out.top = y1 / weight;
+            out.width = (x2 - x1) / weight;
+            out.height = (y2 - y1) / weight;
+        }
+        fused.push_back(out);
+    }
+    objects.swap(fused);
+}
@@ -0,0 +1,68 @@
+#ifndef _BOX_UTILS_H_
+#define _BOX_UTILS_H_
+
+#include <algorithm>
+#include <vector>
+#include "nvdsinfer.h"
+
+struct TileRect
+{
+    float left;
+    float top;
+    float width;
+    float height;
+};
+
+// Boxes are NvDsInferParseObjectInfo in [left top width height] form
+inline float boxArea(const NvDsInferParseObjectInfo& b)
+{
+    return std::max(b.width, 0.F) * std::max(b.height, 0.F);
+}
+
+inline float boxIntersection(const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b)
+{
+    float w = std::min(a.left + a.width, b.left + b.width) - std::max(a.left, b.left);
+    float h = std::min(a.top + a.height, b.top + b.height) - std::max(a.top, b.top);
+    return (w > 0.F && h > 0.F) ? w * h : 0.F;
+}
+
+// Clip box in place to the rectangle [left, left + width) x [top, top + height)
+inline void clipBox(NvDsInferParseObjectInfo& b, float left, float top, float width, float height)
+{
+    float x1 = std::max(b.left, left);
+    float y1 = std::max(b.top, top);
+    float x2 = std::min(b.left + b.width, left + width);
+    float y2 = std::min(b.top + b.height, top + height);
+    b.left = x1;
+    b.top = y1;
+    b.width = std::max(x2 - x1, 0.F);
+    b.height = std::max(y2 - y1, 0.F);
+}
+
+inline float boxIoU(const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b)
+{
+    float inter = boxIntersection(a, b);
+    float uni = boxArea(a) + boxArea(b) - inter;
+    return uni > 0.F ? inter / uni : 0.F;
+}
+
+// Intersection over the smaller box, matches a box cut at a tile edge with
+// the full box seen by the neighbour tile
+inline float boxIoS(const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b)
+{
+    float smaller = std::min(boxArea(a), boxArea(b));
+    return smaller > 0.F ? boxIntersection(a, b) / smaller : 0.F;
+}
+
+enum class BoxMatchMetric { kIoU, kIoS };
+
+// Class-aware greedy NMS, keeps the most confident box of each cluster
+void nonMaximumSuppression(std::vector<NvDsInferParseObjectInfo>& objects,
+    float threshold, BoxMatchMetric metric = BoxMatchMetric::kIoU);
+
+// Class-aware weighted box fusion, each cluster is replaced by the
+// confidence-weighted mean box with the cluster's best confidence
+void fuseBoxes(std::vector<NvDsInferParseObjectInfo>& objects,
+    float threshold, BoxMatchMetric metric = BoxMatchMetric::kIoU);
+
+#endif // _BOX_UTILS_H_
@@ -0,0 +1,118 @@
+#include "build_matrix.h"
+#include "custom_config.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+static std::string replaceAll(std::string s, const std::string& from, const std::string& to)
+{
+    for (size_t pos = s.find(from); pos != std::string::npos; pos = s.find(from, pos + to.size())) {
+        s.replace(pos, from.size(), to);
+    }
+    return s;
+}
+
+bool planBuildMatrix(const CustomConfig& config, std::vector<BuildJob>& jobs)
+{
+    std::vector<std::string> models = splitString(config.getString("matrix", "models"), ',');
+    std::vector<std::string> batches = splitString(config.getString("matrix", "batch-sizes", "1"), ',');
+    std::vector<std::string> precisions = splitString(config.getString("matrix", "precisions", "fp16"), ',');
+    std::string weights = config.getString("matrix", "weights", "{model}.wts");
+    std::string outputDir = config.getString("matrix", "output-dir", ".");
+    int gpuId = config.getInt("matrix", "gpu-id", 0);
+    bool sparseWeights = config.getBool("matrix", "sparse-weights");
+
+    if (models.empty()) {
+        std::cerr << "Build matrix has no models" << std::endl;
+        return false;
+    }
+
+    jobs.clear();
+    for (const std::string& model : models) {
+        for (const std::string& b : batches) {
+            int batchSize = std::atoi(b.c_str());
+            if (batchSize <= 0) {
+                std::cerr << "Invalid batch size in build matrix: " << b << std::endl;
+                return false;
+            }
+            for (const std::string& precision : precisions) {
+                if (precision != "fp32" && precision != "fp16" && precision != "int8") {
+                    std::cerr << "Invalid precision in build matrix: " << precision << std::endl;
+                    return false;
+                }
+                BuildJob job;
+                job.model = model;
+                job.weightsPath = replaceAll(weights, "{model}", model);
+                job.batchSize = batchSize;
+                job.precision = precision;
+                job.gpuId = gpuId;
+                job.sparseWeights = sparseWeights;
+                job.enginePath = outputDir + "/" + model + "_b" + std::to_string(batchSize) +
+                    "_gpu" + std::to_string(gpuId) + "_" + precision + ".engine";
+                jobs.push_back(job);
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<BuildResult> runBuildMatrix(const std::vector<BuildJob>& jobs, int maxWorkers, BuildFunc build)
+{
+    std::vector<BuildResult> results(jobs.size());
+    ThreadPool pool(std::max(std::min(maxWorkers, (int)jobs.size()), 1));
+    pool.parallelFor(jobs.size(), [&](int i, int) {
+        auto start = std::chrono::steady_clock::now();
+        results[i] = build(jobs[i]);
+        results[i].job = jobs[i];
+        results[i].buildSeconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << (results[i].success ? "Built " : "Failed ") << jobs[i].enginePath
+                  << " in " << results[i].buildSeconds << "s" << std::endl;
+    });
+    return results;
+}
+
+static std::string jsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+bool writeManifest(const std::string& path, const std::vector<BuildResult>& results)
+{
+    std::ofstream output(path);
+    if (!output.is_open()) {
+        std::cerr << "Unable to write manifest: " << path << std::endl;
+        return false;
+    }
+    output << "{\n  \"engines\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BuildResult& r = results[i];
+        output << (i ? "," : "") << "\n    {"
+               << "\"model\": " << jsonString(r.job.model)
+               << ", \"batch_size\": " << r.job.batchSize
+               << ", \"precision\": " << jsonString(r.job.precision)
+               << ", \"gpu_id\": " << r.job.gpuId
+               << ", \"sparse_weights\": " << (r.job.sparseWeights ? "true" : "false")
+               << ", \"engine\": " << jsonString(r.job.enginePath)
+               << ", \"success\": " << (r.success ? "true" : "false")
+               << ", \"build_seconds\": " << std::fixed << std::setprecision(3) << r.buildSeconds
+               << ", \"engine_bytes\": " << r.engineBytes;
+        if (!r.error.empty()) {
+            output << ", \"error\": " << jsonString(r.error);
+        }
+        output << "}";
+    }
+    output << "\n  ]\n}\n";
+    return true;
+}
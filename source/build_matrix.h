@@ -0,0 +1,56 @@
+#ifndef _BUILD_MATRIX_H_
+#define _BUILD_MATRIX_H_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+class CustomConfig;
+
+struct BuildJob
+{
+    std::string model;
+    std::string weightsPath;
+    int batchSize;
+    std::string precision;
+    int gpuId;
+    std::string enginePath;
+    bool sparseWeights = false;
+};
+
+struct BuildResult
+{
+    BuildJob job;
+    bool success = false;
+    double buildSeconds = 0.0;
+    uint64_t engineBytes = 0;
+    std::string error;
+};
+
+/**
+ * Expands the [matrix] section of a build matrix file into one job per
+ * model x batch size x precision:
+ *
+ *   [matrix]
+ *   models=yolov5s,yolov5m
+ *   weights=../data/{model}.wts
+ *   batch-sizes=1,4,8,16
+ *   precisions=fp32,fp16
+ *   gpu-id=0
+ *   output-dir=.
+ *   sparse-weights=0
+ *
+ * Engines are named like the ones nvinfer generates, e.g.
+ * yolov5s_b4_gpu0_fp16.engine.
+ */
+bool planBuildMatrix(const CustomConfig& config, std::vector<BuildJob>& jobs);
+
+typedef std::function<BuildResult(const BuildJob& job)> BuildFunc;
+
+// Runs the jobs on at most maxWorkers threads, results in job order
+std::vector<BuildResult> runBuildMatrix(const std::vector<BuildJob>& jobs, int maxWorkers, BuildFunc build);
+
+bool writeManifest(const std::string& path, const std::vector<BuildResult>& results);
+
+#endif // _BUILD_MATRIX_H_
@@ -9,7 +9,9 @@
 #include <cstring>
 #include <cassert>
 #include "NvInfer.h"
+#include "weight_store.h"
 #include "yololayer.h"
+#include "sppflayer.h"
 
 #define CHECK(status) \
     do\
@@ -24,188 +26,215 @@
 
 using namespace nvinfer1;
 
-// TensorRT weight files have a simple space delimited format:
-// [type] [size] <data x size in hex>
-std::map<std::string, Weights> loadWeights(const std::string file) {
-    std::cout << "Loading weights: " << file << std::endl;
-    std::map<std::string, Weights> weightMap;
-
-    // Open weights file
-    std::ifstream input(file);
-    assert(input.is_open() && "Unable to load weight file, please check the wts file path.");
-
-    // Read number of weight blobs
-    int32_t count;
-    input >> count;
-    assert(count > 0 && "Invalid weight map file.");
-
-    while (count--)
-    {
-        Weights wt{ DataType::kFLOAT, nullptr, 0 };
-        uint32_t size;
-
-        // Read name and type of blob
-        std::string name;
-        input >> name >> std::dec >> size;
-        wt.type = DataType::kFLOAT;
-
-        // Load blob
-        uint32_t* val = reinterpret_cast<uint32_t*>(malloc(sizeof(val) * size));
-        for (uint32_t x = 0, y = size; x < y; ++x)
-        {
-            input >> std::hex >> val[x];
-        }
-        wt.values = val;
+// QAT models carry optional quantization scales next to the float weights:
+//   <lname>.conv.input_scale   per-tensor scale of the conv input
+//   <lname>.conv.weight_scale  per-output-channel scales of the conv weights
+//   <lname>.add_input_scale    per-tensor scale of a bottleneck shortcut
+// With them the network gets explicit IQuantizeLayer/IDequantizeLayer pairs
+// and builds INT8 without a calibration pass.
+bool hasQuantScales(const WeightStore& weights)
+{
+    bool found = false;
+    weights.forEach([&](const char* name, const Weights&) {
+        size_t length = strlen(name);
+        found = found || (length > 6 && strcmp(name + length - 6, "_scale") == 0);
+    });
+    return found;
+}
 
-        wt.count = size;
-        weightMap[name] = wt;
+// Quantizes and dequantizes tensor with the scales of weights[scaleName],
+// per-tensor for a single scale, else per-channel along axis
+ITensor* addQuantDequant(INetworkDefinition *network, WeightStore& weights,
+    ITensor& input, const char* scaleName, int axis)
+{
+    Weights scale = weights.get(scaleName);
+    Dims scaleDims;
+    if (scale.count == 1) {
+        scaleDims.nbDims = 0;
+    } else {
+        scaleDims.nbDims = 1;
+        scaleDims.d[0] = scale.count;
     }
-
-    return weightMap;
+    auto scaleConst = network->addConstant(scaleDims, scale);
+    assert(scaleConst);
+
+    auto q = network->addQuantize(input, *scaleConst->getOutput(0));
+    assert(q);
+    q->setName(WeightName(scaleName, ".quantize"));
+    auto dq = network->addDequantize(*q->getOutput(0), *scaleConst->getOutput(0));
+    assert(dq);
+    dq->setName(WeightName(scaleName, ".dequantize"));
+    if (scale.count != 1) {
+        q->setAxis(axis);
+        dq->setAxis(axis);
+    }
+    return dq->getOutput(0);
 }
 
-IScaleLayer* addBatchNorm2d(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, 
-    ITensor& input, std::string lname, float eps)
+IScaleLayer* addBatchNorm2d(INetworkDefinition *network, WeightStore& weights, 
+    ITensor& input, const char* lname, float eps)
 {
-    float *gamma = (float*)weightMap[lname + ".weight"].values;
-    float *beta = (float*)weightMap[lname + ".bias"].values;
-    float *mean = (float*)weightMap[lname + ".running_mean"].values;
-    float *var = (float*)weightMap[lname + ".running_var"].values;
-    int len = weightMap[lname + ".running_var"].count;
-
-    float *scval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+    float *gamma = (float*)weights.get(WeightName(lname, ".weight")).values;
+    float *beta = (float*)weights.get(WeightName(lname, ".bias")).values;
+    float *mean = (float*)weights.get(WeightName(lname, ".running_mean")).values;
+    Weights running_var = weights.get(WeightName(lname, ".running_var"));
+    float *var = (float*)running_var.values;
+    int len = running_var.count;
+
+    // Folded scale, shift and power live in the store's arena until the build ends
+    float *scval = weights.allocate(3 * len);
+    float *shval = scval + len;
+    float *pval = shval + len;
     for (int i = 0; i < len; i++) {
         scval[i] = gamma[i] / sqrt(var[i] + eps);
-    }
-    Weights scale{ DataType::kFLOAT, scval, len };
-
-    float *shval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
         shval[i] = beta[i] - mean[i] * gamma[i] / sqrt(var[i] + eps);
-    }
-    Weights shift{ DataType::kFLOAT, shval, len };
-
-    float *pval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
         pval[i] = 1.0;
     }
+    Weights scale{ DataType::kFLOAT, scval, len };
+    Weights shift{ DataType::kFLOAT, shval, len };
     Weights power{ DataType::kFLOAT, pval, len };
 
-    weightMap[lname + ".scale"] = scale;
-    weightMap[lname + ".shift"] = shift;
-    weightMap[lname + ".power"] = power;
     IScaleLayer* scale_1 = network->addScale(input, ScaleMode::kCHANNEL, shift, scale, power);
     assert(scale_1);
+    scale_1->setName(lname);
     return scale_1;
 }
 
-ILayer* convBlock(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, 
-    int outch, int ksize, int s, int g, std::string lname, int p=-1)
+ILayer* convBlock(INetworkDefinition *network, WeightStore& weights, ITensor& input, 
+    int outch, int ksize, int s, int g, const char* lname, int p=-1)
 {
     Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
     if (p == -1) {
         p = ksize / 2;
     }
-    IConvolutionLayer* conv1 = network->addConvolutionNd(input, outch, DimsHW{ ksize, ksize }, weightMap[lname + ".conv.weight"], emptywts);
-    assert(conv1);
+    ITensor* x = &input;
+    WeightName inputScale(lname, ".conv.input_scale");
+    if (weights.contains(inputScale)) {
+        x = addQuantDequant(network, weights, input, inputScale, 0);
+    }
+    Weights kernelWeights = weights.get(WeightName(lname, ".conv.weight"));
+    WeightName weightScale(lname, ".conv.weight_scale");
+    IConvolutionLayer* conv1;
+    if (weights.contains(weightScale)) {
+        // Weights go through Q/DQ as a constant kernel input
+        int inch = input.getDimensions().d[0];
+        auto kernel = network->addConstant(Dims4{ outch, inch / g, ksize, ksize }, kernelWeights);
+        assert(kernel);
+        ITensor* qkernel = addQuantDequant(network, weights, *kernel->getOutput(0), weightScale, 0);
+        conv1 = network->addConvolutionNd(*x, outch, DimsHW{ ksize, ksize }, emptywts, emptywts);
+        assert(conv1);
+        conv1->setInput(1, *qkernel);
+    } else {
+        conv1 = network->addConvolutionNd(*x, outch, DimsHW{ ksize, ksize }, kernelWeights, emptywts);
+        assert(conv1);
+    }
+    conv1->setName(WeightName(lname, ".conv"));
     conv1->setStrideNd(DimsHW{ s, s });
     conv1->setPaddingNd(DimsHW{ p, p });
     conv1->setNbGroups(g);
-    IScaleLayer* bn1 = addBatchNorm2d(network, weightMap, *conv1->getOutput(0), lname + ".bn", 1e-3);
+    IScaleLayer* bn1 = addBatchNorm2d(network, weights, *conv1->getOutput(0), WeightName(lname, ".bn"), 1e-3);
 
     // silu = x * sigmoid
     auto sig = network->addActivation(*bn1->getOutput(0), ActivationType::kSIGMOID);
     assert(sig);
+    sig->setName(WeightName(lname, ".act.sigmoid"));
     auto ew = network->addElementWise(*bn1->getOutput(0), *sig->getOutput(0), ElementWiseOperation::kPROD);
     assert(ew);
+    ew->setName(WeightName(lname, ".act"));
     return ew;
 }
 
-ILayer* bottleneck(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, 
-    int c1, int c2, bool shortcut, int g, float e, std::string lname)
+ILayer* bottleneck(INetworkDefinition *network, WeightStore& weights, ITensor& input, 
+    int c1, int c2, bool shortcut, int g, float e, const char* lname)
 {
-    auto cv1 = convBlock(network, weightMap, input, (int)((float)c2 * e), 1, 1, 1, lname + ".cv1");
-    auto cv2 = convBlock(network, weightMap, *cv1->getOutput(0), c2, 3, 1, g, lname + ".cv2");
+    auto cv1 = convBlock(network, weights, input, (int)((float)c2 * e), 1, 1, 1, WeightName(lname, ".cv1"));
+    auto cv2 = convBlock(network, weights, *cv1->getOutput(0), c2, 3, 1, g, WeightName(lname, ".cv2"));
     if (shortcut && c1 == c2) {
-        auto ew = network->addElementWise(input, *cv2->getOutput(0), ElementWiseOperation::kSUM);
+        ITensor* x = &input;
+        WeightName addScale(lname, ".add_input_scale");
+        if (weights.contains(addScale)) {
+            x = addQuantDequant(network, weights, input, addScale, 0);
+        }
+        auto ew = network->addElementWise(*x, *cv2->getOutput(0), ElementWiseOperation::kSUM);
+        ew->setName(WeightName(lname, ".add"));
         return ew;
     }
     return cv2;
 }
 
-ILayer* bottleneckCSP(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, 
-    int c1, int c2, int n, bool shortcut, int g, float e, std::string lname)
+ILayer* bottleneckCSP(INetworkDefinition *network, WeightStore& weights, ITensor& input, 
+    int c1, int c2, int n, bool shortcut, int g, float e, const char* lname)
 {
     Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
     int c_ = (int)((float)c2 * e);
-    auto cv1 = convBlock(network, weightMap, input, c_, 1, 1, 1, lname + ".cv1");
-    auto cv2 = network->addConvolutionNd(input, c_, DimsHW{ 1, 1 }, weightMap[lname + ".cv2.weight"], emptywts);
+    auto cv1 = convBlock(network, weights, input, c_, 1, 1, 1, WeightName(lname, ".cv1"));
+    auto cv2 = network->addConvolutionNd(input, c_, DimsHW{ 1, 1 }, weights.get(WeightName(lname, ".cv2.weight")), emptywts);
     ITensor *y1 = cv1->getOutput(0);
     for (int i = 0; i < n; i++) {
-        auto b = bottleneck(network, weightMap, *y1, c_, c_, shortcut, g, 1.0, lname + ".m." + std::to_string(i));
+        auto b = bottleneck(network, weights, *y1, c_, c_, shortcut, g, 1.0, WeightName(lname, ".m.", i));
         y1 = b->getOutput(0);
     }
-    auto cv3 = network->addConvolutionNd(*y1, c_, DimsHW{ 1, 1 }, weightMap[lname + ".cv3.weight"], emptywts);
+    auto cv3 = network->addConvolutionNd(*y1, c_, DimsHW{ 1, 1 }, weights.get(WeightName(lname, ".cv3.weight")), emptywts);
 
     ITensor* inputTensors[] = { cv3->getOutput(0), cv2->getOutput(0) };
     auto cat = network->addConcatenation(inputTensors, 2);
 
-    IScaleLayer* bn = addBatchNorm2d(network, weightMap, *cat->getOutput(0), lname + ".bn", 1e-4);
+    IScaleLayer* bn = addBatchNorm2d(network, weights, *cat->getOutput(0), WeightName(lname, ".bn"), 1e-4);
     auto lr = network->addActivation(*bn->getOutput(0), ActivationType::kLEAKY_RELU);
     lr->setAlpha(0.1);
 
-    auto cv4 = convBlock(network, weightMap, *lr->getOutput(0), c2, 1, 1, 1, lname + ".cv4");
+    auto cv4 = convBlock(network, weights, *lr->getOutput(0), c2, 1, 1, 1, WeightName(lname, ".cv4"));
     return cv4;
 }
 
-ILayer* C3(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, 
-    int c1, int c2, int n, bool shortcut, int g, float e, std::string lname)
+ILayer* C3(INetworkDefinition *network, WeightStore& weights, ITensor& input, 
+    int c1, int c2, int n, bool shortcut, int g, float e, const char* lname)
 {
     int c_ = (int)((float)c2 * e);
-    auto cv1 = convBlock(network, weightMap, input, c_, 1, 1, 1, lname + ".cv1");
-    auto cv2 = convBlock(network, weightMap, input, c_, 1, 1, 1, lname + ".cv2");
+    auto cv1 = convBlock(network, weights, input, c_, 1, 1, 1, WeightName(lname, ".cv1"));
+    auto cv2 = convBlock(network, weights, input, c_, 1, 1, 1, WeightName(lname, ".cv2"));
     ITensor *y1 = cv1->getOutput(0);
     for (int i = 0; i < n; i++) {
-        auto b = bottleneck(network, weightMap, *y1, c_, c_, shortcut, g, 1.0, lname + ".m." + std::to_string(i));
+        auto b = bottleneck(network, weights, *y1, c_, c_, shortcut, g, 1.0, WeightName(lname, ".m.", i));
         y1 = b->getOutput(0);
     }
 
     ITensor* inputTensors[] = { y1, cv2->getOutput(0) };
     auto cat = network->addConcatenation(inputTensors, 2);
+    cat->setName(WeightName(lname, ".cat"));
 
-    auto cv3 = convBlock(network, weightMap, *cat->getOutput(0), c2, 1, 1, 1, lname + ".cv3");
+    auto cv3 = convBlock(network, weights, *cat->getOutput(0), c2, 1, 1, 1, WeightName(lname, ".cv3"));
     return cv3;
 }
 
-ILayer* SPPF(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, 
-    int c1, int c2, int k, std::string lname)
+ILayer* SPPF(INetworkDefinition *network, WeightStore& weights, ITensor& input, 
+    int c1, int c2, int k, const char* lname)
 {
     int c_ = c1 / 2;
-    auto cv1 = convBlock(network, weightMap, input, c_, 1, 1, 1, lname + ".cv1");
-
-    auto pool1 = network->addPoolingNd(*cv1->getOutput(0), PoolingType::kMAX, DimsHW{ k, k });
-    pool1->setPaddingNd(DimsHW{ k / 2, k / 2 });
-    pool1->setStrideNd(DimsHW{ 1, 1 });
-
-    auto pool2 = network->addPoolingNd(*pool1->getOutput(0), PoolingType::kMAX, DimsHW{ k, k });
-    pool2->setPaddingNd(DimsHW{ k / 2, k / 2 });
-    pool2->setStrideNd(DimsHW{ 1, 1 });
-
-    auto pool3 = network->addPoolingNd(*pool2->getOutput(0), PoolingType::kMAX, DimsHW{ k, k });
-    pool3->setPaddingNd(DimsHW{ k / 2, k / 2 });
-    pool3->setStrideNd(DimsHW{ 1, 1 });
-
-    ITensor* inputTensors[] = { cv1->getOutput(0), pool1->getOutput(0), pool2->getOutput(0), pool3->getOutput(0) };
-    auto cat = network->addConcatenation(inputTensors, 4);
+    auto cv1 = convBlock(network, weights, input, c_, 1, 1, 1, WeightName(lname, ".cv1"));
+
+    auto creator = getPluginRegistry()->getPluginCreator("SppfLayer_TRT", "1");
+    PluginField plugin_fields[1];
+    plugin_fields[0].data = &k;
+    plugin_fields[0].length = 1;
+    plugin_fields[0].name = "kernel";
+    plugin_fields[0].type = PluginFieldType::kINT32;
+    PluginFieldCollection plugin_data;
+    plugin_data.nbFields = 1;
+    plugin_data.fields = plugin_fields;
+    IPluginV2 *plugin_obj = creator->createPlugin("sppflayer", &plugin_data);
+    ITensor* inputTensors[] = { cv1->getOutput(0) };
+    auto pool = network->addPluginV2(inputTensors, 1, *plugin_obj);
+    pool->setName(WeightName(lname, ".pool"));
 
-    auto cv2 = convBlock(network, weightMap, *cat->getOutput(0), c2, 1, 1, 1, lname + ".cv2");
+    auto cv2 = convBlock(network, weights, *pool->getOutput(0), c2, 1, 1, 1, WeightName(lname, ".cv2"));
     return cv2;
 }
 
-std::vector<std::vector<float>> getAnchors(std::map<std::string, Weights>& weightMap, std::string lname)
+std::vector<std::vector<float>> getAnchors(WeightStore& weights, const char* lname)
 {
     std::vector<std::vector<float>> anchors;
-    Weights wts = weightMap[lname + ".anchor_grid"];
+    Weights wts = weights.get(WeightName(lname, ".anchor_grid"));
     int anchor_len = Yolo::CHECK_COUNT * 2;
     for (int i = 0; i < wts.count / anchor_len; i++) {
         auto *p = (const float*)wts.values + i * anchor_len;
@@ -215,26 +244,30 @@ std::vector<std::vector<float>> getAnchors(std::map<std::string, Weights>& weigh
     return anchors;
 }
 
-IPluginV2Layer* addYoLoLayer(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, 
-    std::string lname, std::vector<IConvolutionLayer*> dets)
+// The plugin takes the network size from the input tensor and the grid of
+// each scale from its detect conv, so P5 and P6 models at any input size
+// decode at their own strides
+IPluginV2Layer* addYoLoLayer(INetworkDefinition *network, WeightStore& weights, 
+    const char* lname, const std::vector<IConvolutionLayer*>& dets)
 {
     auto creator = getPluginRegistry()->getPluginCreator("YoloLayer_TRT", "1");
-    auto anchors = getAnchors(weightMap, lname);
+    auto anchors = getAnchors(weights, lname);
+    assert(anchors.size() == dets.size());
+    Dims inputDims = network->getInput(0)->getDimensions();
     PluginField plugin_fields[2];
-    int netinfo[4] = {Yolo::CLASS_NUM, Yolo::INPUT_W, Yolo::INPUT_H, Yolo::MAX_OUTPUT_BBOX_COUNT};
+    int netinfo[4] = {Yolo::CLASS_NUM, inputDims.d[2], inputDims.d[1], Yolo::MAX_OUTPUT_BBOX_COUNT};
     plugin_fields[0].data = netinfo;
     plugin_fields[0].length = 4;
     plugin_fields[0].name = "netinfo";
     plugin_fields[0].type = PluginFieldType::kFLOAT32;
-    int scale = 8;
     std::vector<Yolo::YoloKernel> kernels;
     for (size_t i = 0; i < anchors.size(); i++) {
+        Dims gridDims = dets[i]->getOutput(0)->getDimensions();
         Yolo::YoloKernel kernel;
-        kernel.width = Yolo::INPUT_W / scale;
-        kernel.height = Yolo::INPUT_H / scale;
+        kernel.width = gridDims.d[2];
+        kernel.height = gridDims.d[1];
         memcpy(kernel.anchors, &anchors[i][0], anchors[i].size() * sizeof(float));
         kernels.push_back(kernel);
-        scale *= 2;
     }
     plugin_fields[1].data = &kernels[0];
     plugin_fields[1].length = kernels.size();
@@ -249,6 +282,7 @@ IPluginV2Layer* addYoLoLayer(INetworkDefinition *network, std::map<std::string,
         input_tensors.push_back(det->getOutput(0));
     }
     auto yolo = network->addPluginV2(&input_tensors[0], input_tensors.size(), *plugin_obj);
+    yolo->setName(WeightName(lname, ".yolo"));
     return yolo;
 }
 
@@ -0,0 +1,132 @@
+#include "custom_config.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool CustomConfig::load(const std::string& filePath)
+{
+    std::ifstream input(filePath);
+    if (!input.is_open()) {
+        std::cerr << "Unable to open custom config file: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string line, section;
+    int lineNum = 0;
+    while (std::getline(input, line)) {
+        lineNum++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = trimString(line);
+        if (line.empty()) {
+            continue;
+        }
+        if (line.front() == '[' && line.back() == ']') {
+            section = trimString(line.substr(1, line.size() - 2));
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Invalid line " << lineNum << " in custom config file: "
+                      << filePath << std::endl;
+            return false;
+        }
+        m_Sections[section][trimString(line.substr(0, eq))] = trimString(line.substr(eq + 1));
+    }
+    return true;
+}
+
+bool CustomConfig::hasKey(const std::string& section, const std::string& key) const
+{
+    auto s = m_Sections.find(section);
+    return s != m_Sections.end() && s->second.count(key) != 0;
+}
+
+std::string CustomConfig::getString(const std::string& section, const std::string& key,
+    const std::string& defaultValue) const
+{
+    auto s = m_Sections.find(section);
+    if (s == m_Sections.end()) {
+        return defaultValue;
+    }
+    auto k = s->second.find(key);
+    return k == s->second.end() ? defaultValue : k->second;
+}
+
+int CustomConfig::getInt(const std::string& section, const std::string& key, int defaultValue) const
+{
+    std::string value = getString(section, key);
+    return value.empty() ? defaultValue : std::atoi(value.c_str());
+}
+
+float CustomConfig::getFloat(const std::string& section, const std::string& key, float defaultValue) const
+{
+    std::string value = getString(section, key);
+    return value.empty() ? defaultValue : std::atof(value.c_str());
+}
+
+bool CustomConfig::getBool(const std::string& section, const std::string& key, bool defaultValue) const
+{
+    std::string value = getString(section, key);
+    if (value.empty()) {
+        return defaultValue;
+    }
+    return value == "1" || value == "true";
+}
+
+std::vector<std::string> CustomConfig::getKeys(const std::string& section) const
+{
+    std::vector<std::string> keys;
+    auto s = m_Sections.find(section);
+    if (s != m_Sections.end()) {
+        for (const auto& kv : s->second) {
+            keys.push_back(kv.first);
+        }
+    }
+    return keys;
+}
+
+static CustomConfig loadCustomConfig()
+{
+    CustomConfig config;
+    const char* path = std::getenv("YOLOV5_CUSTOM_CONFIG");
+    if (path && *path) {
+        std::cout << "Loading custom config: " << path << std::endl;
+        config.load(path);
+    }
+    return config;
+}
+
+const CustomConfig& getCustomConfig()
+{
+    static const CustomConfig config = loadCustomConfig();
+    return config;
+}
+
+std::string trimString(const std::string& s)
+{
+    const char* whitespace = " \t\r\n\f\v";
+    size_t first = s.find_first_not_of(whitespace);
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    return s.substr(first, s.find_last_not_of(whitespace) - first + 1);
+}
+
+std::vector<std::string> splitString(const std::string& s, char delimiter)
+{
+    std::vector<std::string> tokens;
+    std::stringstream ss(s);
+    std::string token;
+    while (std::getline(ss, token, delimiter)) {
+        token = trimString(token);
+        if (!token.empty()) {
+            tokens.push_back(token);
+        }
+    }
+    return tokens;
+}
@@ -0,0 +1,42 @@
+#ifndef _CUSTOM_CONFIG_H_
+#define _CUSTOM_CONFIG_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Optional settings of the custom library, read from the file named by the
+ * YOLOV5_CUSTOM_CONFIG environment variable. The format is a plain ini file:
+ *
+ *   [section]
+ *   key=value   # comment
+ *
+ * Every feature configured here is disabled when the file or key is absent.
+ */
+class CustomConfig {
+public:
+    bool load(const std::string& filePath);
+
+    bool hasKey(const std::string& section, const std::string& key) const;
+    std::string getString(const std::string& section, const std::string& key,
+        const std::string& defaultValue = "") const;
+    int getInt(const std::string& section, const std::string& key, int defaultValue = 0) const;
+    float getFloat(const std::string& section, const std::string& key, float defaultValue = 0.F) const;
+    bool getBool(const std::string& section, const std::string& key, bool defaultValue = false) const;
+    std::vector<std::string> getKeys(const std::string& section) const;
+
+private:
+    std::map<std::string, std::map<std::string, std::string>> m_Sections;
+};
+
+// Loaded once per process on first use
+const CustomConfig& getCustomConfig();
+
+// Leading and trailing whitespace removed. Kept here rather than using trim()
+// of trt_utils so the CPU-only tools do not link TensorRT.
+std::string trimString(const std::string& s);
+
+std::vector<std::string> splitString(const std::string& s, char delimiter);
+
+#endif // _CUSTOM_CONFIG_H_
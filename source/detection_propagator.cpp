@@ -0,0 +1,153 @@
+#include "detection_propagator.h"
+#include "box_utils.h"
+#include "custom_config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Keeps the default, with a warning, when the configured value is out of range
+template<typename T>
+static void setIfValid(T& param, const char* key, T value, bool valid, const char* range)
+{
+    if (!valid) {
+        std::cerr << "Ignoring [propagation] " << key << "=" << value << ", must be " << range << std::endl;
+        return;
+    }
+    param = value;
+}
+
+PropagationParams loadPropagationParams(const CustomConfig& config)
+{
+    PropagationParams params;
+    // A decay above 1 would grow the confidence of objects no longer seen
+    float decay = config.getFloat("propagation", "confidence-decay", params.confidenceDecay);
+    setIfValid(params.confidenceDecay, "confidence-decay", decay, decay > 0.F && decay <= 1.F, "in (0, 1]");
+    float minConfidence = config.getFloat("propagation", "min-confidence", params.minConfidence);
+    setIfValid(params.minConfidence, "min-confidence", minConfidence,
+        minConfidence >= 0.F && minConfidence <= 1.F, "in [0, 1]");
+    int maxFrames = config.getInt("propagation", "max-frames", params.maxFrames);
+    setIfValid(params.maxFrames, "max-frames", maxFrames, maxFrames >= 0, "at least 0");
+    // At 0 any two boxes of a class would continue a track, overlapping or not
+    float matchIoU = config.getFloat("propagation", "match-iou", params.matchIoU);
+    setIfValid(params.matchIoU, "match-iou", matchIoU, matchIoU > 0.F && matchIoU <= 1.F, "in (0, 1]");
+    float smoothing = config.getFloat("propagation", "velocity-smoothing", params.velocitySmoothing);
+    setIfValid(params.velocitySmoothing, "velocity-smoothing", smoothing,
+        smoothing >= 0.F && smoothing <= 1.F, "in [0, 1]");
+    return params;
+}
+
+DetectionPropagator::DetectionPropagator(const PropagationParams& params)
+    : m_Params(params)
+{
+}
+
+NvDsInferParseObjectInfo DetectionPropagator::predict(const Track& track, int64_t frameNum) const
+{
+    float dt = (float)(frameNum - track.frameNum);
+    NvDsInferParseObjectInfo b = track.box;
+    float cx = b.left + b.width * 0.5F + track.vx * dt;
+    float cy = b.top + b.height * 0.5F + track.vy * dt;
+    b.width = std::max(b.width + track.vw * dt, 1.F);
+    b.height = std::max(b.height + track.vh * dt, 1.F);
+    b.left = cx - b.width * 0.5F;
+    b.top = cy - b.height * 0.5F;
+    return b;
+}
+
+void DetectionPropagator::update(int sourceId, int64_t frameNum,
+    const std::vector<NvDsInferParseObjectInfo>& objects)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<Track>& tracks = m_Sources[sourceId];
+
+    // Candidate pairs of previous track and new detection, best IoU first
+    struct Candidate
+    {
+        float iou;
+        int track;
+        int object;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t t = 0; t < tracks.size(); t++) {
+        if (frameNum <= tracks[t].frameNum) {
+            continue;
+        }
+        NvDsInferParseObjectInfo predicted = predict(tracks[t], frameNum);
+        for (size_t o = 0; o < objects.size(); o++) {
+            if (objects[o].classId != predicted.classId) {
+                continue;
+            }
+            float iou = boxIoU(predicted, objects[o]);
+            if (iou >= m_Params.matchIoU) {
+                candidates.push_back({ iou, (int)t, (int)o });
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.iou > b.iou; });
+
+    std::vector<int> matchOf(objects.size(), -1);
+    std::vector<bool> trackUsed(tracks.size(), false);
+    for (const Candidate& c : candidates) {
+        if (trackUsed[c.track] || matchOf[c.object] >= 0) {
+            continue;
+        }
+        trackUsed[c.track] = true;
+        matchOf[c.object] = c.track;
+    }
+
+    // The detector is authoritative on inferred frames: unmatched tracks end
+    std::vector<Track> next(objects.size());
+    const float s = m_Params.velocitySmoothing;
+    for (size_t o = 0; o < objects.size(); o++) {
+        Track& track = next[o];
+        const NvDsInferParseObjectInfo& b = objects[o];
+        track.box = b;
+        track.frameNum = frameNum;
+        if (matchOf[o] < 0) {
+            continue;
+        }
+        const Track& prev = tracks[matchOf[o]];
+        float dt = (float)(frameNum - prev.frameNum);
+        const NvDsInferParseObjectInfo& p = prev.box;
+        float vx = ((b.left + b.width * 0.5F) - (p.left + p.width * 0.5F)) / dt;
+        float vy = ((b.top + b.height * 0.5F) - (p.top + p.height * 0.5F)) / dt;
+        float vw = (b.width - p.width) / dt;
+        float vh = (b.height - p.height) / dt;
+        track.vx = s * vx + (1.F - s) * prev.vx;
+        track.vy = s * vy + (1.F - s) * prev.vy;
+        track.vw = s * vw + (1.F - s) * prev.vw;
+        track.vh = s * vh + (1.F - s) * prev.vh;
+    }
+    tracks.swap(next);
+}
+
+void DetectionPropagator::propagate(int sourceId, int64_t frameNum,
+    std::vector<NvDsInferParseObjectInfo>& objects) const
+{
+    objects.clear();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Sources.find(sourceId);
+    if (it == m_Sources.end()) {
+        return;
+    }
+    for (const Track& track : it->second) {
+        int64_t dt = frameNum - track.frameNum;
+        if (dt < 0 || dt > m_Params.maxFrames) {
+            continue;
+        }
+        NvDsInferParseObjectInfo b = predict(track, frameNum);
+        b.detectionConfidence *= std::pow(m_Params.confidenceDecay, (float)dt);
+        if (b.detectionConfidence < m_Params.minConfidence) {
+            continue;
+        }
+        objects.push_back(b);
+    }
+}
+
+void DetectionPropagator::removeSource(int sourceId)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Sources.erase(sourceId);
+}
@@ -0,0 +1,69 @@
+#ifndef _DETECTION_PROPAGATOR_H_
+#define _DETECTION_PROPAGATOR_H_
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "nvdsinfer.h"
+
+class CustomConfig;
+
+struct PropagationParams
+{
+    // Confidence multiplier per propagated frame, in (0, 1]
+    float confidenceDecay = 0.9F;
+    // Propagated objects below this confidence are dropped
+    float minConfidence = 0.2F;
+    // Frames an object is carried past the last inferred frame
+    int maxFrames = 4;
+    // IoU a detection needs with a track's prediction to continue the track
+    float matchIoU = 0.3F;
+    // Weight of the newest measurement in the velocity moving average, in [0, 1]
+    float velocitySmoothing = 0.5F;
+};
+
+// Out of range values are reported and keep their defaults
+PropagationParams loadPropagationParams(const CustomConfig& config);
+
+/**
+ * Carries detections over the frames skipped by nvinfer's interval. Every
+ * inferred frame updates per-source tracks: detections are matched to the
+ * constant-velocity predictions of the previous ones (greedy, class-aware,
+ * by IoU) and the center and size velocities are smoothed. On a skipped
+ * frame the tracks are moved by their velocities and their confidence
+ * decays per frame, which keeps recall up with interval=2..4 for well under a
+ * microsecond per frame.
+ */
+class DetectionPropagator {
+public:
+    explicit DetectionPropagator(const PropagationParams& params);
+
+    // Inferred frame, objects are the parsed detections of the frame
+    void update(int sourceId, int64_t frameNum, const std::vector<NvDsInferParseObjectInfo>& objects);
+
+    // Skipped frame, returns the predicted objects for frameNum
+    void propagate(int sourceId, int64_t frameNum, std::vector<NvDsInferParseObjectInfo>& objects) const;
+
+    void removeSource(int sourceId);
+
+private:
+    struct Track
+    {
+        NvDsInferParseObjectInfo box;
+        // Center and size change per frame
+        float vx = 0.F;
+        float vy = 0.F;
+        float vw = 0.F;
+        float vh = 0.F;
+        int64_t frameNum = 0;
+    };
+
+    NvDsInferParseObjectInfo predict(const Track& track, int64_t frameNum) const;
+
+    PropagationParams m_Params;
+    mutable std::mutex m_Mutex;
+    std::map<int, std::vector<Track>> m_Sources;
+};
+
+#endif // _DETECTION_PROPAGATOR_H_
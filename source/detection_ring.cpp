@@ -0,0 +1,216 @@
+#include "detection_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+static constexpr uint32_t RING_MAGIC = 0x59354452; // "Y5DR"
+// 2: empty frames are exported as a record with numObjects 0
+// 3: frameSeq counter in the header
+static constexpr uint32_t RING_VERSION = 3;
+
+// A producer of the previous lap holding a slot this long died mid-push, and
+// the slot is taken over. Only a producer descheduled this long between its
+// claim and its publish could still tear a record.
+static constexpr std::chrono::milliseconds STUCK_WRITER_TIMEOUT(100);
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared-memory ring needs lock-free 64-bit atomics");
+
+static size_t ringMapSize(uint64_t capacity)
+{
+    return sizeof(DetectionRingHeader) + capacity * sizeof(DetectionRingSlot);
+}
+
+static void* mapRing(int fd, size_t size, int prot)
+{
+    void* addr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+
+DetectionRingProducer::~DetectionRingProducer()
+{
+    if (m_Header) {
+        munmap(m_Header, m_MapSize);
+    }
+}
+
+bool DetectionRingProducer::create(const std::string& name, uint64_t capacity, mode_t mode)
+{
+    uint64_t cap = 1;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, mode);
+    if (fd < 0) {
+        std::cerr << "Unable to open shared memory: " << name << std::endl;
+        return false;
+    }
+    // shm_open applies the umask and leaves an existing object alone. Fails
+    // when another user owns the ring, whose permissions then stay.
+    fchmod(fd, mode);
+    size_t size = ringMapSize(cap);
+    struct stat st;
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != size;
+    if (fresh && ftruncate(fd, size) != 0) {
+        std::cerr << "Unable to size shared memory: " << name << std::endl;
+        close(fd);
+        return false;
+    }
+    void* addr = mapRing(fd, size, PROT_READ | PROT_WRITE);
+    close(fd);
+    if (!addr) {
+        std::cerr << "Unable to map shared memory: " << name << std::endl;
+        return false;
+    }
+
+    m_Name = name;
+    m_Header = static_cast<DetectionRingHeader*>(addr);
+    m_Slots = reinterpret_cast<DetectionRingSlot*>(m_Header + 1);
+    m_MapSize = size;
+    if (fresh || m_Header->magic != RING_MAGIC || m_Header->version != RING_VERSION ||
+        m_Header->capacity != cap) {
+        memset(addr, 0, size);
+        m_Header->capacity = cap;
+        m_Header->version = RING_VERSION;
+        m_Header->head.store(0, std::memory_order_relaxed);
+        m_Header->frameSeq.store(0, std::memory_order_relaxed);
+        // Consumers check the magic last
+        std::atomic_thread_fence(std::memory_order_release);
+        m_Header->magic = RING_MAGIC;
+    }
+    return true;
+}
+
+void DetectionRingProducer::push(const DetectionRecord& record)
+{
+    const uint64_t capacity = m_Header->capacity;
+    uint64_t pos = m_Header->head.fetch_add(1, std::memory_order_acq_rel);
+    DetectionRingSlot& slot = m_Slots[pos & (capacity - 1)];
+    const uint64_t claimed = 2 * pos + 1;
+    // Free once the producer of the previous lap has published it. A producer
+    // a lap behind that is still writing is waited for, else both copies
+    // would interleave into a record that passes the consumer's check.
+    const uint64_t published = pos < capacity ? 0 : 2 * (pos - capacity) + 2;
+    std::chrono::steady_clock::time_point deadline;
+    bool waiting = false;
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    while (true) {
+        if (seq >= claimed) {
+            // Taken over by a later lap while this producer stalled
+            return;
+        }
+        if (seq == published || (waiting && std::chrono::steady_clock::now() > deadline)) {
+            if (slot.seq.compare_exchange_weak(seq, claimed, std::memory_order_acquire,
+                    std::memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+        if (!waiting) {
+            deadline = std::chrono::steady_clock::now() + STUCK_WRITER_TIMEOUT;
+            waiting = true;
+        }
+        std::this_thread::yield();
+        seq = slot.seq.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record = record;
+    // Fails only when a later lap took the slot over, its record wins
+    uint64_t expected = claimed;
+    slot.seq.compare_exchange_strong(expected, claimed + 1, std::memory_order_release,
+        std::memory_order_relaxed);
+}
+
+uint64_t DetectionRingProducer::nextFrameSeq()
+{
+    return m_Header->frameSeq.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DetectionRingProducer::unlink()
+{
+    if (!m_Name.empty()) {
+        shm_unlink(m_Name.c_str());
+    }
+}
+
+DetectionRingConsumer::~DetectionRingConsumer()
+{
+    if (m_Header) {
+        munmap(m_Header, m_MapSize);
+    }
+}
+
+bool DetectionRingConsumer::open(const std::string& name, bool fromOldest)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DetectionRingHeader)) {
+        close(fd);
+        return false;
+    }
+    void* addr = mapRing(fd, st.st_size, PROT_READ);
+    close(fd);
+    if (!addr) {
+        return false;
+    }
+
+    DetectionRingHeader* header = static_cast<DetectionRingHeader*>(addr);
+    if (header->magic != RING_MAGIC || header->version != RING_VERSION ||
+        ringMapSize(header->capacity) != (size_t)st.st_size) {
+        munmap(addr, st.st_size);
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    m_Header = header;
+    m_Slots = reinterpret_cast<DetectionRingSlot*>(header + 1);
+    m_MapSize = st.st_size;
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    m_Next = (fromOldest && head > header->capacity) ? head - header->capacity
+                                                      : (fromOldest ? 0 : head);
+    m_Lost = 0;
+    return true;
+}
+
+int DetectionRingConsumer::pop(DetectionRecord* records, int maxRecords)
+{
+    const uint64_t capacity = m_Header->capacity;
+    uint64_t head = m_Header->head.load(std::memory_order_acquire);
+    if (head - m_Next > capacity) {
+        m_Lost += head - capacity - m_Next;
+        m_Next = head - capacity;
+    }
+
+    int count = 0;
+    while (count < maxRecords && m_Next < head) {
+        DetectionRingSlot& slot = m_Slots[m_Next & (capacity - 1)];
+        const uint64_t expected = 2 * m_Next + 2;
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq < expected) {
+            // Claimed but not published yet
+            break;
+        }
+        if (seq == expected) {
+            records[count] = slot.record;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == expected) {
+                count++;
+                m_Next++;
+                continue;
+            }
+        }
+        // Overwritten by a producer one lap ahead
+        m_Lost++;
+        m_Next++;
+    }
+    return count;
+}
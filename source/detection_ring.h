@@ -0,0 +1,108 @@
+#ifndef _DETECTION_RING_H_
+#define _DETECTION_RING_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <atomic>
+#include <string>
+
+/**
+ * Binary detection export through a POSIX shared-memory ring. Producers
+ * take positions with a fetch_add on the head and publish each slot with a
+ * per-slot sequence number (odd while being written). A producer claims its
+ * slot with a CAS from the sequence the previous lap published, so two laps
+ * never write one slot at once, and any number of producers and independent
+ * consumers work without locks. A consumer that falls more than one ring
+ * behind skips ahead and counts the overrun.
+ */
+struct DetectionRecord
+{
+    uint64_t frameSeq;
+    uint32_t sourceId;
+    uint16_t classId;
+    // Position of this object among the numObjects of its frame
+    uint16_t objectIndex;
+    // A frame without objects is exported as one record with numObjects 0
+    // and no box, so every frameSeq reaches the ring and a gap in frameSeq
+    // always means lost records
+    uint16_t numObjects;
+    uint16_t reserved;
+    float left;
+    float top;
+    float width;
+    float height;
+    float confidence;
+};
+
+static_assert(sizeof(DetectionRecord) == 40, "DetectionRecord layout is part of the ring ABI");
+
+struct DetectionRingSlot
+{
+    std::atomic<uint64_t> seq;
+    DetectionRecord record;
+};
+
+struct alignas(64) DetectionRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> head;
+    // Next DetectionRecord::frameSeq, kept here so a producer that reattaches
+    // carries on instead of repeating frame numbers
+    alignas(64) std::atomic<uint64_t> frameSeq;
+};
+
+class DetectionRingProducer {
+public:
+    DetectionRingProducer() = default;
+    ~DetectionRingProducer();
+
+    // Creates or reuses the shared-memory object with the given permissions;
+    // capacity is rounded up to a power of two
+    bool create(const std::string& name, uint64_t capacity, mode_t mode = 0600);
+    void push(const DetectionRecord& record);
+    // Frame sequence for the next frame, shared by all producers of the ring
+    uint64_t nextFrameSeq();
+    // Removes the shared-memory name, mappings stay valid until closed
+    void unlink();
+
+    bool isOpen() const { return m_Header != nullptr; }
+
+private:
+    DetectionRingProducer(const DetectionRingProducer&) = delete;
+    DetectionRingProducer& operator=(const DetectionRingProducer&) = delete;
+
+    std::string m_Name;
+    DetectionRingHeader* m_Header = nullptr;
+    DetectionRingSlot* m_Slots = nullptr;
+    size_t m_MapSize = 0;
+};
+
+class DetectionRingConsumer {
+public:
+    DetectionRingConsumer() = default;
+    ~DetectionRingConsumer();
+
+    // Attaches read-only to an existing ring, reading from the oldest record
+    // still in the ring or only from records published after opening
+    bool open(const std::string& name, bool fromOldest = false);
+    // Copies up to maxRecords published records, returns the number copied
+    int pop(DetectionRecord* records, int maxRecords);
+
+    // Records overwritten before this consumer read them
+    uint64_t getLost() const { return m_Lost; }
+    bool isOpen() const { return m_Header != nullptr; }
+
+private:
+    DetectionRingConsumer(const DetectionRingConsumer&) = delete;
+    DetectionRingConsumer& operator=(const DetectionRingConsumer&) = delete;
+
+    DetectionRingHeader* m_Header = nullptr;
+    DetectionRingSlot* m_Slots = nullptr;
+    size_t m_MapSize = 0;
+    uint64_t m_Next = 0;
+    uint64_t m_Lost = 0;
+};
+
+#endif // _DETECTION_RING_H_
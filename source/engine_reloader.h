@@ -0,0 +1,163 @@
+#ifndef _ENGINE_RELOADER_H_
+#define _ENGINE_RELOADER_H_
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "file_watcher.h"
+
+/**
+ * Zero-downtime model reload. A background thread watches the model file;
+ * on a settled change it builds (or deserializes) a new engine while the
+ * current one keeps serving. The new engine becomes pending and is swapped
+ * in by the next acquire(), i.e. between batches.
+ *
+ * acquire() hands out shared ownership of the active engine, so a batch in
+ * flight keeps the engine it started on alive; the old engine is released
+ * when its last batch drops its reference. Engine is any type, which keeps
+ * the state machine usable with a fake engine.
+ */
+template <typename Engine>
+class EngineReloader {
+public:
+    typedef std::function<std::shared_ptr<Engine>(const std::string& modelPath)> BuildFunc;
+
+    enum class State { kIdle, kBuilding, kPending, kFailed };
+
+    EngineReloader(const std::string& modelPath, BuildFunc build, int pollIntervalMs = 1000)
+        : m_Watcher(modelPath),
+          m_Build(build),
+          m_PollInterval(pollIntervalMs)
+    {
+    }
+
+    ~EngineReloader() { stop(); }
+
+    // Builds the first engine synchronously and starts watching
+    bool start()
+    {
+        std::shared_ptr<Engine> engine = m_Build(m_Watcher.getFilePath());
+        if (!engine) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Active = engine;
+            m_Version = 1;
+        }
+        m_Stop = false;
+        m_Thread = std::thread(&EngineReloader::run, this);
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wakeup.notify_all();
+        if (m_Thread.joinable()) {
+            m_Thread.join();
+        }
+    }
+
+    // Call at a batch boundary, hold the result for the batch's lifetime
+    std::shared_ptr<Engine> acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Pending) {
+            m_Active.swap(m_Pending);
+            m_Pending.reset();
+            m_Version++;
+            // A rebuild may already be running again, leave its state alone
+            if (m_State == State::kPending) {
+                m_State = State::kIdle;
+            }
+        }
+        return m_Active;
+    }
+
+    // Checks the file once and rebuilds on change, on the calling thread;
+    // start() runs this periodically on the watch thread. Calls from other
+    // threads are serialized with the watch thread.
+    void checkNow()
+    {
+        std::lock_guard<std::mutex> check(m_CheckMutex);
+        if (!m_Watcher.poll()) {
+            return;
+        }
+        setState(State::kBuilding);
+        std::cout << "Model file changed, rebuilding engine: "
+                  << m_Watcher.getFilePath() << std::endl;
+        std::shared_ptr<Engine> engine = m_Build(m_Watcher.getFilePath());
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (engine) {
+            // A newer build replaces a pending one that was never acquired
+            m_Pending = engine;
+            m_State = State::kPending;
+        } else {
+            std::cerr << "Rebuilding engine failed, keeping the current one" << std::endl;
+            m_State = State::kFailed;
+        }
+    }
+
+    uint64_t getVersion() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Version;
+    }
+
+    State getState() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_State;
+    }
+
+private:
+    void setState(State state)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_State = state;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (!m_Stop) {
+            m_Wakeup.wait_for(lock, m_PollInterval);
+            if (m_Stop) {
+                break;
+            }
+            lock.unlock();
+            checkNow();
+            lock.lock();
+        }
+    }
+
+    FileWatcher m_Watcher;
+    BuildFunc m_Build;
+    std::chrono::milliseconds m_PollInterval;
+
+    // Held for a whole checkNow(): the watcher state and the build
+    std::mutex m_CheckMutex;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Wakeup;
+    std::thread m_Thread;
+    bool m_Stop = false;
+
+    std::shared_ptr<Engine> m_Active;
+    std::shared_ptr<Engine> m_Pending;
+    uint64_t m_Version = 0;
+    State m_State = State::kIdle;
+};
+
+#endif // _ENGINE_RELOADER_H_
@@ -0,0 +1,40 @@
+#include "file_watcher.h"
+
+#include <sys/stat.h>
+
+FileWatcher::FileWatcher(const std::string& filePath)
+    : m_FilePath(filePath)
+{
+    m_Current = stat();
+}
+
+FileWatcher::Stamp FileWatcher::stat() const
+{
+    Stamp stamp;
+    struct stat st;
+    if (::stat(m_FilePath.c_str(), &st) == 0) {
+        stamp.exists = true;
+        stamp.mtimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        stamp.size = st.st_size;
+    }
+    return stamp;
+}
+
+bool FileWatcher::poll()
+{
+    Stamp now = stat();
+    if (now == m_Current) {
+        m_HasCandidate = false;
+        return false;
+    }
+    if (!m_HasCandidate || now != m_Candidate) {
+        // Changed since the last poll, wait for it to settle
+        m_Candidate = now;
+        m_HasCandidate = true;
+        return false;
+    }
+    m_Current = now;
+    m_HasCandidate = false;
+    // A removed file is not a new model
+    return now.exists;
+}
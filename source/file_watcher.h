@@ -0,0 +1,42 @@
+#ifndef _FILE_WATCHER_H_
+#define _FILE_WATCHER_H_
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Polls a file's modification time and size. A change is only reported once
+ * the file has stayed the same for one more poll, so a weights file that is
+ * still being copied is not picked up half written.
+ */
+class FileWatcher {
+public:
+    explicit FileWatcher(const std::string& filePath);
+
+    // Returns true once per settled change
+    bool poll();
+
+    const std::string& getFilePath() const { return m_FilePath; }
+
+private:
+    struct Stamp
+    {
+        bool exists = false;
+        int64_t mtimeNs = 0;
+        int64_t size = 0;
+
+        bool operator==(const Stamp& o) const {
+            return exists == o.exists && mtimeNs == o.mtimeNs && size == o.size;
+        }
+        bool operator!=(const Stamp& o) const { return !(*this == o); }
+    };
+
+    Stamp stat() const;
+
+    std::string m_FilePath;
+    Stamp m_Current;
+    Stamp m_Candidate;
+    bool m_HasCandidate = false;
+};
+
+#endif // _FILE_WATCHER_H_
@@ -0,0 +1,12 @@
+#ifndef _HOST_DEVICE_H_
+#define _HOST_DEVICE_H_
+
+// Marks the helpers a CUDA kernel shares with its host reference, so the CPU
+// tests and benches compiled with g++ run the same code as the kernel
+#ifdef __CUDACC__
+#define HOST_DEVICE __host__ __device__
+#else
+#define HOST_DEVICE
+#endif
+
+#endif // _HOST_DEVICE_H_
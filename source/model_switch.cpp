@@ -0,0 +1,83 @@
+#include "model_switch.h"
+#include "custom_config.h"
+
+#include <iostream>
+
+ModelSwitchParams loadModelSwitchParams(const CustomConfig& config)
+{
+    ModelSwitchParams params;
+    params.accurateModel = config.getString("model-switch", "accurate-model", params.accurateModel);
+    params.fastModel = config.getString("model-switch", "fast-model", params.fastModel);
+    params.latencyBudgetMs = config.getFloat("model-switch", "latency-budget-ms", params.latencyBudgetMs);
+    params.highQueueDepth = config.getInt("model-switch", "high-queue-depth", params.highQueueDepth);
+    params.lowQueueDepth = config.getInt("model-switch", "low-queue-depth", params.lowQueueDepth);
+    params.idleLatencyRatio = config.getFloat("model-switch", "idle-latency-ratio", params.idleLatencyRatio);
+
+    // A streak of less than one batch is met on every update and would switch
+    // each batch, without any hysteresis
+    int down = config.getInt("model-switch", "down-switch-batches", params.downSwitchBatches);
+    if (down < 1) {
+        std::cerr << "Ignoring [model-switch] down-switch-batches=" << down << ", must be at least 1"
+                  << std::endl;
+    } else {
+        params.downSwitchBatches = down;
+    }
+    int up = config.getInt("model-switch", "up-switch-batches", params.upSwitchBatches);
+    if (up < 1) {
+        std::cerr << "Ignoring [model-switch] up-switch-batches=" << up << ", must be at least 1"
+                  << std::endl;
+    } else {
+        params.upSwitchBatches = up;
+    }
+    float smoothing = config.getFloat("model-switch", "smoothing", params.smoothing);
+    if (!(smoothing > 0.F && smoothing <= 1.F)) {
+        std::cerr << "Ignoring [model-switch] smoothing=" << smoothing << ", must be in (0, 1]" << std::endl;
+    } else {
+        params.smoothing = smoothing;
+    }
+    return params;
+}
+
+ModelSwitchPolicy::ModelSwitchPolicy(const ModelSwitchParams& params)
+    : m_Params(params)
+{
+}
+
+const std::string& ModelSwitchPolicy::getActiveModel() const
+{
+    return m_Active == kFast ? m_Params.fastModel : m_Params.accurateModel;
+}
+
+ModelSwitchPolicy::Variant ModelSwitchPolicy::update(int queueDepth, float latencyMs)
+{
+    float& latency = m_Latency[m_Active];
+    latency = latency == 0.F ? latencyMs
+                             : m_Params.smoothing * latencyMs + (1.F - m_Params.smoothing) * latency;
+
+    bool candidate;
+    int needed;
+    if (m_Active == kAccurate) {
+        candidate = queueDepth >= m_Params.highQueueDepth || latency > m_Params.latencyBudgetMs;
+        needed = m_Params.downSwitchBatches;
+    } else {
+        candidate = queueDepth <= m_Params.lowQueueDepth &&
+            latency <= m_Params.idleLatencyRatio * m_Params.latencyBudgetMs;
+        needed = m_Params.upSwitchBatches;
+    }
+
+    m_Streak = candidate ? m_Streak + 1 : 0;
+    if (m_Streak >= needed) {
+        switchTo(m_Active == kAccurate ? kFast : kAccurate);
+    }
+    return m_Active;
+}
+
+void ModelSwitchPolicy::switchTo(Variant variant)
+{
+    m_Active = variant;
+    m_Streak = 0;
+    m_SwitchCount++;
+    // The stale average of the other variant would trigger an immediate
+    // switch back, start its measurement over
+    m_Latency[variant] = 0.F;
+}
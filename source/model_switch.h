@@ -0,0 +1,62 @@
+#ifndef _MODEL_SWITCH_H_
+#define _MODEL_SWITCH_H_
+
+#include <string>
+
+class CustomConfig;
+
+struct ModelSwitchParams
+{
+    std::string accurateModel = "yolov5m";
+    std::string fastModel = "yolov5s";
+    // Per-batch latency budget, e.g. one frame period at 30 FPS
+    float latencyBudgetMs = 33.3F;
+    // Queue depth at which the pipeline counts as overloaded
+    int highQueueDepth = 4;
+    // Queue depth at or below which the pipeline counts as idle
+    int lowQueueDepth = 1;
+    // Idle also requires the fast model to run below this share of the budget
+    float idleLatencyRatio = 0.5F;
+    // Consecutive batches a condition must hold before switching
+    int downSwitchBatches = 3;
+    int upSwitchBatches = 60;
+    // Weight of the newest sample in the latency moving average
+    float smoothing = 0.2F;
+};
+
+ModelSwitchParams loadModelSwitchParams(const CustomConfig& config);
+
+/**
+ * Chooses per batch between an accurate and a fast yolov5 variant whose
+ * engines are both loaded. The policy drops to the fast variant when the
+ * queue backs up or the accurate variant misses the latency budget, and
+ * goes back once the queue drains and the fast variant has plenty of
+ * headroom. Separate down/up batch counts give hysteresis against flapping.
+ */
+class ModelSwitchPolicy {
+public:
+    enum Variant { kAccurate = 0, kFast = 1 };
+
+    explicit ModelSwitchPolicy(const ModelSwitchParams& params);
+
+    // Feeds the queue depth and the measured latency of the last batch,
+    // which ran on the active variant; returns the variant for the next one
+    Variant update(int queueDepth, float latencyMs);
+
+    Variant getActive() const { return m_Active; }
+    const std::string& getActiveModel() const;
+    // Moving average latency of a variant, 0 before it has run
+    float getLatency(Variant variant) const { return m_Latency[variant]; }
+    int getSwitchCount() const { return m_SwitchCount; }
+
+private:
+    void switchTo(Variant variant);
+
+    ModelSwitchParams m_Params;
+    Variant m_Active = kAccurate;
+    float m_Latency[2] = { 0.F, 0.F };
+    int m_Streak = 0;
+    int m_SwitchCount = 0;
+};
+
+#endif // _MODEL_SWITCH_H_
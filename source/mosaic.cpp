@@ -0,0 +1,91 @@
+#include "mosaic.h"
+#include "box_utils.h"
+
+#include <cassert>
+#include <cmath>
+
+MosaicLayout::MosaicLayout(int numSources, float netWidth, float netHeight, int columns)
+    : m_NumSources(numSources)
+{
+    assert(numSources > 0 && netWidth > 0 && netHeight > 0);
+    if (columns <= 0) {
+        columns = (int)std::ceil(std::sqrt((float)numSources));
+    }
+    m_Columns = columns;
+    m_Rows = (numSources + columns - 1) / columns;
+    m_TileWidth = netWidth / m_Columns;
+    m_TileHeight = netHeight / m_Rows;
+
+    for (int i = 0; i < numSources; i++) {
+        TileRect tile;
+        tile.left = (i % m_Columns) * m_TileWidth;
+        tile.top = (i / m_Columns) * m_TileHeight;
+        tile.width = m_TileWidth;
+        tile.height = m_TileHeight;
+        m_Tiles.push_back(tile);
+    }
+}
+
+int MosaicLayout::findTile(float x, float y) const
+{
+    if (x < 0.F || y < 0.F) {
+        return -1;
+    }
+    int col = (int)(x / m_TileWidth);
+    int row = (int)(y / m_TileHeight);
+    if (col >= m_Columns || row >= m_Rows) {
+        return -1;
+    }
+    int id = row * m_Columns + col;
+    return id < m_NumSources ? id : -1;
+}
+
+int MosaicLayout::assign(NvDsInferParseObjectInfo& obj, float minInsideRatio) const
+{
+    float area = boxArea(obj);
+    if (area <= 0.F) {
+        return -1;
+    }
+    int id = findTile(obj.left + obj.width / 2.F, obj.top + obj.height / 2.F);
+    if (id < 0) {
+        return -1;
+    }
+
+    const TileRect& tile = m_Tiles[id];
+    NvDsInferParseObjectInfo clipped = obj;
+    clipBox(clipped, tile.left, tile.top, tile.width, tile.height);
+    if (boxArea(clipped) < minInsideRatio * area) {
+        // The box crosses into a neighbour tile
+        return -1;
+    }
+    obj = clipped;
+    return id;
+}
+
+void MosaicLayout::demux(const std::vector<NvDsInferParseObjectInfo>& objects,
+    std::vector<std::vector<NvDsInferParseObjectInfo>>& perSource, float minInsideRatio,
+    const std::vector<int>& sourceWidths, const std::vector<int>& sourceHeights) const
+{
+    perSource.assign(m_NumSources, std::vector<NvDsInferParseObjectInfo>());
+    for (const auto& object : objects) {
+        NvDsInferParseObjectInfo obj = object;
+        int id = assign(obj, minInsideRatio);
+        if (id < 0) {
+            continue;
+        }
+
+        const TileRect& tile = m_Tiles[id];
+        float sx = 1.F, sy = 1.F;
+        if ((size_t)id < sourceWidths.size() && sourceWidths[id] > 0) {
+            sx = sourceWidths[id] / tile.width;
+        }
+        if ((size_t)id < sourceHeights.size() && sourceHeights[id] > 0) {
+            sy = sourceHeights[id] / tile.height;
+        }
+        obj.left = (obj.left - tile.left) * sx;
+        obj.top = (obj.top - tile.top) * sy;
+        obj.width *= sx;
+        obj.height *= sy;
+        perSource[id].push_back(obj);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _MOSAIC_H_
+#define _MOSAIC_H_
+
+#include <vector>
+#include "box_utils.h"
+
+/**
+ * Geometry of a stream-packing mosaic: N low resolution sources are packed
+ * as a grid of equally sized tiles into one network input, in the same
+ * row-major order nvmultistreamtiler composes them. Boxes detected on the
+ * mosaic are assigned to the tile holding their center, clipped at the tile
+ * border, and dropped when too little of them lies inside that tile.
+ */
+class MosaicLayout {
+public:
+    MosaicLayout(int numSources, float netWidth, float netHeight, int columns = 0);
+
+    int getNumSources() const { return m_NumSources; }
+    int getColumns() const { return m_Columns; }
+    int getRows() const { return m_Rows; }
+    const TileRect& getTile(int sourceId) const { return m_Tiles[sourceId]; }
+
+    // Returns the source whose tile contains the point, -1 if none
+    int findTile(float x, float y) const;
+
+    // Clips the box to its tile and returns the tile index, or -1 when the
+    // box should be dropped
+    int assign(NvDsInferParseObjectInfo& obj, float minInsideRatio) const;
+
+    // Splits mosaic detections per source, in tile local coordinates scaled
+    // to each source's resolution. Sizes of 0 keep tile local coordinates.
+    void demux(const std::vector<NvDsInferParseObjectInfo>& objects,
+        std::vector<std::vector<NvDsInferParseObjectInfo>>& perSource, float minInsideRatio,
+        const std::vector<int>& sourceWidths = {}, const std::vector<int>& sourceHeights = {}) const;
+
+private:
+    int m_NumSources;
+    int m_Columns;
+    int m_Rows;
+    float m_TileWidth;
+    float m_TileHeight;
+    std::vector<TileRect> m_Tiles;
+};
+
+#endif // _MOSAIC_H_
@@ -0,0 +1,151 @@
+#include "motion_gate.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Samples per cell side, 4x4 samples are enough to average out noise
+static constexpr int CELL_SAMPLES = 4;
+
+void downsampleLuma(const uint8_t* luma, int pitch, int width, int height,
+    uint8_t* grid, int gridWidth, int gridHeight)
+{
+    for (int gy = 0; gy < gridHeight; gy++) {
+        int y0 = gy * height / gridHeight;
+        int y1 = std::max((gy + 1) * height / gridHeight, y0 + 1);
+        int ystep = std::max((y1 - y0) / CELL_SAMPLES, 1);
+        for (int gx = 0; gx < gridWidth; gx++) {
+            int x0 = gx * width / gridWidth;
+            int x1 = std::max((gx + 1) * width / gridWidth, x0 + 1);
+            int xstep = std::max((x1 - x0) / CELL_SAMPLES, 1);
+            unsigned int sum = 0, count = 0;
+            for (int y = y0; y < y1; y += ystep) {
+                const uint8_t* row = luma + (size_t)y * pitch;
+                for (int x = x0; x < x1; x += xstep) {
+                    sum += row[x];
+                    count++;
+                }
+            }
+            grid[gy * gridWidth + gx] = (uint8_t)(sum / count);
+        }
+    }
+}
+
+static uint64_t sumAbsDiff(const uint8_t* a, const uint8_t* b, size_t count)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += std::abs((int)a[i] - (int)b[i]);
+    }
+    return sum;
+}
+
+float motionEnergy(const uint8_t* a, const uint8_t* b, size_t count)
+{
+    if (count == 0) {
+        return 0.F;
+    }
+    uint64_t sum = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    // Both 64-bit lanes in full, a 32-bit read would wrap on large counts
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    sum += lanes[0] + lanes[1];
+#elif defined(__ARM_NEON)
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(diff)));
+    }
+    sum += vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    sum += sumAbsDiff(a + i, b + i, count - i);
+    return (float)sum / (255.F * count);
+}
+
+float motionEnergyScalar(const uint8_t* a, const uint8_t* b, size_t count)
+{
+    if (count == 0) {
+        return 0.F;
+    }
+    return (float)sumAbsDiff(a, b, count) / (255.F * count);
+}
+
+MotionGate::MotionGate(float threshold, int maxStaleFrames, int gridWidth, int gridHeight)
+    : m_Threshold(threshold),
+      m_MaxStaleFrames(maxStaleFrames),
+      m_GridWidth(gridWidth),
+      m_GridHeight(gridHeight)
+{
+    assert(gridWidth > 0 && gridHeight > 0);
+}
+
+bool MotionGate::update(int sourceId, const uint8_t* luma, int pitch, int width, int height)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    SourceState& state = m_Sources[sourceId];
+    state.current.resize(m_GridWidth * m_GridHeight);
+    downsampleLuma(luma, pitch, width, height, state.current.data(), m_GridWidth, m_GridHeight);
+
+    bool infer = true;
+    if (state.reference.size() == state.current.size()) {
+        state.score = motionEnergy(state.reference.data(), state.current.data(), state.current.size());
+        infer = state.score >= m_Threshold || !state.hasDetections ||
+            state.staleFrames >= m_MaxStaleFrames;
+    }
+
+    if (infer) {
+        // Later frames are compared with the last inferred one, so slow
+        // changes accumulate until they pass the threshold
+        state.reference.swap(state.current);
+        state.staleFrames = 0;
+    } else {
+        state.staleFrames++;
+    }
+    return infer;
+}
+
+float MotionGate::getLastScore(int sourceId) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Sources.find(sourceId);
+    return it == m_Sources.end() ? 1.F : it->second.score;
+}
+
+void MotionGate::storeDetections(int sourceId, const std::vector<NvDsInferParseObjectInfo>& objects)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    SourceState& state = m_Sources[sourceId];
+    state.detections = objects;
+    state.hasDetections = true;
+}
+
+bool MotionGate::getDetections(int sourceId, std::vector<NvDsInferParseObjectInfo>& objects) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Sources.find(sourceId);
+    if (it == m_Sources.end() || !it->second.hasDetections) {
+        return false;
+    }
+    objects = it->second.detections;
+    return true;
+}
+
+void MotionGate::removeSource(int sourceId)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Sources.erase(sourceId);
+}
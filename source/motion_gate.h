@@ -0,0 +1,60 @@
+#ifndef _MOTION_GATE_H_
+#define _MOTION_GATE_H_
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "nvdsinfer.h"
+
+/**
+ * Pre-inference gate for static scenes. Each source's luma plane is
+ * downsampled to a small grid and compared with the grid of the last frame
+ * that went through inference. While the mean absolute difference stays
+ * below threshold (in [0, 1]) the frame is skipped and the cached
+ * detections are reused, for at most maxStaleFrames consecutive frames.
+ */
+class MotionGate {
+public:
+    MotionGate(float threshold, int maxStaleFrames, int gridWidth = 64, int gridHeight = 36);
+
+    // Returns true when the frame has to go through inference
+    bool update(int sourceId, const uint8_t* luma, int pitch, int width, int height);
+
+    float getLastScore(int sourceId) const;
+
+    void storeDetections(int sourceId, const std::vector<NvDsInferParseObjectInfo>& objects);
+    bool getDetections(int sourceId, std::vector<NvDsInferParseObjectInfo>& objects) const;
+
+    void removeSource(int sourceId);
+
+private:
+    struct SourceState
+    {
+        std::vector<uint8_t> reference;
+        std::vector<uint8_t> current;
+        float score = 1.F;
+        int staleFrames = 0;
+        bool hasDetections = false;
+        std::vector<NvDsInferParseObjectInfo> detections;
+    };
+
+    float m_Threshold;
+    int m_MaxStaleFrames;
+    int m_GridWidth;
+    int m_GridHeight;
+    mutable std::mutex m_Mutex;
+    std::map<int, SourceState> m_Sources;
+};
+
+// Averages a sparse sampling of each grid cell of an 8-bit plane
+void downsampleLuma(const uint8_t* luma, int pitch, int width, int height,
+    uint8_t* grid, int gridWidth, int gridHeight);
+
+// Mean absolute difference of two byte arrays, normalized to [0, 1]
+float motionEnergy(const uint8_t* a, const uint8_t* b, size_t count);
+
+// Portable motionEnergy without SSE2/NEON, the reference of the SIMD paths
+float motionEnergyScalar(const uint8_t* a, const uint8_t* b, size_t count);
+
+#endif // _MOTION_GATE_H_
@@ -23,6 +23,7 @@
 #include "nvdsinfer_custom_impl.h"
 #include "nvdsinfer_context.h"
 #include "yolo_trt.h"
+#include "custom_config.h"
 #include "trt_utils.h"
 #include <iostream>
 #include <algorithm>
@@ -37,35 +38,20 @@ static bool getYoloNetworkInfo (NetworkInfo &networkInfo, const NvDsInferContext
     std::transform (yoloCfg.begin(), yoloCfg.end(), yoloCfg.begin(), [] (uint8_t c) {
         return std::tolower (c);});
 
-    if (yoloCfg.find("yolov5s") != std::string::npos) {
-        if (yoloCfg == "yolov5s_p6") {
-            yoloType = "yolov5s_p6";
+    // e.g. /path/to/yolov5s.nocfg, or yolov5s_p6.nocfg for the P6 variant
+    static const char* kYoloModels[] = { "yolov5s", "yolov5m", "yolov5l", "yolov5x" };
+    for (const char* model : kYoloModels) {
+        size_t pos = yoloCfg.rfind(model);
+        if (pos == std::string::npos) {
+            continue;
         }
-        else {
-            yoloType = "yolov5s";
+        yoloType = model;
+        if (yoloCfg.compare(pos + yoloType.size(), 3, "_p6") == 0) {
+            yoloType += "_p6";
         }
-    } else if (yoloCfg.find("yolov5m") != std::string::npos) {
-        if (yoloCfg == "yolov5m_p6") {
-            yoloType = "yolov5m_p6";
-        }
-        else {
-            yoloType = "yolov5m";
-        }
-    } else if (yoloCfg.find("yolov5l") != std::string::npos) {
-        if (yoloCfg == "yolov5l_p6") {
-            yoloType = "yolov5l_p6";
-        }
-        else {
-            yoloType = "yolov5l";
-        }
-    } else if (yoloCfg.find("yolov5x") != std::string::npos) {
-        if (yoloCfg == "yolov5x_p6") {
-            yoloType = "yolov5x_p6";
-        }
-        else {
-            yoloType = "yolov5x";
-        }
-    } else {
+        break;
+    }
+    if (yoloType.empty()) {
         std::cerr << "Yolo type is not defined from config file name:"
                   << yoloCfg << std::endl;
         return false;
@@ -76,6 +62,8 @@ static bool getYoloNetworkInfo (NetworkInfo &networkInfo, const NvDsInferContext
     networkInfo.wtsFilePath     = initParams->modelFilePath;
     networkInfo.deviceType      = (initParams->useDLA ? "kDLA" : "kGPU");
     networkInfo.inputBlobName   = "data";
+    networkInfo.precisionProfilePath = getCustomConfig().getString("precision", "profile");
+    networkInfo.sparseWeights   = getCustomConfig().getBool("build", "sparse-weights");
 
     if (networkInfo.configFilePath.empty() ||
         networkInfo.wtsFilePath.empty()) {
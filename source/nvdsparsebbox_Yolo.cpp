@@ -22,10 +22,18 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "nvdsinfer_custom_impl.h"
+#include "box_utils.h"
+#include "custom_config.h"
+#include "detection_ring.h"
+#include "mosaic.h"
+#include "thread_pool.h"
 #include "trt_utils.h"
 #include "yololayer.h"
+#include "zone_filter.h"
 
 extern "C" bool NvDsInferParseCustomYoloV5(
     std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
@@ -33,17 +41,129 @@ extern "C" bool NvDsInferParseCustomYoloV5(
     NvDsInferParseDetectionParams const& detectionParams,
     std::vector<NvDsInferParseObjectInfo>& objectList);
 
-extern "C" bool NvDsInferParseCustomYoloV5(
-    std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+// Parses, thresholds and clusters a whole batch of "prob" output at once,
+// frames in parallel. prob points at numFrames consecutive frame outputs in
+// host memory, e.g. the output tensor meta of nvinfer with
+// output-tensor-meta=1. NMS replaces nvinfer clustering on this path.
+extern "C" bool NvDsInferParseCustomYoloV5Batch(
+    const float* prob, int numFrames,
     NvDsInferNetworkInfo const& networkInfo,
     NvDsInferParseDetectionParams const& detectionParams,
+    float nmsIouThreshold,
+    std::vector<std::vector<NvDsInferParseObjectInfo>>& objectLists);
+
+// Include/exclude zones of [zones], or nullptr when disabled. Objects
+// outside the include zones or inside exclude zones are dropped before they
+// reach clustering and the tracker.
+static const ZoneFilter* getZoneFilter()
+{
+    static const ZoneFilter* zones = [] {
+        const CustomConfig& config = getCustomConfig();
+        if (!config.getBool("zones", "enable")) {
+            return (ZoneFilter*)nullptr;
+        }
+        int gridSize = config.getInt("zones", "grid-size", 128);
+        ZoneAnchor anchor = config.getString("zones", "anchor", "bottom") == "center"
+            ? ZoneAnchor::kCenter : ZoneAnchor::kBottomCenter;
+        ZoneFilter* filter = new ZoneFilter(gridSize, gridSize, anchor);
+        if (!filter->loadFromConfig(config)) {
+            std::cerr << "Zone filtering disabled" << std::endl;
+            delete filter;
+            return (ZoneFilter*)nullptr;
+        }
+        return filter;
+    }();
+    return zones;
+}
+
+// Stream-packing mode: the network input is a mosaic of [mosaic] num-sources
+// tiles, boxes are clipped to their tile and boxes crossing tiles are dropped.
+// Kept boxes are tested against the zones of their tile's source, normalized
+// to the tile.
+static void applyMosaic(NvDsInferNetworkInfo const& networkInfo, const ZoneFilter* zones,
     std::vector<NvDsInferParseObjectInfo>& objectList)
 {
-    UNUSED(networkInfo);
-    UNUSED(detectionParams);
+    const CustomConfig& config = getCustomConfig();
+    static const MosaicLayout layout(std::max(config.getInt("mosaic", "num-sources", 1), 1),
+        networkInfo.width, networkInfo.height, config.getInt("mosaic", "columns", 0));
+    static const float minInsideRatio = config.getFloat("mosaic", "min-inside-ratio", 0.5);
+
+    // assign() clips the kept boxes, so compact in place rather than through
+    // a remove_if predicate, which must not modify the elements
+    size_t kept = 0;
+    for (size_t i = 0; i < objectList.size(); i++) {
+        NvDsInferParseObjectInfo obj = objectList[i];
+        int sourceId = layout.assign(obj, minInsideRatio);
+        if (sourceId < 0) {
+            continue;
+        }
+        if (zones) {
+            const TileRect& tile = layout.getTile(sourceId);
+            NvDsInferParseObjectInfo local = obj;
+            local.left -= tile.left;
+            local.top -= tile.top;
+            if (!zones->accept(sourceId, local, tile.width, tile.height)) {
+                continue;
+            }
+        }
+        objectList[kept++] = obj;
+    }
+    objectList.resize(kept);
+}
 
+// Binary export of the parsed objects into the shared-memory ring named by
+// [detection-ring] name, one record per object tagged with a frame sequence,
+// or a single record with numObjects 0 for a frame without objects
+static void exportDetections(std::vector<NvDsInferParseObjectInfo> const& objectList)
+{
+    static DetectionRingProducer* ring = [] {
+        const CustomConfig& config = getCustomConfig();
+        DetectionRingProducer* producer = new DetectionRingProducer();
+        // Octal permissions, readable by consumers of other users only when
+        // widened to e.g. 0640 with a shared group
+        mode_t mode = strtol(config.getString("detection-ring", "mode", "0600").c_str(), nullptr, 8);
+        if (!producer->create(config.getString("detection-ring", "name", "/yolov5_detections"),
+                config.getInt("detection-ring", "capacity", 65536), mode)) {
+            delete producer;
+            return (DetectionRingProducer*)nullptr;
+        }
+        return producer;
+    }();
+    static const uint32_t sourceId = getCustomConfig().getInt("detection-ring", "source-id", 0);
+    if (!ring) {
+        return;
+    }
+
+    // Drawn from the ring, so frame numbers keep increasing when the pipeline
+    // restarts and reattaches to it
+    uint64_t seq = ring->nextFrameSeq();
+    DetectionRecord record;
+    memset(&record, 0, sizeof(record));
+    record.frameSeq = seq;
+    record.sourceId = sourceId;
+    record.numObjects = std::min<size_t>(objectList.size(), UINT16_MAX);
+    if (record.numObjects == 0) {
+        ring->push(record);
+        return;
+    }
+    for (uint16_t k = 0; k < record.numObjects; k++) {
+        const NvDsInferParseObjectInfo& info = objectList[k];
+        record.classId = info.classId;
+        record.objectIndex = k;
+        record.left = info.left;
+        record.top = info.top;
+        record.width = info.width;
+        record.height = info.height;
+        record.confidence = info.detectionConfidence;
+        ring->push(record);
+    }
+}
+
+// Decodes one frame of the "prob" output and applies the optional filters
+static void parseYoloFrame(const float* outputs, NvDsInferNetworkInfo const& networkInfo,
+    std::vector<NvDsInferParseObjectInfo>& objectList)
+{
     const int det_size = sizeof(Yolo::Detection) / sizeof(float);
-    const float* outputs = (const float *)(outputLayersInfo[0].buffer);
     int num = Yolo::MAX_OUTPUT_BBOX_COUNT;
     if (outputs[0] < Yolo::MAX_OUTPUT_BBOX_COUNT) {
         num = outputs[0];
@@ -62,6 +182,74 @@ extern "C" bool NvDsInferParseCustomYoloV5(
             info.classId = ptr[5];
         }
     }
+
+    const ZoneFilter* zones = getZoneFilter();
+    static const bool mosaic = getCustomConfig().getBool("mosaic", "enable");
+    if (mosaic) {
+        applyMosaic(networkInfo, zones, objectList);
+    } else if (zones) {
+        // A single source, whose id the parser does not know: the default
+        // zones apply, normalized to the network input
+        zones->filter(-1, objectList, networkInfo.width, networkInfo.height);
+    }
+}
+
+extern "C" bool NvDsInferParseCustomYoloV5(
+    std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+    NvDsInferNetworkInfo const& networkInfo,
+    NvDsInferParseDetectionParams const& detectionParams,
+    std::vector<NvDsInferParseObjectInfo>& objectList)
+{
+    UNUSED(detectionParams);
+
+    const float* outputs = (const float *)(outputLayersInfo[0].buffer);
+    parseYoloFrame(outputs, networkInfo, objectList);
+
+    static const bool exportRing = getCustomConfig().getBool("detection-ring", "enable");
+    if (exportRing) {
+        exportDetections(objectList);
+    }
+    return true;
+}
+
+extern "C" bool NvDsInferParseCustomYoloV5Batch(
+    const float* prob, int numFrames,
+    NvDsInferNetworkInfo const& networkInfo,
+    NvDsInferParseDetectionParams const& detectionParams,
+    float nmsIouThreshold,
+    std::vector<std::vector<NvDsInferParseObjectInfo>>& objectLists)
+{
+    static ThreadPool pool(getCustomConfig().getInt("batch-parse", "threads", 0));
+    // Per-worker scratch, reused across batches so steady state parsing
+    // does not allocate
+    static std::vector<std::vector<NvDsInferParseObjectInfo>> scratch(pool.getNumThreads());
+
+    const int frameSize = 1 + Yolo::MAX_OUTPUT_BBOX_COUNT * sizeof(Yolo::Detection) / sizeof(float);
+    objectLists.resize(numFrames);
+
+    pool.parallelFor(numFrames, [&](int frame, int worker) {
+        std::vector<NvDsInferParseObjectInfo>& objects = scratch[worker];
+        objects.clear();
+        parseYoloFrame(prob + (size_t)frame * frameSize, networkInfo, objects);
+
+        auto last = std::remove_if(objects.begin(), objects.end(),
+            [&](const NvDsInferParseObjectInfo& obj) {
+                const std::vector<float>& thresholds = detectionParams.perClassPreclusterThreshold;
+                return obj.classId < thresholds.size() &&
+                    obj.detectionConfidence < thresholds[obj.classId];
+            });
+        objects.erase(last, objects.end());
+        nonMaximumSuppression(objects, nmsIouThreshold);
+
+        objectLists[frame].assign(objects.begin(), objects.end());
+    });
+
+    static const bool exportRing = getCustomConfig().getBool("detection-ring", "enable");
+    if (exportRing) {
+        for (int frame = 0; frame < numFrames; frame++) {
+            exportDetections(objectLists[frame]);
+        }
+    }
     return true;
 }
 
@@ -0,0 +1,105 @@
+#include "precision_profile.h"
+#include "custom_config.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool parseLayerPrecision(const std::string& s, LayerPrecision& precision)
+{
+    if (s == "fp32") {
+        precision = LayerPrecision::kFP32;
+    } else if (s == "fp16") {
+        precision = LayerPrecision::kFP16;
+    } else if (s == "int8") {
+        precision = LayerPrecision::kINT8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool wildcardMatch(const char* pattern, const char* s)
+{
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*s) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = s;
+        } else if (*pattern == *s) {
+            pattern++;
+            s++;
+        } else if (star) {
+            pattern = star + 1;
+            s = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+bool PrecisionProfile::load(const std::string& filePath)
+{
+    std::ifstream input(filePath);
+    if (!input.is_open()) {
+        std::cerr << "Unable to open precision profile: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(input, line)) {
+        lineNum++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = trimString(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string pattern, precision, outputType;
+        fields >> pattern >> precision >> outputType;
+        if (outputType.empty()) {
+            outputType = precision;
+        }
+        PrecisionRule rule;
+        rule.pattern = pattern;
+        if (!parseLayerPrecision(precision, rule.precision) ||
+            !parseLayerPrecision(outputType, rule.outputType)) {
+            std::cerr << "Invalid line " << lineNum << " in precision profile: "
+                      << filePath << std::endl;
+            return false;
+        }
+        m_Rules.push_back(rule);
+    }
+    return true;
+}
+
+const PrecisionRule* PrecisionProfile::match(const std::string& layerName) const
+{
+    for (auto it = m_Rules.rbegin(); it != m_Rules.rend(); ++it) {
+        if (wildcardMatch(it->pattern.c_str(), layerName.c_str()) ||
+            wildcardMatch((it->pattern + ".*").c_str(), layerName.c_str())) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+bool PrecisionProfile::uses(LayerPrecision precision) const
+{
+    for (const PrecisionRule& rule : m_Rules) {
+        if (rule.precision == precision || rule.outputType == precision) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,46 @@
+#ifndef _PRECISION_PROFILE_H_
+#define _PRECISION_PROFILE_H_
+
+#include <string>
+#include <vector>
+
+enum class LayerPrecision { kFP32, kFP16, kINT8 };
+
+struct PrecisionRule
+{
+    std::string pattern;
+    LayerPrecision precision;
+    LayerPrecision outputType;
+};
+
+/**
+ * Per-layer precision pins, keyed by the lname strings the network builder
+ * uses. Each line of a profile file is
+ *
+ *   <layer pattern> <fp32|fp16|int8> [<output type>]
+ *
+ * A pattern matches a layer named like it, or any layer below it, so
+ * "model.0" covers model.0.conv, model.0.bn and model.0.act. '*' matches any
+ * run of characters. Later lines override earlier ones, so a profile starts
+ * with its broad rules, e.g. "* int8", followed by the exceptions.
+ */
+class PrecisionProfile {
+public:
+    bool load(const std::string& filePath);
+    void addRule(const PrecisionRule& rule) { m_Rules.push_back(rule); }
+
+    // Last matching rule, nullptr when no rule matches
+    const PrecisionRule* match(const std::string& layerName) const;
+    bool uses(LayerPrecision precision) const;
+    bool empty() const { return m_Rules.empty(); }
+
+private:
+    std::vector<PrecisionRule> m_Rules;
+};
+
+bool parseLayerPrecision(const std::string& s, LayerPrecision& precision);
+
+// Glob match supporting '*' only
+bool wildcardMatch(const char* pattern, const char* s);
+
+#endif // _PRECISION_PROFILE_H_
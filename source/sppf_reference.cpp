@@ -0,0 +1,117 @@
+#include "sppf_reference.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "sppf_tile.h"
+
+void sppfReference(const float* in, float* out, int channels, int height, int width, int kernelSize)
+{
+    const int r = kernelSize / 2;
+    const size_t plane = (size_t)height * width;
+    for (int c = 0; c < channels; c++) {
+        const float* src = in + c * plane;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                float m1 = -FLT_MAX, m2 = -FLT_MAX, m3 = -FLT_MAX;
+                for (int dy = -3 * r; dy <= 3 * r; dy++) {
+                    int yy = y + dy;
+                    if (yy < 0 || yy >= height) {
+                        continue;
+                    }
+                    for (int dx = -3 * r; dx <= 3 * r; dx++) {
+                        int xx = x + dx;
+                        if (xx < 0 || xx >= width) {
+                            continue;
+                        }
+                        float v = src[yy * width + xx];
+                        int d = std::max(std::abs(dy), std::abs(dx));
+                        m3 = std::max(m3, v);
+                        if (d <= 2 * r) {
+                            m2 = std::max(m2, v);
+                        }
+                        if (d <= r) {
+                            m1 = std::max(m1, v);
+                        }
+                    }
+                }
+                size_t idx = y * width + x;
+                out[(0 * channels + c) * plane + idx] = src[idx];
+                out[(1 * channels + c) * plane + idx] = m1;
+                out[(2 * channels + c) * plane + idx] = m2;
+                out[(3 * channels + c) * plane + idx] = m3;
+            }
+        }
+    }
+}
+
+void sppfTiledReference(const float* in, float* out, int channels, int height, int width, int kernelSize)
+{
+    const int r = kernelSize / 2;
+    const size_t plane = (size_t)height * width;
+    std::vector<float> buffer(Sppf::bufferFloats(r));
+    const Sppf::TileBuffers buffers = Sppf::splitBuffer(buffer.data(), r);
+    for (int c = 0; c < channels; c++) {
+        const float* src = in + c * plane;
+        for (int y0 = 0; y0 < height; y0 += Sppf::TILE_H) {
+            for (int x0 = 0; x0 < width; x0 += Sppf::TILE_W) {
+                // Each step over the whole tile, like the block between barriers
+                for (int i = 0; i < Sppf::tileRows(r); i++) {
+                    for (int j = 0; j < Sppf::tileCols(r); j++) {
+                        Sppf::stage(buffers, src, height, width, x0, y0, r, i, j);
+                    }
+                }
+                for (int i = 0; i < Sppf::tileRows(r); i++) {
+                    for (int tx = 0; tx < Sppf::TILE_W; tx++) {
+                        Sppf::rowMaxima(buffers, r, i, tx);
+                    }
+                }
+                for (int ty = 0; ty < Sppf::TILE_H && y0 + ty < height; ty++) {
+                    for (int tx = 0; tx < Sppf::TILE_W && x0 + tx < width; tx++) {
+                        float pools[3];
+                        Sppf::columnMaxima(buffers, r, tx, ty, pools);
+                        size_t idx = (size_t)(y0 + ty) * width + x0 + tx;
+                        out[(0 * channels + c) * plane + idx] = src[idx];
+                        out[(1 * channels + c) * plane + idx] = pools[0];
+                        out[(2 * channels + c) * plane + idx] = pools[1];
+                        out[(3 * channels + c) * plane + idx] = pools[2];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void maxPool(const float* in, float* out, int height, int width, int kernelSize)
+{
+    const int r = kernelSize / 2;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float m = -FLT_MAX;
+            for (int yy = std::max(y - r, 0); yy <= std::min(y + r, height - 1); yy++) {
+                for (int xx = std::max(x - r, 0); xx <= std::min(x + r, width - 1); xx++) {
+                    m = std::max(m, in[yy * width + xx]);
+                }
+            }
+            out[y * width + x] = m;
+        }
+    }
+}
+
+void sppfLayeredReference(const float* in, float* out, int channels, int height, int width, int kernelSize)
+{
+    const size_t plane = (size_t)height * width;
+    for (int c = 0; c < channels; c++) {
+        const float* src = in + c * plane;
+        float* p0 = out + (0 * channels + c) * plane;
+        float* p1 = out + (1 * channels + c) * plane;
+        float* p2 = out + (2 * channels + c) * plane;
+        float* p3 = out + (3 * channels + c) * plane;
+        memcpy(p0, src, plane * sizeof(float));
+        maxPool(p0, p1, height, width, kernelSize);
+        maxPool(p1, p2, height, width, kernelSize);
+        maxPool(p2, p3, height, width, kernelSize);
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef _SPPF_REFERENCE_H_
+#define _SPPF_REFERENCE_H_
+
+// Host references of the fused SPPF pooling of SppfLayerPlugin, for one CHW
+// image: out is 4C x H x W, [x, pool_k(x), pool_k^2(x), pool_k^3(x)]
+
+// From single pools of size k, 2k-1 and 3k-2 clipped to the map
+void sppfReference(const float* in, float* out, int channels, int height, int width, int kernelSize);
+
+// CalSppf on the host: the tile steps of sppf_tile.h run tile by tile
+void sppfTiledReference(const float* in, float* out, int channels, int height, int width, int kernelSize);
+
+// The layered construction SPPF() used to build: three chained stride 1
+// k x k max pools with k/2 padding, concatenated with the input
+void sppfLayeredReference(const float* in, float* out, int channels, int height, int width, int kernelSize);
+
+#endif // _SPPF_REFERENCE_H_
@@ -0,0 +1,97 @@
+#ifndef _SPPF_TILE_H_
+#define _SPPF_TILE_H_
+
+#include <stddef.h>
+#include <cfloat>
+#include <cmath>
+#ifdef __CUDACC__
+#include <cuda_fp16.h>
+#endif
+#include "host_device.h"
+
+/*
+ * Steps of the fused SPPF pooling on one output tile, shared by the CalSppf
+ * kernel and sppfTiledReference. Max pools of a stride 1 window are
+ * separable: the (2d+1)^2 window max is the max over 2d+1 rows of the row
+ * maxima over 2d+1 columns, with out-of-map pixels at -FLT_MAX like the
+ * clipped windows. A tile is staged with a 3r halo, then row maxima over
+ * |dx| <= r, 2r, 3r are taken for every staged row, and the three pools of a
+ * pixel are the column maxima of those over |dy| <= r, 2r, 3r.
+ */
+namespace Sppf
+{
+    // Output pixels of one tile, one CalSppf block
+    static constexpr int TILE_W = 32;
+    static constexpr int TILE_H = 8;
+
+    HOST_DEVICE inline int tileRows(int radius) { return TILE_H + 6 * radius; }
+    HOST_DEVICE inline int tileCols(int radius) { return TILE_W + 6 * radius; }
+
+    // Floats of the staged tile followed by its three row maxima
+    HOST_DEVICE inline size_t bufferFloats(int radius)
+    {
+        return (size_t)tileRows(radius) * (tileCols(radius) + 3 * TILE_W);
+    }
+
+    struct TileBuffers
+    {
+        float* tile;
+        float* rowMax[3];
+    };
+
+    HOST_DEVICE inline TileBuffers splitBuffer(float* buffer, int radius)
+    {
+        TileBuffers b;
+        b.tile = buffer;
+        b.rowMax[0] = buffer + tileRows(radius) * tileCols(radius);
+        b.rowMax[1] = b.rowMax[0] + tileRows(radius) * TILE_W;
+        b.rowMax[2] = b.rowMax[1] + tileRows(radius) * TILE_W;
+        return b;
+    }
+
+    HOST_DEVICE inline float toFloat(float v) { return v; }
+#ifdef __CUDACC__
+    HOST_DEVICE inline float toFloat(__half v) { return __half2float(v); }
+#endif
+
+    // Stages element (i, j) of the tile at (x0, y0) of the plane src
+    template<typename T>
+    HOST_DEVICE inline void stage(const TileBuffers& b, const T* src, int height, int width,
+        int x0, int y0, int radius, int i, int j)
+    {
+        const int yy = y0 - 3 * radius + i, xx = x0 - 3 * radius + j;
+        b.tile[i * tileCols(radius) + j] = yy >= 0 && yy < height && xx >= 0 && xx < width
+            ? toFloat(src[(size_t)yy * width + xx]) : -FLT_MAX;
+    }
+
+    // Row maxima of staged row i at tile column tx, once the tile is staged
+    HOST_DEVICE inline void rowMaxima(const TileBuffers& b, int radius, int i, int tx)
+    {
+        // Column tx of the tile sits at tx + 3r in the staged rows
+        const float* row = b.tile + i * tileCols(radius) + tx + 3 * radius;
+        float m = row[0];
+        for (int p = 0; p < 3; p++) {
+            for (int d = p * radius + 1; d <= (p + 1) * radius; d++) {
+                m = fmaxf(m, fmaxf(row[-d], row[d]));
+            }
+            b.rowMax[p][i * TILE_W + tx] = m;
+        }
+    }
+
+    // Pools of size k, 2k-1 and 3k-2 at tile pixel (tx, ty), once the row
+    // maxima of all staged rows are taken
+    HOST_DEVICE inline void columnMaxima(const TileBuffers& b, int radius, int tx, int ty, float pools[3])
+    {
+        const int center = (ty + 3 * radius) * TILE_W + tx;
+        for (int p = 0; p < 3; p++) {
+            const float* column = b.rowMax[p] + center;
+            float m = column[0];
+            for (int d = 1; d <= (p + 1) * radius; d++) {
+                m = fmaxf(m, fmaxf(column[-d * TILE_W], column[d * TILE_W]));
+            }
+            pools[p] = m;
+        }
+    }
+}
+
+#endif // _SPPF_TILE_H_
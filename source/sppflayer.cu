@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <algorithm>
+#include <cuda_fp16.h>
+#include <cstring>
+#include "sppf_tile.h"
+#include "sppflayer.h"
+
+namespace
+{
+    template<typename T>
+    void write(char*& buffer, const T& val)
+    {
+        *reinterpret_cast<T*>(buffer) = val;
+        buffer += sizeof(T);
+    }
+
+    template<typename T>
+    void read(const char*& buffer, T& val)
+    {
+        val = *reinterpret_cast<const T*>(buffer);
+        buffer += sizeof(T);
+    }
+}
+
+namespace nvinfer1
+{
+    SppfLayerPlugin::SppfLayerPlugin(int kernelSize)
+        : mKernelSize(kernelSize)
+    {
+    }
+
+    // create the plugin at runtime from a byte stream
+    SppfLayerPlugin::SppfLayerPlugin(const void* data, size_t length)
+    {
+        const char *d = reinterpret_cast<const char *>(data), *a = d;
+        read(d, mKernelSize);
+        read(d, mChannels);
+        read(d, mHeight);
+        read(d, mWidth);
+        read(d, mDataType);
+        assert(d == a + length);
+    }
+
+    void SppfLayerPlugin::serialize(void* buffer) const noexcept
+    {
+        char* d = static_cast<char*>(buffer), *a = d;
+        write(d, mKernelSize);
+        write(d, mChannels);
+        write(d, mHeight);
+        write(d, mWidth);
+        write(d, mDataType);
+        assert(d == a + getSerializationSize());
+    }
+
+    size_t SppfLayerPlugin::getSerializationSize() const noexcept
+    {
+        return sizeof(mKernelSize) + sizeof(mChannels) + sizeof(mHeight) +
+            sizeof(mWidth) + sizeof(mDataType);
+    }
+
+    Dims SppfLayerPlugin::getOutputDimensions(int index, const Dims* inputs, int nbInputDims) noexcept
+    {
+        assert(nbInputDims == 1 && inputs[0].nbDims == 3);
+        return Dims3(4 * inputs[0].d[0], inputs[0].d[1], inputs[0].d[2]);
+    }
+
+    bool SppfLayerPlugin::supportsFormat (
+        DataType type, PluginFormat format) const noexcept {
+        return (type == DataType::kFLOAT || type == DataType::kHALF) && format == PluginFormat::kLINEAR;
+    }
+
+    void SppfLayerPlugin::configureWithFormat (
+        const Dims* inputDims, int nbInputs,
+        const Dims* outputDims, int nbOutputs,
+        DataType type, PluginFormat format, int maxBatchSize) noexcept
+    {
+        assert(nbInputs == 1 && inputDims[0].nbDims == 3);
+        assert (format == PluginFormat::kLINEAR);
+        mChannels = inputDims[0].d[0];
+        mHeight = inputDims[0].d[1];
+        mWidth = inputDims[0].d[2];
+        mDataType = type;
+    }
+
+    // Clone the plugin
+    IPluginV2* SppfLayerPlugin::clone() const noexcept
+    {
+        SppfLayerPlugin* p = new SppfLayerPlugin(*this);
+        p->setPluginNamespace(mNamespace.c_str());
+        return p;
+    }
+
+    __device__ __forceinline__ void fromFloat(float v, float& out) { out = v; }
+    __device__ __forceinline__ void fromFloat(float v, __half& out) { out = __float2half(v); }
+
+    // One block per output tile of sppf_tile.h, one thread per tile pixel.
+    // The block stages the tile and takes the row maxima in shared memory,
+    // then writes the pixel and the three pools into the four channel groups
+    // of the output. Blocks loop over planes when the batch has more than
+    // gridDim.z of them.
+    template<typename T>
+    __global__ void CalSppf(const T* input, T* output, int planes,
+        int channels, int height, int width, int radius)
+    {
+        extern __shared__ float smem[];
+        const Sppf::TileBuffers buffers = Sppf::splitBuffer(smem, radius);
+        const int tileRows = Sppf::tileRows(radius);
+        const int tileCols = Sppf::tileCols(radius);
+
+        const int tx = threadIdx.x, ty = threadIdx.y;
+        const int x0 = blockIdx.x * Sppf::TILE_W, y0 = blockIdx.y * Sppf::TILE_H;
+        const int x = x0 + tx, y = y0 + ty;
+        const size_t plane = (size_t)height * width;
+
+        for (int nc = blockIdx.z; nc < planes; nc += gridDim.z) {
+            const T* src = input + (size_t)nc * plane;
+            for (int i = ty; i < tileRows; i += Sppf::TILE_H) {
+                for (int j = tx; j < tileCols; j += Sppf::TILE_W) {
+                    Sppf::stage(buffers, src, height, width, x0, y0, radius, i, j);
+                }
+            }
+            __syncthreads();
+
+            for (int i = ty; i < tileRows; i += Sppf::TILE_H) {
+                Sppf::rowMaxima(buffers, radius, i, tx);
+            }
+            __syncthreads();
+
+            if (x < width && y < height) {
+                float pools[3];
+                Sppf::columnMaxima(buffers, radius, tx, ty, pools);
+
+                int n = nc / channels;
+                int c = nc - n * channels;
+                size_t pixel = (size_t)y * width + x;
+                T* dst = output + (size_t)n * 4 * channels * plane + (size_t)c * plane + pixel;
+                size_t group = (size_t)channels * plane;
+                dst[0] = src[pixel];
+                fromFloat(pools[0], dst[group]);
+                fromFloat(pools[1], dst[2 * group]);
+                fromFloat(pools[2], dst[3 * group]);
+            }
+            // The next plane reuses the shared buffers
+            __syncthreads();
+        }
+    }
+
+    int32_t SppfLayerPlugin::enqueue(int32_t batchSize, void const* const* inputs,
+        void* const* outputs, void* workspace, cudaStream_t stream) noexcept
+    {
+        const int radius = mKernelSize / 2;
+        size_t smemBytes = sizeof(float) * Sppf::bufferFloats(radius);
+        int planes = batchSize * mChannels;
+        dim3 block(Sppf::TILE_W, Sppf::TILE_H);
+        dim3 grid((mWidth + Sppf::TILE_W - 1) / Sppf::TILE_W, (mHeight + Sppf::TILE_H - 1) / Sppf::TILE_H,
+            std::min(planes, 65535));
+        if (mDataType == DataType::kHALF) {
+            CalSppf<__half> <<< grid, block, smemBytes, stream >>>
+                ((const __half*)inputs[0], (__half*)outputs[0], planes, mChannels, mHeight, mWidth, radius);
+        }
+        else {
+            CalSppf<float> <<< grid, block, smemBytes, stream >>>
+                ((const float*)inputs[0], (float*)outputs[0], planes, mChannels, mHeight, mWidth, radius);
+        }
+        return cudaGetLastError() == cudaSuccess ? 0 : -1;
+    }
+
+    PluginFieldCollection SppfPluginCreator::mFC{};
+    std::vector<PluginField> SppfPluginCreator::mPluginAttributes;
+
+    SppfPluginCreator::SppfPluginCreator()
+    {
+        mPluginAttributes.clear();
+        mPluginAttributes.emplace_back(PluginField("kernel", nullptr, PluginFieldType::kINT32, 1));
+
+        mFC.nbFields = mPluginAttributes.size();
+        mFC.fields = mPluginAttributes.data();
+    }
+
+    IPluginV2* SppfPluginCreator::createPlugin(const char* name, const PluginFieldCollection* fc) noexcept
+    {
+        assert(fc->nbFields == 1);
+        assert(strcmp(fc->fields[0].name, "kernel") == 0);
+        int kernel = *(const int*)(fc->fields[0].data);
+        SppfLayerPlugin* obj = new SppfLayerPlugin(kernel);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+
+    IPluginV2* SppfPluginCreator::deserializePlugin(const char* name,
+        const void* serialData, size_t serialLength) noexcept
+    {
+        // This object will be deleted when the network is destroyed, which will
+        // call SppfLayerPlugin::destroy()
+        SppfLayerPlugin* obj = new SppfLayerPlugin(serialData, serialLength);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+}
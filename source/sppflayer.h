@@ -0,0 +1,100 @@
+#ifndef _SPPF_LAYER_H
+#define _SPPF_LAYER_H
+
+#include <string>
+#include <vector>
+#include "NvInfer.h"
+
+namespace nvinfer1
+{
+    /**
+     * Fused SPPF pooling: for a CxHxW input writes the 4CxHxW concatenation
+     * [x, pool(x), pool(pool(x)), pool(pool(pool(x)))] of stride 1 k x k max
+     * pools in one pass. Cascaded pools with k/2 padding equal single pools
+     * of size k, 2k-1 and 3k-2 clipped to the map. The kernel derives all
+     * three from separable row and column maxima of a shared-memory tile,
+     * without materializing the intermediate maps or a separate concat.
+     */
+    class SppfLayerPlugin : public IPluginV2
+    {
+    public:
+        explicit SppfLayerPlugin(int kernelSize);
+        SppfLayerPlugin(const void* data, size_t length);
+        ~SppfLayerPlugin() override = default;
+
+        const char* getPluginType () const noexcept override { return "SppfLayer_TRT"; }
+        const char* getPluginVersion () const noexcept override { return "1"; }
+        int getNbOutputs () const noexcept override { return 1; }
+
+        nvinfer1::Dims getOutputDimensions (
+            int index, const Dims* inputs,
+            int nbInputDims) noexcept override;
+
+        bool supportsFormat (
+            DataType type, PluginFormat format) const noexcept override;
+
+        void configureWithFormat (
+            const Dims* inputDims, int nbInputs,
+            const Dims* outputDims, int nbOutputs,
+            DataType type, PluginFormat format, int maxBatchSize) noexcept override;
+
+        int initialize () noexcept override { return 0; }
+        void terminate () noexcept override {}
+        size_t getWorkspaceSize (int maxBatchSize) const noexcept override { return 0; }
+        int32_t enqueue (
+            int32_t batchSize, void const* const* inputs, void* const* outputs,
+            void* workspace, cudaStream_t stream) noexcept override;
+        size_t getSerializationSize() const noexcept override;
+        void serialize (void* buffer) const noexcept override;
+        void destroy () noexcept override { delete this; }
+        IPluginV2* clone() const noexcept override;
+
+        void setPluginNamespace (const char* pluginNamespace) noexcept override {
+            mNamespace = pluginNamespace;
+        }
+        const char* getPluginNamespace () const noexcept override {
+            return mNamespace.c_str();
+        }
+
+    private:
+        std::string mNamespace;
+        int mKernelSize;
+        int mChannels = 0;
+        int mHeight = 0;
+        int mWidth = 0;
+        DataType mDataType = DataType::kFLOAT;
+    };
+
+    class SppfPluginCreator : public IPluginCreator
+    {
+    public:
+        SppfPluginCreator();
+        ~SppfPluginCreator() override = default;
+
+        const char* getPluginName () const noexcept override { return "SppfLayer_TRT"; }
+        const char* getPluginVersion () const noexcept override { return "1"; }
+
+        const PluginFieldCollection* getFieldNames() noexcept override { return &mFC; };
+
+        IPluginV2* createPlugin (
+            const char* name, const PluginFieldCollection* fc) noexcept override;
+
+        IPluginV2* deserializePlugin (
+            const char* name, const void* serialData, size_t serialLength) noexcept override;
+
+        void setPluginNamespace(const char* libNamespace) noexcept override {
+            mNamespace = libNamespace;
+        }
+        const char* getPluginNamespace() const noexcept override {
+            return mNamespace.c_str();
+        }
+
+    private:
+        std::string mNamespace;
+        static PluginFieldCollection mFC;
+        static std::vector<PluginField> mPluginAttributes;
+    };
+    REGISTER_TENSORRT_PLUGIN(SppfPluginCreator);
+};
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Scaling of NvDsInferParseCustomYoloV5Batch with the [batch-parse] thread
+ * count, on a synthetic batch of "prob" outputs with uneven object counts
+ * per frame. Each thread count runs in its own process, since the pool is
+ * sized from the custom config once per process, and its detections must
+ * match the single-threaded ones exactly.
+ *
+ *   bench_batch_parse [frames] [iterations] [max threads]
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "nvdsinfer_custom_impl.h"
+#include "yololayer.h"
+
+extern "C" bool NvDsInferParseCustomYoloV5Batch(
+    const float* prob, int numFrames,
+    NvDsInferNetworkInfo const& networkInfo,
+    NvDsInferParseDetectionParams const& detectionParams,
+    float nmsIouThreshold,
+    std::vector<std::vector<NvDsInferParseObjectInfo>>& objectLists);
+
+static const int kFrameSize = 1 + Yolo::MAX_OUTPUT_BBOX_COUNT * sizeof(Yolo::Detection) / sizeof(float);
+static const float kNmsIouThreshold = 0.45F;
+
+// Clusters of overlapping boxes, a few frames busy and most of them quiet,
+// so the workers have to steal to stay balanced
+static std::vector<float> synthesizeBatch(int numFrames)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(0.F, 1.F);
+    std::vector<float> prob((size_t)numFrames * kFrameSize, 0.F);
+    for (int f = 0; f < numFrames; f++) {
+        float* frame = &prob[(size_t)f * kFrameSize];
+        int count = f % 8 == 0 ? Yolo::MAX_OUTPUT_BBOX_COUNT : (int)(unit(rng) * 200);
+        frame[0] = (float)count;
+        Yolo::Detection* dets = (Yolo::Detection*)(frame + 1);
+        for (int k = 0; k < count; k += 4) {
+            float cx = 20.F + unit(rng) * 600.F, cy = 20.F + unit(rng) * 600.F;
+            float w = 10.F + unit(rng) * 100.F, h = 10.F + unit(rng) * 100.F;
+            float classId = (float)(int)(unit(rng) * Yolo::CLASS_NUM);
+            for (int j = k; j < std::min(k + 4, count); j++) {
+                Yolo::Detection& d = dets[j];
+                d.bbox[0] = cx + (unit(rng) - 0.5F) * 6.F;
+                d.bbox[1] = cy + (unit(rng) - 0.5F) * 6.F;
+                d.bbox[2] = w * (0.9F + unit(rng) * 0.2F);
+                d.bbox[3] = h * (0.9F + unit(rng) * 0.2F);
+                d.conf = 0.1F + unit(rng) * 0.9F;
+                d.class_id = classId;
+            }
+        }
+    }
+    return prob;
+}
+
+static bool writeAll(int fd, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t size)
+{
+    char* p = (char*)data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Child side: parses the batch with the pool sized by the config at
+// configPath, then sends the mean seconds per batch and the detections
+static void runChild(int fd, const std::string& configPath, const std::vector<float>& prob,
+    int numFrames, int iterations)
+{
+    setenv("YOLOV5_CUSTOM_CONFIG", configPath.c_str(), 1);
+    NvDsInferNetworkInfo networkInfo = { Yolo::INPUT_W, Yolo::INPUT_H, 3 };
+    NvDsInferParseDetectionParams detectionParams;
+    detectionParams.numClassesConfigured = Yolo::CLASS_NUM;
+    detectionParams.perClassPreclusterThreshold.assign(Yolo::CLASS_NUM, 0.25F);
+    std::vector<std::vector<NvDsInferParseObjectInfo>> objectLists;
+
+    // The first call loads the config and starts the pool
+    std::streambuf* log = std::cout.rdbuf(nullptr);
+    NvDsInferParseCustomYoloV5Batch(prob.data(), numFrames, networkInfo, detectionParams,
+        kNmsIouThreshold, objectLists);
+    std::cout.rdbuf(log);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        NvDsInferParseCustomYoloV5Batch(prob.data(), numFrames, networkInfo, detectionParams,
+            kNmsIouThreshold, objectLists);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+        / iterations;
+
+    bool ok = writeAll(fd, &seconds, sizeof(seconds));
+    for (const std::vector<NvDsInferParseObjectInfo>& objects : objectLists) {
+        uint32_t count = objects.size();
+        ok = ok && writeAll(fd, &count, sizeof(count)) &&
+            writeAll(fd, objects.data(), count * sizeof(NvDsInferParseObjectInfo));
+    }
+    close(fd);
+    _exit(ok ? 0 : 1);
+}
+
+static bool runThreads(int numThreads, const std::string& configPath, const std::vector<float>& prob,
+    int numFrames, int iterations, double& seconds,
+    std::vector<std::vector<NvDsInferParseObjectInfo>>& objectLists)
+{
+    std::ofstream config(configPath, std::ios::trunc);
+    config << "[batch-parse]\nthreads=" << numThreads << "\n";
+    config.close();
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        runChild(fds[1], configPath, prob, numFrames, iterations);
+    }
+    close(fds[1]);
+
+    bool ok = readAll(fds[0], &seconds, sizeof(seconds));
+    objectLists.assign(numFrames, std::vector<NvDsInferParseObjectInfo>());
+    for (int f = 0; ok && f < numFrames; f++) {
+        uint32_t count = 0;
+        ok = readAll(fds[0], &count, sizeof(count));
+        objectLists[f].resize(count);
+        ok = ok && readAll(fds[0], objectLists[f].data(), count * sizeof(NvDsInferParseObjectInfo));
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool sameDetections(const std::vector<std::vector<NvDsInferParseObjectInfo>>& a,
+    const std::vector<std::vector<NvDsInferParseObjectInfo>>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t f = 0; f < a.size(); f++) {
+        if (a[f].size() != b[f].size() ||
+            memcmp(a[f].data(), b[f].data(), a[f].size() * sizeof(NvDsInferParseObjectInfo)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int numFrames = argc > 1 ? std::atoi(argv[1]) : 32;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+    int maxThreads = argc > 3 ? std::atoi(argv[3]) : std::max(1U, std::thread::hardware_concurrency());
+    if (numFrames <= 0 || iterations <= 0 || maxThreads <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [frames] [iterations] [max threads]" << std::endl;
+        return 1;
+    }
+
+    char dir[] = "/tmp/bench_batch_parse_XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Unable to create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::string configPath = std::string(dir) + "/config.txt";
+    std::vector<float> prob = synthesizeBatch(numFrames);
+
+    std::cout << numFrames << " frames per batch, " << std::thread::hardware_concurrency()
+              << " cores" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "us/batch" << std::setw(14) << "us/frame"
+              << std::setw(10) << "speedup" << std::setw(8) << "match" << std::endl;
+    std::cout << std::fixed;
+
+    // Powers of two up to maxThreads, and maxThreads itself
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    bool allMatch = true;
+    double baseSeconds = 0.0;
+    std::vector<std::vector<NvDsInferParseObjectInfo>> baseLists;
+    for (int t : threadCounts) {
+        double seconds = 0.0;
+        std::vector<std::vector<NvDsInferParseObjectInfo>> objectLists;
+        if (!runThreads(t, configPath, prob, numFrames, iterations, seconds, objectLists)) {
+            std::cerr << "Run with " << t << " threads failed" << std::endl;
+            allMatch = false;
+            break;
+        }
+        if (t == 1) {
+            baseSeconds = seconds;
+            baseLists = objectLists;
+        }
+        bool match = sameDetections(objectLists, baseLists);
+        allMatch = allMatch && match;
+        std::cout << std::setw(8) << t << std::setw(14) << std::setprecision(1) << seconds * 1e6
+                  << std::setw(14) << std::setprecision(2) << seconds * 1e6 / numFrames
+                  << std::setw(10) << baseSeconds / seconds
+                  << std::setw(8) << (match ? "yes" : "NO") << std::endl;
+    }
+
+    remove(configPath.c_str());
+    rmdir(dir);
+    if (!allMatch) {
+        std::cerr << "Multi-threaded detections differ from the single-threaded ones" << std::endl;
+        return 1;
+    }
+    return 0;
+}
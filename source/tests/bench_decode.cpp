@@ -0,0 +1,218 @@
+/*
+ * CPU cost per frame of decoding and post-processing the yolov5 outputs,
+ * P5 at 640 against P6 at 1280, for sizing hosts of high resolution cameras.
+ *
+ *   bench_decode [objects per frame] [frames]
+ *
+ * Synthetic detect conv outputs carry the objects at the same normalized
+ * positions for both models. Each frame is decoded with the host reference
+ * of the YoloLayerPlugin decode, which runs the per-cell steps of the
+ * CalDetection kernel, then parsed by NvDsInferParseCustomYoloV5
+ * and clustered with NMS like nvinfer does. The objects found are checked
+ * against the injected ones, so the P6 grids are exercised end to end.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "nvdsinfer_custom_impl.h"
+#include "box_utils.h"
+#include "yolo_decode_reference.h"
+#include "yololayer.h"
+
+extern "C" bool NvDsInferParseCustomYoloV5(
+    std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+    NvDsInferNetworkInfo const& networkInfo,
+    NvDsInferParseDetectionParams const& detectionParams,
+    std::vector<NvDsInferParseObjectInfo>& objectList);
+
+struct ModelLayout
+{
+    const char* name;
+    int inputSize;
+    // Anchors of yolov5 v6.1, in input pixels, per output scale
+    std::vector<std::vector<float>> anchors;
+};
+
+static const float kPreClusterThreshold = 0.25F;
+static const float kNmsIouThreshold = 0.45F;
+
+static float inverseLogist(float p)
+{
+    p = std::min(std::max(p, 1e-4F), 1.F - 1e-4F);
+    return logf(p / (1.F - p));
+}
+
+// One frame of detect conv outputs, objects in normalized [cx cy w h]
+static void synthesizeOutputs(const ModelLayout& model, const std::vector<Yolo::YoloKernel>& kernels,
+    const std::vector<std::array<float, 5>>& objects, std::mt19937& rng,
+    std::vector<std::vector<float>>& outputs)
+{
+    const int infoLen = 5 + Yolo::CLASS_NUM;
+    std::normal_distribution<float> background(-6.F, 1.F);
+    outputs.resize(kernels.size());
+    for (size_t i = 0; i < kernels.size(); i++) {
+        size_t size = (size_t)Yolo::CHECK_COUNT * infoLen * kernels[i].width * kernels[i].height;
+        outputs[i].resize(size);
+        for (float& v : outputs[i]) {
+            v = background(rng);
+        }
+    }
+
+    for (const std::array<float, 5>& obj : objects) {
+        float cx = obj[0] * model.inputSize, cy = obj[1] * model.inputSize;
+        float w = obj[2] * model.inputSize, h = obj[3] * model.inputSize;
+        // Assign the object to the anchor of closest shape, like training does
+        size_t bestScale = 0;
+        int bestAnchor = 0;
+        float bestRatio = 1e9F;
+        for (size_t i = 0; i < kernels.size(); i++) {
+            for (int k = 0; k < Yolo::CHECK_COUNT; k++) {
+                float rw = w / kernels[i].anchors[2 * k], rh = h / kernels[i].anchors[2 * k + 1];
+                float ratio = std::max(std::max(rw, 1.F / rw), std::max(rh, 1.F / rh));
+                if (ratio < bestRatio) {
+                    bestRatio = ratio;
+                    bestScale = i;
+                    bestAnchor = k;
+                }
+            }
+        }
+        const Yolo::YoloKernel& yolo = kernels[bestScale];
+        const int totalGrid = yolo.width * yolo.height;
+        float strideX = (float)model.inputSize / yolo.width;
+        float strideY = (float)model.inputSize / yolo.height;
+        int col = std::min((int)(cx / strideX), yolo.width - 1);
+        int row = std::min((int)(cy / strideY), yolo.height - 1);
+        float* cell = outputs[bestScale].data() + bestAnchor * infoLen * totalGrid + row * yolo.width + col;
+        cell[0] = inverseLogist((cx / strideX - col + 0.5F) / 2.F);
+        cell[totalGrid] = inverseLogist((cy / strideY - row + 0.5F) / 2.F);
+        cell[2 * totalGrid] = inverseLogist(sqrtf(w / yolo.anchors[2 * bestAnchor]) / 2.F);
+        cell[3 * totalGrid] = inverseLogist(sqrtf(h / yolo.anchors[2 * bestAnchor + 1]) / 2.F);
+        cell[4 * totalGrid] = inverseLogist(obj[4]);
+        cell[(5 + (row + col) % Yolo::CLASS_NUM) * totalGrid] = 4.F;
+    }
+}
+
+static void runModel(const ModelLayout& model, int numObjects, int numFrames)
+{
+    std::vector<Yolo::YoloKernel> kernels;
+    int stride = 8;
+    for (const std::vector<float>& anchors : model.anchors) {
+        Yolo::YoloKernel kernel;
+        kernel.width = model.inputSize / stride;
+        kernel.height = model.inputSize / stride;
+        std::copy(anchors.begin(), anchors.end(), kernel.anchors);
+        kernels.push_back(kernel);
+        stride *= 2;
+    }
+
+    // A few distinct frames, cycled so the timing is not dominated by setup
+    const int numDistinct = std::min(numFrames, 8);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(0.F, 1.F);
+    std::vector<std::vector<std::array<float, 5>>> frameObjects(numDistinct);
+    std::vector<std::vector<std::vector<float>>> frameOutputs(numDistinct);
+    for (int f = 0; f < numDistinct; f++) {
+        for (int n = 0; n < numObjects; n++) {
+            float w = 0.02F + 0.25F * unit(rng) * unit(rng);
+            float h = 0.02F + 0.35F * unit(rng) * unit(rng);
+            float cx = w / 2 + (1.F - w) * unit(rng);
+            float cy = h / 2 + (1.F - h) * unit(rng);
+            frameObjects[f].push_back({ cx, cy, w, h, 0.5F + 0.45F * unit(rng) });
+        }
+        synthesizeOutputs(model, kernels, frameObjects[f], rng, frameOutputs[f]);
+    }
+
+    NvDsInferNetworkInfo networkInfo;
+    networkInfo.width = model.inputSize;
+    networkInfo.height = model.inputSize;
+    networkInfo.channels = 3;
+    NvDsInferParseDetectionParams detectionParams;
+    detectionParams.numClassesConfigured = Yolo::CLASS_NUM;
+    std::vector<float> prob(1 + Yolo::MAX_OUTPUT_BBOX_COUNT * sizeof(Yolo::Detection) / sizeof(float));
+    std::vector<NvDsInferLayerInfo> layers(1);
+    layers[0].buffer = prob.data();
+    std::vector<NvDsInferParseObjectInfo> objects;
+    std::vector<const float*> inputs(kernels.size());
+
+    double decodeSeconds = 0.0, postSeconds = 0.0;
+    size_t candidates = 0, found = 0, injected = 0;
+    for (int frame = 0; frame < numFrames; frame++) {
+        const std::vector<std::vector<float>>& outputs = frameOutputs[frame % numDistinct];
+        for (size_t i = 0; i < kernels.size(); i++) {
+            inputs[i] = outputs[i].data();
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        yoloDecodeReference(inputs, kernels, model.inputSize, model.inputSize,
+            Yolo::CLASS_NUM, Yolo::MAX_OUTPUT_BBOX_COUNT, prob.data());
+        auto t1 = std::chrono::steady_clock::now();
+        objects.clear();
+        NvDsInferParseCustomYoloV5(layers, networkInfo, detectionParams, objects);
+        candidates += objects.size();
+        auto last = std::remove_if(objects.begin(), objects.end(),
+            [](const NvDsInferParseObjectInfo& obj) { return obj.detectionConfidence < kPreClusterThreshold; });
+        objects.erase(last, objects.end());
+        nonMaximumSuppression(objects, kNmsIouThreshold);
+        auto t2 = std::chrono::steady_clock::now();
+        decodeSeconds += std::chrono::duration<double>(t1 - t0).count();
+        postSeconds += std::chrono::duration<double>(t2 - t1).count();
+
+        // Injected objects should come back at IoU >= 0.9, unless two of
+        // them landed on the same cell and anchor
+        for (const std::array<float, 5>& obj : frameObjects[frame % numDistinct]) {
+            NvDsInferParseObjectInfo expected;
+            expected.width = obj[2] * model.inputSize;
+            expected.height = obj[3] * model.inputSize;
+            expected.left = obj[0] * model.inputSize - expected.width / 2;
+            expected.top = obj[1] * model.inputSize - expected.height / 2;
+            injected++;
+            for (const NvDsInferParseObjectInfo& o : objects) {
+                if (boxIoU(expected, o) >= 0.9F) {
+                    found++;
+                    break;
+                }
+            }
+        }
+    }
+
+    int cells = 0;
+    for (const Yolo::YoloKernel& kernel : kernels) {
+        cells += kernel.width * kernel.height * Yolo::CHECK_COUNT;
+    }
+    std::cout << std::setw(8) << model.name << std::setw(7) << model.inputSize
+              << std::setw(8) << kernels.size() << std::setw(9) << cells
+              << std::setw(12) << decodeSeconds * 1e6 / numFrames
+              << std::setw(12) << postSeconds * 1e6 / numFrames
+              << std::setw(12) << (float)candidates / numFrames
+              << std::setw(8) << found << "/" << injected << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int numObjects = argc > 1 ? std::atoi(argv[1]) : 20;
+    int numFrames = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (numObjects < 0 || numFrames <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [objects per frame] [frames]" << std::endl;
+        return 1;
+    }
+
+    const ModelLayout p5 = { "P5", Yolo::INPUT_W,
+        { { 10, 13, 16, 30, 33, 23 }, { 30, 61, 62, 45, 59, 119 }, { 116, 90, 156, 198, 373, 326 } } };
+    const ModelLayout p6 = { "P6", Yolo::INPUT_W_P6,
+        { { 19, 27, 44, 40, 38, 94 }, { 96, 68, 86, 152, 180, 137 }, { 140, 301, 303, 264, 238, 542 },
+            { 436, 615, 739, 380, 925, 792 } } };
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(8) << "model" << std::setw(7) << "input" << std::setw(8) << "scales"
+              << std::setw(9) << "cells" << std::setw(12) << "decode us" << std::setw(12) << "post us"
+              << std::setw(12) << "candidates" << std::setw(12) << "found" << std::endl;
+    runModel(p5, numObjects, numFrames);
+    runModel(p6, numObjects, numFrames);
+    return 0;
+}
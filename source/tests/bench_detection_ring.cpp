@@ -0,0 +1,118 @@
+/*
+ * Throughput of the shared-memory detection ring: producers pushing as fast
+ * as they can against consumers popping in batches, for growing producer and
+ * consumer counts, with the share of records each consumer lost.
+ *
+ *   bench_detection_ring [records per producer] [capacity]
+ */
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "detection_ring.h"
+
+struct Result
+{
+    double pushSeconds = 0.0;
+    uint64_t received = 0;
+    uint64_t lost = 0;
+};
+
+static Result run(int numProducers, int numConsumers, uint64_t perProducer, uint64_t capacity)
+{
+    std::string name = "/yolov5_bench_ring_" + std::to_string(getpid());
+    DetectionRingProducer producer;
+    Result result;
+    if (!producer.create(name, capacity)) {
+        return result;
+    }
+
+    std::atomic<int> running(numProducers);
+    std::vector<uint64_t> received(numConsumers, 0), lost(numConsumers, 0);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < numConsumers; c++) {
+        consumers.emplace_back([&, c]() {
+            DetectionRingConsumer consumer;
+            if (!consumer.open(name, true)) {
+                return;
+            }
+            std::vector<DetectionRecord> records(1024);
+            while (true) {
+                bool done = running == 0;
+                int count = consumer.pop(records.data(), (int)records.size());
+                received[c] += count;
+                if (done && count == 0) {
+                    break;
+                }
+            }
+            lost[c] = consumer.getLost();
+        });
+    }
+    usleep(10000);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < numProducers; p++) {
+        producers.emplace_back([&, p]() {
+            DetectionRecord record;
+            memset(&record, 0, sizeof(record));
+            record.sourceId = p;
+            for (uint64_t i = 0; i < perProducer; i++) {
+                record.frameSeq = i;
+                producer.push(record);
+            }
+            running--;
+        });
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    result.pushSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (std::thread& t : consumers) {
+        t.join();
+    }
+    producer.unlink();
+
+    for (int c = 0; c < numConsumers; c++) {
+        result.received += received[c];
+        result.lost += lost[c];
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t perProducer = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    uint64_t capacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 65536;
+    if (perProducer == 0 || capacity == 0) {
+        std::cerr << "Usage: " << argv[0] << " [records per producer] [capacity]" << std::endl;
+        return 1;
+    }
+
+    std::cout << sizeof(DetectionRecord) << " byte records, capacity " << capacity << ", "
+              << std::thread::hardware_concurrency() << " cores" << std::endl;
+    std::cout << std::setw(10) << "producers" << std::setw(11) << "consumers"
+              << std::setw(14) << "Mrecords/s" << std::setw(11) << "ns/push"
+              << std::setw(11) << "lost" << std::endl;
+    std::cout << std::fixed;
+    for (int numConsumers : { 0, 1, 2 }) {
+        for (int numProducers : { 1, 2, 4, 8 }) {
+            Result r = run(numProducers, numConsumers, perProducer, capacity);
+            uint64_t total = perProducer * numProducers;
+            double rate = total / r.pushSeconds;
+            std::cout << std::setw(10) << numProducers << std::setw(11) << numConsumers
+                      << std::setw(14) << std::setprecision(2) << rate / 1e6
+                      << std::setw(11) << std::setprecision(1) << 1e9 / rate * numProducers
+                      << std::setw(11) << std::setprecision(3)
+                      << (numConsumers ? (double)r.lost / (total * numConsumers) : 0.0) << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * CPU cost of sliced inference bookkeeping on a 3840x2160 source: tile
+ * planning, scheduling against the previous detections and the cross-tile
+ * merge, for a growing number of objects per frame.
+ *
+ *   bench_tiling [frames]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "tiling.h"
+
+static const int kFrameWidth = 3840;
+static const int kFrameHeight = 2160;
+static const float kNet = 640.F;
+
+// Per-tile detections of the frame objects as the network would see them,
+// cut at the tile borders
+static void detectTiles(const std::vector<TileRect>& tiles, const std::vector<int>& ids,
+    const std::vector<NvDsInferParseObjectInfo>& objects,
+    std::vector<std::vector<NvDsInferParseObjectInfo>>& perTile)
+{
+    perTile.assign(ids.size(), std::vector<NvDsInferParseObjectInfo>());
+    for (size_t i = 0; i < ids.size(); i++) {
+        const TileRect& tile = tiles[ids[i]];
+        for (const NvDsInferParseObjectInfo& object : objects) {
+            NvDsInferParseObjectInfo obj = object;
+            clipBox(obj, tile.left, tile.top, tile.width, tile.height);
+            if (boxArea(obj) <= 0.F) {
+                continue;
+            }
+            obj.left = (obj.left - tile.left) * kNet / tile.width;
+            obj.top = (obj.top - tile.top) * kNet / tile.height;
+            obj.width *= kNet / tile.width;
+            obj.height *= kNet / tile.height;
+            perTile[i].push_back(obj);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int numFrames = argc > 1 ? std::atoi(argv[1]) : 1000;
+    if (numFrames <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [frames]" << std::endl;
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    const int planIterations = 1000;
+    size_t numTiles = 0;
+    for (int i = 0; i < planIterations; i++) {
+        TilePlanner planner(kFrameWidth, kFrameHeight, 640, 640, 0.2F, 10);
+        numTiles += planner.getTiles().size();
+    }
+    double planUs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count()
+        * 1e6 / planIterations;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << kFrameWidth << "x" << kFrameHeight << ", " << numTiles / planIterations
+              << " tiles of 640x640, planning " << planUs << " us" << std::endl;
+
+    std::cout << std::setw(9) << "objects" << std::setw(12) << "tiles/frame"
+              << std::setw(14) << "schedule us" << std::setw(11) << "nms us"
+              << std::setw(14) << "fusion us" << std::setw(10) << "merged" << std::endl;
+    for (int numObjects : { 10, 50, 200, 1000 }) {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> x(0.F, kFrameWidth - 200.F);
+        std::uniform_real_distribution<float> y(0.F, kFrameHeight - 200.F);
+        std::uniform_real_distribution<float> size(16.F, 200.F);
+        std::vector<NvDsInferParseObjectInfo> objects(numObjects);
+        for (NvDsInferParseObjectInfo& obj : objects) {
+            obj.left = x(rng);
+            obj.top = y(rng);
+            obj.width = size(rng);
+            obj.height = size(rng);
+            obj.classId = rng() % 4;
+            obj.detectionConfidence = 0.3F + 0.6F * (rng() % 1000) / 1000.F;
+        }
+
+        TilePlanner planner(kFrameWidth, kFrameHeight, 640, 640, 0.2F, 10);
+        const std::vector<TileRect>& tiles = planner.getTiles();
+        std::vector<std::vector<NvDsInferParseObjectInfo>> perTile;
+        std::vector<NvDsInferParseObjectInfo> merged;
+        double scheduleSeconds = 0.0, nmsSeconds = 0.0, fusionSeconds = 0.0;
+        size_t scheduled = 0, numMerged = 0;
+        for (int frame = 0; frame < numFrames; frame++) {
+            auto s0 = std::chrono::steady_clock::now();
+            std::vector<int> ids = planner.schedule(objects);
+            auto s1 = std::chrono::steady_clock::now();
+            scheduleSeconds += std::chrono::duration<double>(s1 - s0).count();
+            scheduled += ids.size();
+
+            detectTiles(tiles, ids, objects, perTile);
+            auto m0 = std::chrono::steady_clock::now();
+            mergeTileDetections(tiles, ids, perTile, kNet, kNet, merged, TileMergeMode::kNms);
+            auto m1 = std::chrono::steady_clock::now();
+            numMerged += merged.size();
+            mergeTileDetections(tiles, ids, perTile, kNet, kNet, merged, TileMergeMode::kFusion);
+            auto m2 = std::chrono::steady_clock::now();
+            nmsSeconds += std::chrono::duration<double>(m1 - m0).count();
+            fusionSeconds += std::chrono::duration<double>(m2 - m1).count();
+        }
+        std::cout << std::setw(9) << numObjects << std::setw(12) << (double)scheduled / numFrames
+                  << std::setw(14) << scheduleSeconds * 1e6 / numFrames
+                  << std::setw(11) << nmsSeconds * 1e6 / numFrames
+                  << std::setw(14) << fusionSeconds * 1e6 / numFrames
+                  << std::setw(10) << (double)numMerged / numFrames << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,217 @@
+/*
+ * Load time and peak memory of a wts file through WeightStore against the
+ * loader it replaced (iostream parsing, one malloc per blob, a std::map keyed
+ * by std::string), and the cost of the name lookups a network build makes.
+ * The weights file is synthetic, with the blob layout of yolov5 convs.
+ * Each loader runs in its own process so the peak RSS is its own.
+ *
+ *   bench_weight_store [million parameters]
+ */
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include "weight_store.h"
+
+using nvinfer1::Weights;
+
+struct Blob
+{
+    std::string name;
+    size_t count;
+};
+
+// Convs of growing width, each with its batch norm, like a yolov5 backbone
+static std::vector<Blob> makeLayout(size_t numParams)
+{
+    std::vector<Blob> blobs;
+    const int numLayers = 60;
+    size_t perLayer = numParams / numLayers;
+    for (int i = 0; i < numLayers; i++) {
+        int channels = 32 << std::min(i / 12, 5);
+        size_t kernel = std::max(perLayer - 4 * channels, (size_t)channels);
+        std::string lname = "model." + std::to_string(i / 3) + ".m." + std::to_string(i % 3) + ".cv1";
+        blobs.push_back({ lname + ".conv.weight", kernel });
+        for (const char* suffix : { ".bn.weight", ".bn.bias", ".bn.running_mean", ".bn.running_var" }) {
+            blobs.push_back({ lname + suffix, (size_t)channels });
+        }
+    }
+    return blobs;
+}
+
+static bool writeWts(const std::string& path, const std::vector<Blob>& blobs)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    std::mt19937 rng(1);
+    std::normal_distribution<float> value(0.F, 0.05F);
+    fprintf(f, "%zu\n", blobs.size());
+    for (const Blob& blob : blobs) {
+        fprintf(f, "%s %zu", blob.name.c_str(), blob.count);
+        for (size_t i = 0; i < blob.count; i++) {
+            float v = value(rng);
+            uint32_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            fprintf(f, " %x", bits);
+        }
+        fprintf(f, "\n");
+    }
+    return fclose(f) == 0;
+}
+
+// The loader WeightStore replaced
+static std::map<std::string, Weights> loadWeightsMap(const std::string& path)
+{
+    std::map<std::string, Weights> weightMap;
+    std::ifstream input(path);
+    int32_t count;
+    input >> count;
+    while (count--) {
+        Weights wt{ nvinfer1::DataType::kFLOAT, nullptr, 0 };
+        uint32_t size;
+        std::string name;
+        input >> name >> std::dec >> size;
+        uint32_t* val = reinterpret_cast<uint32_t*>(malloc(sizeof(uint32_t) * size));
+        for (uint32_t x = 0; x < size; ++x) {
+            input >> std::hex >> val[x];
+        }
+        wt.values = val;
+        wt.count = size;
+        weightMap[name] = wt;
+    }
+    return weightMap;
+}
+
+static long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Lookups per layer of a build: conv weight, then the four batch norm blobs
+static const int kLookupRounds = 2000;
+
+static void runMap(const std::string& path, const std::vector<Blob>& blobs)
+{
+    long rssBefore = peakRssKb();
+    auto start = std::chrono::steady_clock::now();
+    std::map<std::string, Weights> weightMap = loadWeightsMap(path);
+    double loadSeconds = secondsSince(start);
+    long rssAfter = peakRssKb();
+
+    int64_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kLookupRounds; round++) {
+        for (size_t i = 0; i < blobs.size(); i += 5) {
+            std::string lname = blobs[i].name.substr(0, blobs[i].name.size() - 12);
+            for (const char* suffix : { ".conv.weight", ".bn.weight", ".bn.bias", ".bn.running_mean",
+                     ".bn.running_var" }) {
+                found += weightMap[lname + suffix].count > 0;
+            }
+        }
+    }
+    double lookupNs = secondsSince(start) * 1e9 / found;
+
+    std::cout << std::setw(12) << "std::map" << std::setw(10) << weightMap.size()
+              << std::setw(12) << std::setprecision(3) << loadSeconds
+              << std::setw(14) << (rssAfter - rssBefore) / 1024
+              << std::setw(12) << std::setprecision(1) << lookupNs << std::endl;
+    for (auto& kv : weightMap) {
+        free(const_cast<void*>(kv.second.values));
+    }
+}
+
+static void runStore(const std::string& path, const std::vector<Blob>& blobs)
+{
+    long rssBefore = peakRssKb();
+    auto start = std::chrono::steady_clock::now();
+    WeightStore weights;
+    std::streambuf* log = std::cout.rdbuf(nullptr);
+    bool loaded = weights.load(path);
+    std::cout.rdbuf(log);
+    double loadSeconds = secondsSince(start);
+    long rssAfter = peakRssKb();
+    if (!loaded) {
+        std::cerr << "WeightStore failed to load " << path << std::endl;
+        return;
+    }
+
+    int64_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kLookupRounds; round++) {
+        for (size_t i = 0; i < blobs.size(); i += 5) {
+            std::string lname = blobs[i].name.substr(0, blobs[i].name.size() - 12);
+            for (const char* suffix : { ".conv.weight", ".bn.weight", ".bn.bias", ".bn.running_mean",
+                     ".bn.running_var" }) {
+                found += weights.contains(WeightName(lname.c_str(), suffix));
+            }
+        }
+    }
+    double lookupNs = secondsSince(start) * 1e9 / found;
+
+    std::cout << std::setw(12) << "WeightStore" << std::setw(10) << weights.size()
+              << std::setw(12) << std::setprecision(3) << loadSeconds
+              << std::setw(14) << (rssAfter - rssBefore) / 1024
+              << std::setw(12) << std::setprecision(1) << lookupNs << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    double millions = argc > 1 ? std::atof(argv[1]) : 7.0;
+    if (millions <= 0.0) {
+        std::cerr << "Usage: " << argv[0] << " [million parameters]" << std::endl;
+        return 1;
+    }
+
+    char dir[] = "/tmp/bench_weight_store_XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Unable to create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::string path = std::string(dir) + "/synthetic.wts";
+    std::vector<Blob> blobs = makeLayout((size_t)(millions * 1e6));
+    if (!writeWts(path, blobs)) {
+        std::cerr << "Unable to write " << path << std::endl;
+        return 1;
+    }
+    std::ifstream file(path, std::ios::ate);
+    std::cout << blobs.size() << " blobs, " << file.tellg() / (1 << 20) << " MB wts file" << std::endl;
+    std::cout << std::setw(12) << "loader" << std::setw(10) << "blobs" << std::setw(12) << "load s"
+              << std::setw(14) << "peak RSS MB" << std::setw(12) << "lookup ns" << std::endl;
+    std::cout << std::fixed;
+
+    bool ok = true;
+    for (auto run : { runMap, runStore }) {
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            run(path, blobs);
+            std::cout.flush();
+            _exit(0);
+        }
+        int status = 0;
+        ok = ok && pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    remove(path.c_str());
+    rmdir(dir);
+    return ok ? 0 : 1;
+}
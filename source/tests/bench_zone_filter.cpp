@@ -0,0 +1,124 @@
+/*
+ * Cost per object of the zone test: the ZoneMask bitmap lookup against an
+ * even-odd test of every polygon, for growing polygon and vertex counts,
+ * plus the one-off rasterization of the bitmap.
+ *
+ *   bench_zone_filter [points] [grid size]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "zone_filter.h"
+
+static bool insidePolygon(const std::vector<ZonePoint>& polygon, float x, float y)
+{
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const ZonePoint& a = polygon[i];
+        const ZonePoint& b = polygon[j];
+        if ((a.y > y) != (b.y > y) && x < a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Star-shaped polygon with a radius jittered per vertex, concave for more
+// than a few vertices
+static std::vector<ZonePoint> makePolygon(std::mt19937& rng, int numVertices)
+{
+    std::uniform_real_distribution<float> center(0.2F, 0.8F);
+    std::uniform_real_distribution<float> radius(0.05F, 0.2F);
+    float cx = center(rng), cy = center(rng);
+    std::vector<ZonePoint> polygon(numVertices);
+    for (int i = 0; i < numVertices; i++) {
+        float angle = 6.2831853F * i / numVertices;
+        float r = radius(rng);
+        polygon[i] = { cx + r * std::cos(angle), cy + r * std::sin(angle) };
+    }
+    return polygon;
+}
+
+int main(int argc, char** argv)
+{
+    int numPoints = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int gridSize = argc > 2 ? std::atoi(argv[2]) : 128;
+    if (numPoints <= 0 || gridSize <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [points] [grid size]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(0.F, 1.F);
+    std::vector<ZonePoint> points(numPoints);
+    for (ZonePoint& p : points) {
+        p = { unit(rng), unit(rng) };
+    }
+
+    std::cout << numPoints << " points, " << gridSize << "x" << gridSize << " grid" << std::endl;
+    std::cout << std::setw(10) << "polygons" << std::setw(10) << "vertices"
+              << std::setw(15) << "rasterize us" << std::setw(12) << "bitmap ns"
+              << std::setw(14) << "polygons ns" << std::setw(10) << "speedup"
+              << std::setw(10) << "agree" << std::endl;
+    std::cout << std::fixed;
+    for (int numPolygons : { 1, 4, 16 }) {
+        for (int numVertices : { 4, 16, 64, 256 }) {
+            std::vector<std::vector<ZonePoint>> polygons;
+            for (int i = 0; i < numPolygons; i++) {
+                polygons.push_back(makePolygon(rng, numVertices));
+            }
+
+            auto r0 = std::chrono::steady_clock::now();
+            ZoneMask mask(gridSize, gridSize);
+            for (const std::vector<ZonePoint>& polygon : polygons) {
+                mask.addPolygon(polygon);
+            }
+            auto r1 = std::chrono::steady_clock::now();
+
+            size_t bitmapHits = 0;
+            for (const ZonePoint& p : points) {
+                bitmapHits += mask.test(p.x, p.y);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+
+            size_t polygonHits = 0, agree = 0;
+            std::vector<bool> inside(points.size());
+            for (size_t i = 0; i < points.size(); i++) {
+                bool hit = false;
+                for (const std::vector<ZonePoint>& polygon : polygons) {
+                    if (insidePolygon(polygon, points[i].x, points[i].y)) {
+                        hit = true;
+                        break;
+                    }
+                }
+                inside[i] = hit;
+                polygonHits += hit;
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            // The bitmap is exact at cell centers only, count how often it
+            // agrees with the exact test at arbitrary points
+            for (size_t i = 0; i < points.size(); i++) {
+                agree += inside[i] == mask.test(points[i].x, points[i].y);
+            }
+
+            double bitmapNs = std::chrono::duration<double>(t1 - r1).count() * 1e9 / numPoints;
+            double polygonNs = std::chrono::duration<double>(t2 - t1).count() * 1e9 / numPoints;
+            std::cout << std::setw(10) << numPolygons << std::setw(10) << numVertices
+                      << std::setw(15) << std::setprecision(1)
+                      << std::chrono::duration<double>(r1 - r0).count() * 1e6
+                      << std::setw(12) << std::setprecision(2) << bitmapNs
+                      << std::setw(14) << polygonNs
+                      << std::setw(10) << std::setprecision(1) << polygonNs / bitmapNs
+                      << std::setw(10) << std::setprecision(4) << (double)agree / numPoints << std::endl;
+            if (bitmapHits == 0 && polygonHits == 0) {
+                std::cerr << "No point inside the zones" << std::endl;
+            }
+        }
+    }
+    return 0;
+}
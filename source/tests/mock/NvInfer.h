@@ -0,0 +1,389 @@
+#ifndef _MOCK_NV_INFER_H_
+#define _MOCK_NV_INFER_H_
+
+/*
+ * Recording stand-in for the part of the TensorRT network API used by the
+ * builder helpers of common.h. INetworkDefinition keeps every layer it is
+ * asked to add with its inputs, weights and settings, so CPU tests can walk
+ * the graph a helper produced. Output shapes are propagated well enough for
+ * the helpers that read them (channels, and the spatial size of convolutions).
+ */
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cuda_runtime_api.h"
+
+namespace nvinfer1
+{
+
+enum class DataType { kFLOAT, kHALF, kINT8, kINT32, kBOOL };
+enum class TensorFormat { kLINEAR };
+typedef TensorFormat PluginFormat;
+
+struct Weights
+{
+    DataType type;
+    const void* values;
+    int64_t count;
+};
+
+struct Dims
+{
+    static const int MAX_DIMS = 8;
+    int nbDims = 0;
+    int d[MAX_DIMS] = {};
+};
+
+struct Dims2 : Dims
+{
+    Dims2(int d0, int d1) { nbDims = 2; d[0] = d0; d[1] = d1; }
+};
+
+struct DimsHW : Dims2
+{
+    DimsHW(int h, int w) : Dims2(h, w) {}
+};
+
+struct Dims3 : Dims
+{
+    Dims3(int d0, int d1, int d2) { nbDims = 3; d[0] = d0; d[1] = d1; d[2] = d2; }
+};
+
+struct Dims4 : Dims
+{
+    Dims4(int d0, int d1, int d2, int d3) { nbDims = 4; d[0] = d0; d[1] = d1; d[2] = d2; d[3] = d3; }
+};
+
+enum class LayerType {
+    kINPUT, kCONVOLUTION, kSCALE, kPOOLING, kACTIVATION, kELEMENTWISE, kCONCATENATION,
+    kCONSTANT, kQUANTIZE, kDEQUANTIZE, kRESIZE, kPLUGIN_V2
+};
+enum class ActivationType { kRELU, kSIGMOID, kLEAKY_RELU };
+enum class ElementWiseOperation { kSUM, kPROD };
+enum class PoolingType { kMAX };
+enum class ScaleMode { kUNIFORM, kCHANNEL, kELEMENTWISE };
+enum class ResizeMode { kNEAREST };
+enum class PluginFieldType { kFLOAT32, kINT32 };
+
+class ILayer;
+
+class ITensor {
+public:
+    Dims getDimensions() const { return dims; }
+    void setDimensions(Dims d) { dims = d; }
+    void setName(const char*) {}
+
+    Dims dims;
+    // Layer producing the tensor, nullptr for network inputs
+    ILayer* producer = nullptr;
+};
+
+class ILayer {
+public:
+    explicit ILayer(LayerType t) : type(t) {}
+    virtual ~ILayer() {}
+
+    LayerType getType() const { return type; }
+    void setName(const char* n) { name = n; }
+    const char* getName() const { return name.c_str(); }
+    int getNbInputs() const { return (int)inputs.size(); }
+    ITensor* getInput(int index) const { return index < (int)inputs.size() ? inputs[index] : nullptr; }
+    int getNbOutputs() const { return (int)outputs.size(); }
+    ITensor* getOutput(int index) const { return outputs[index].get(); }
+    void setInput(int index, ITensor& tensor)
+    {
+        if (index >= (int)inputs.size()) {
+            inputs.resize(index + 1, nullptr);
+        }
+        inputs[index] = &tensor;
+    }
+
+    LayerType type;
+    std::string name;
+    std::vector<ITensor*> inputs;
+    std::vector<std::unique_ptr<ITensor>> outputs;
+};
+
+class IConvolutionLayer : public ILayer {
+public:
+    IConvolutionLayer() : ILayer(LayerType::kCONVOLUTION), kernelSize(1, 1), stride(1, 1), padding(0, 0) {}
+
+    void setStrideNd(Dims s) { stride = DimsHW(s.d[0], s.d[1]); updateOutput(); }
+    void setPaddingNd(Dims p) { padding = DimsHW(p.d[0], p.d[1]); updateOutput(); }
+    void setNbGroups(int g) { groups = g; }
+
+    void updateOutput()
+    {
+        Dims in = inputs[0]->getDimensions();
+        Dims out = in;
+        out.d[0] = nbOutputMaps;
+        for (int i = 0; i < 2; i++) {
+            out.d[i + 1] = (in.d[i + 1] + 2 * padding.d[i] - kernelSize.d[i]) / stride.d[i] + 1;
+        }
+        outputs[0]->setDimensions(out);
+    }
+
+    int nbOutputMaps = 0;
+    DimsHW kernelSize;
+    Weights kernelWeights{ DataType::kFLOAT, nullptr, 0 };
+    Weights biasWeights{ DataType::kFLOAT, nullptr, 0 };
+    DimsHW stride;
+    DimsHW padding;
+    int groups = 1;
+};
+
+class IScaleLayer : public ILayer {
+public:
+    IScaleLayer() : ILayer(LayerType::kSCALE) {}
+    ScaleMode mode = ScaleMode::kUNIFORM;
+    Weights shift{ DataType::kFLOAT, nullptr, 0 };
+    Weights scale{ DataType::kFLOAT, nullptr, 0 };
+    Weights power{ DataType::kFLOAT, nullptr, 0 };
+};
+
+class IPoolingLayer : public ILayer {
+public:
+    IPoolingLayer() : ILayer(LayerType::kPOOLING) {}
+    void setStrideNd(Dims) {}
+    void setPaddingNd(Dims) {}
+};
+
+class IActivationLayer : public ILayer {
+public:
+    IActivationLayer() : ILayer(LayerType::kACTIVATION) {}
+    void setAlpha(float a) { alpha = a; }
+    ActivationType activation = ActivationType::kRELU;
+    float alpha = 0.F;
+};
+
+class IElementWiseLayer : public ILayer {
+public:
+    IElementWiseLayer() : ILayer(LayerType::kELEMENTWISE) {}
+    ElementWiseOperation operation = ElementWiseOperation::kSUM;
+};
+
+class IConcatenationLayer : public ILayer {
+public:
+    IConcatenationLayer() : ILayer(LayerType::kCONCATENATION) {}
+};
+
+class IConstantLayer : public ILayer {
+public:
+    IConstantLayer() : ILayer(LayerType::kCONSTANT) {}
+    Weights weights{ DataType::kFLOAT, nullptr, 0 };
+};
+
+// -1 until setAxis() is called, like a per-tensor scale
+class IQuantizeLayer : public ILayer {
+public:
+    IQuantizeLayer() : ILayer(LayerType::kQUANTIZE) {}
+    void setAxis(int a) { axis = a; }
+    int getAxis() const { return axis; }
+    int axis = -1;
+};
+
+class IDequantizeLayer : public ILayer {
+public:
+    IDequantizeLayer() : ILayer(LayerType::kDEQUANTIZE) {}
+    void setAxis(int a) { axis = a; }
+    int getAxis() const { return axis; }
+    int axis = -1;
+};
+
+class IResizeLayer : public ILayer {
+public:
+    IResizeLayer() : ILayer(LayerType::kRESIZE) {}
+    void setResizeMode(ResizeMode) {}
+    void setOutputDimensions(Dims d) { outputs[0]->setDimensions(d); }
+};
+
+class IPluginV2;
+
+class IPluginV2Layer : public ILayer {
+public:
+    IPluginV2Layer() : ILayer(LayerType::kPLUGIN_V2) {}
+    IPluginV2* plugin = nullptr;
+};
+
+class INetworkDefinition {
+public:
+    ITensor* addInput(const char*, DataType, Dims dims)
+    {
+        m_Inputs.emplace_back(new ITensor());
+        m_Inputs.back()->setDimensions(dims);
+        return m_Inputs.back().get();
+    }
+    ITensor* getInput(int index) const { return m_Inputs[index].get(); }
+    int getNbInputs() const { return (int)m_Inputs.size(); }
+    void markOutput(ITensor&) {}
+
+    IConvolutionLayer* addConvolutionNd(ITensor& input, int nbOutputMaps, Dims kernelSize,
+        Weights kernelWeights, Weights biasWeights)
+    {
+        IConvolutionLayer* layer = add(new IConvolutionLayer(), { &input }, input.getDimensions());
+        layer->nbOutputMaps = nbOutputMaps;
+        layer->kernelSize = DimsHW(kernelSize.d[0], kernelSize.d[1]);
+        layer->kernelWeights = kernelWeights;
+        layer->biasWeights = biasWeights;
+        layer->updateOutput();
+        return layer;
+    }
+    IScaleLayer* addScale(ITensor& input, ScaleMode mode, Weights shift, Weights scale, Weights power)
+    {
+        IScaleLayer* layer = add(new IScaleLayer(), { &input }, input.getDimensions());
+        layer->mode = mode;
+        layer->shift = shift;
+        layer->scale = scale;
+        layer->power = power;
+        return layer;
+    }
+    IPoolingLayer* addPoolingNd(ITensor& input, PoolingType, Dims)
+    {
+        return add(new IPoolingLayer(), { &input }, input.getDimensions());
+    }
+    IActivationLayer* addActivation(ITensor& input, ActivationType type)
+    {
+        IActivationLayer* layer = add(new IActivationLayer(), { &input }, input.getDimensions());
+        layer->activation = type;
+        return layer;
+    }
+    IElementWiseLayer* addElementWise(ITensor& input1, ITensor& input2, ElementWiseOperation op)
+    {
+        IElementWiseLayer* layer = add(new IElementWiseLayer(), { &input1, &input2 }, input1.getDimensions());
+        layer->operation = op;
+        return layer;
+    }
+    IConcatenationLayer* addConcatenation(ITensor* const* inputs, int nbInputs)
+    {
+        Dims dims = inputs[0]->getDimensions();
+        for (int i = 1; i < nbInputs; i++) {
+            dims.d[0] += inputs[i]->getDimensions().d[0];
+        }
+        return add(new IConcatenationLayer(), std::vector<ITensor*>(inputs, inputs + nbInputs), dims);
+    }
+    IConstantLayer* addConstant(Dims dims, Weights weights)
+    {
+        IConstantLayer* layer = add(new IConstantLayer(), {}, dims);
+        layer->weights = weights;
+        return layer;
+    }
+    IQuantizeLayer* addQuantize(ITensor& input, ITensor& scale)
+    {
+        return add(new IQuantizeLayer(), { &input, &scale }, input.getDimensions());
+    }
+    IDequantizeLayer* addDequantize(ITensor& input, ITensor& scale)
+    {
+        return add(new IDequantizeLayer(), { &input, &scale }, input.getDimensions());
+    }
+    IResizeLayer* addResize(ITensor& input)
+    {
+        return add(new IResizeLayer(), { &input }, input.getDimensions());
+    }
+    IPluginV2Layer* addPluginV2(ITensor* const* inputs, int nbInputs, IPluginV2& plugin)
+    {
+        IPluginV2Layer* layer = add(new IPluginV2Layer(), std::vector<ITensor*>(inputs, inputs + nbInputs),
+            inputs[0]->getDimensions());
+        layer->plugin = &plugin;
+        return layer;
+    }
+
+    int getNbLayers() const { return (int)m_Layers.size(); }
+    ILayer* getLayer(int index) const { return m_Layers[index].get(); }
+
+private:
+    template <typename T>
+    T* add(T* layer, std::vector<ITensor*> inputs, Dims outputDims)
+    {
+        m_Layers.emplace_back(layer);
+        layer->inputs = inputs;
+        layer->outputs.emplace_back(new ITensor());
+        layer->outputs[0]->setDimensions(outputDims);
+        layer->outputs[0]->producer = layer;
+        return layer;
+    }
+
+    std::vector<std::unique_ptr<ITensor>> m_Inputs;
+    std::vector<std::unique_ptr<ILayer>> m_Layers;
+};
+
+struct PluginField
+{
+    const char* name;
+    const void* data;
+    PluginFieldType type;
+    int32_t length;
+
+    PluginField(const char* name_ = nullptr, const void* data_ = nullptr,
+        PluginFieldType type_ = PluginFieldType::kFLOAT32, int32_t length_ = 0)
+        : name(name_), data(data_), type(type_), length(length_) {}
+};
+
+struct PluginFieldCollection
+{
+    int32_t nbFields;
+    const PluginField* fields;
+};
+
+class IPluginV2 {
+public:
+    virtual ~IPluginV2() {}
+    virtual const char* getPluginType() const noexcept = 0;
+    virtual const char* getPluginVersion() const noexcept = 0;
+    virtual int getNbOutputs() const noexcept = 0;
+    virtual Dims getOutputDimensions(int index, const Dims* inputs, int nbInputDims) noexcept = 0;
+    virtual bool supportsFormat(DataType type, PluginFormat format) const noexcept = 0;
+    virtual void configureWithFormat(const Dims* inputDims, int nbInputs, const Dims* outputDims,
+        int nbOutputs, DataType type, PluginFormat format, int maxBatchSize) noexcept = 0;
+    virtual int initialize() noexcept = 0;
+    virtual void terminate() noexcept = 0;
+    virtual size_t getWorkspaceSize(int maxBatchSize) const noexcept = 0;
+    virtual int32_t enqueue(int32_t batchSize, void const* const* inputs, void* const* outputs,
+        void* workspace, cudaStream_t stream) noexcept = 0;
+    virtual size_t getSerializationSize() const noexcept = 0;
+    virtual void serialize(void* buffer) const noexcept = 0;
+    virtual void destroy() noexcept = 0;
+    virtual IPluginV2* clone() const noexcept = 0;
+    virtual void setPluginNamespace(const char* pluginNamespace) noexcept = 0;
+    virtual const char* getPluginNamespace() const noexcept = 0;
+};
+
+class IPluginCreator {
+public:
+    virtual ~IPluginCreator() {}
+    virtual const char* getPluginName() const noexcept = 0;
+    virtual const char* getPluginVersion() const noexcept = 0;
+    virtual const PluginFieldCollection* getFieldNames() noexcept = 0;
+    virtual IPluginV2* createPlugin(const char* name, const PluginFieldCollection* fc) noexcept = 0;
+    virtual IPluginV2* deserializePlugin(const char* name, const void* serialData,
+        size_t serialLength) noexcept = 0;
+    virtual void setPluginNamespace(const char* libNamespace) noexcept = 0;
+    virtual const char* getPluginNamespace() const noexcept = 0;
+};
+
+// Empty: helpers creating plugins (SPPF, addYoLoLayer) are not covered
+class IPluginRegistry {
+public:
+    IPluginCreator* getPluginCreator(const char*, const char*, const char* = "") { return nullptr; }
+};
+
+template <typename T>
+class PluginRegistrar {
+public:
+    PluginRegistrar() {}
+};
+
+#define REGISTER_TENSORRT_PLUGIN(name) \
+    static nvinfer1::PluginRegistrar<name> pluginRegistrar##name {}
+
+} // namespace nvinfer1
+
+inline nvinfer1::IPluginRegistry* getPluginRegistry()
+{
+    static nvinfer1::IPluginRegistry registry;
+    return &registry;
+}
+
+#endif // _MOCK_NV_INFER_H_
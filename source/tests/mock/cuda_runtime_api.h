@@ -0,0 +1,20 @@
+#ifndef _MOCK_CUDA_RUNTIME_API_H_
+#define _MOCK_CUDA_RUNTIME_API_H_
+
+/*
+ * Host-only stand-in for the CUDA runtime declarations the builder helpers
+ * and plugin host code see, so CPU tests build without the toolkit.
+ */
+
+#include <stddef.h>
+
+typedef struct CUstream_st* cudaStream_t;
+
+enum cudaError_t { cudaSuccess = 0, cudaErrorInvalidValue = 1 };
+
+// Declared only, tests calling into plugin host code define them
+cudaError_t cudaMemset2DAsync(void* devPtr, size_t pitch, int value, size_t width, size_t height,
+    cudaStream_t stream = 0);
+cudaError_t cudaGetLastError();
+
+#endif // _MOCK_CUDA_RUNTIME_API_H_
@@ -0,0 +1,28 @@
+#ifndef _MOCK_NVDSINFER_CUSTOM_IMPL_H_
+#define _MOCK_NVDSINFER_CUSTOM_IMPL_H_
+
+/*
+ * Stand-in for the part of the DeepStream custom library interface the bbox
+ * parser uses, without the TensorRT parser headers the real one pulls in, so
+ * the parser builds against the other mocks. The parse types themselves come
+ * from the DeepStream nvdsinfer.h, which needs neither TensorRT nor CUDA.
+ */
+
+#include <vector>
+#include "nvdsinfer.h"
+
+typedef bool (*NvDsInferParseCustomFunc)(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+    NvDsInferNetworkInfo const& networkInfo, NvDsInferParseDetectionParams const& detectionParams,
+    std::vector<NvDsInferParseObjectInfo>& objectList);
+
+#define CHECK_CUSTOM_PARSE_FUNC_PROTOTYPE(customParseFunc)                                     \
+    static void checkFunc_##customParseFunc(NvDsInferParseCustomFunc func = customParseFunc)   \
+    {                                                                                          \
+        checkFunc_##customParseFunc();                                                         \
+    };                                                                                         \
+    extern "C" bool customParseFunc(std::vector<NvDsInferLayerInfo> const& outputLayersInfo,   \
+        NvDsInferNetworkInfo const& networkInfo,                                               \
+        NvDsInferParseDetectionParams const& detectionParams,                                  \
+        std::vector<NvDsInferParseObjectInfo>& objectList);
+
+#endif // _MOCK_NVDSINFER_CUSTOM_IMPL_H_
@@ -0,0 +1,228 @@
+/*
+ * Build matrix of yolov5_engine_builder with a stub builder: job planning and
+ * engine naming from a [matrix] section, the worker bound and result order of
+ * runBuildMatrix(), and the JSON manifest.
+ */
+
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#include "build_matrix.h"
+#include "custom_config.h"
+#include "test_utils.h"
+
+static std::string g_Dir;
+
+static bool loadMatrix(const std::string& content, CustomConfig& config)
+{
+    std::string path = g_Dir + "/matrix.txt";
+    std::ofstream output(path, std::ios::trunc);
+    output << content;
+    output.close();
+    bool loaded = config.load(path);
+    remove(path.c_str());
+    return loaded;
+}
+
+static bool plan(const std::string& content, std::vector<BuildJob>& jobs)
+{
+    CustomConfig config;
+    return loadMatrix(content, config) && planBuildMatrix(config, jobs);
+}
+
+// Invalid matrices are reported on std::cerr, quieted here
+static bool planFails(const std::string& content)
+{
+    std::vector<BuildJob> jobs;
+    std::streambuf* log = std::cerr.rdbuf(nullptr);
+    bool planned = plan(content, jobs);
+    std::cerr.rdbuf(log);
+    return !planned;
+}
+
+static void testPlanning()
+{
+    std::vector<BuildJob> jobs;
+    CHECK(plan("[matrix]\n"
+               "models=yolov5s, yolov5m\n"
+               "weights=../data/{model}.wts\n"
+               "batch-sizes=1,4,16\n"
+               "precisions=fp32,fp16\n"
+               "gpu-id=1\n"
+               "output-dir=/engines\n"
+               "sparse-weights=1\n", jobs));
+    // Model-major, then batch size, then precision
+    CHECK_EQ(jobs.size(), (size_t)12);
+    if (jobs.size() == 12) {
+        CHECK_EQ(jobs[0].model, std::string("yolov5s"));
+        CHECK_EQ(jobs[0].weightsPath, std::string("../data/yolov5s.wts"));
+        CHECK_EQ(jobs[0].batchSize, 1);
+        CHECK_EQ(jobs[0].precision, std::string("fp32"));
+        CHECK_EQ(jobs[0].gpuId, 1);
+        CHECK(jobs[0].sparseWeights);
+        CHECK_EQ(jobs[0].enginePath, std::string("/engines/yolov5s_b1_gpu1_fp32.engine"));
+        CHECK_EQ(jobs[3].enginePath, std::string("/engines/yolov5s_b4_gpu1_fp16.engine"));
+        CHECK_EQ(jobs[11].model, std::string("yolov5m"));
+        CHECK_EQ(jobs[11].weightsPath, std::string("../data/yolov5m.wts"));
+        CHECK_EQ(jobs[11].enginePath, std::string("/engines/yolov5m_b16_gpu1_fp16.engine"));
+    }
+    std::set<std::string> engines;
+    for (const BuildJob& job : jobs) {
+        engines.insert(job.enginePath);
+    }
+    CHECK_EQ(engines.size(), jobs.size());
+
+    // Defaults: batch 1, fp16, gpu 0, current directory, {model}.wts
+    CHECK(plan("[matrix]\nmodels=yolov5n\n", jobs));
+    CHECK_EQ(jobs.size(), (size_t)1);
+    if (jobs.size() == 1) {
+        CHECK_EQ(jobs[0].weightsPath, std::string("yolov5n.wts"));
+        CHECK_EQ(jobs[0].enginePath, std::string("./yolov5n_b1_gpu0_fp16.engine"));
+        CHECK(!jobs[0].sparseWeights);
+    }
+
+    // Every occurrence of {model} is replaced
+    CHECK(plan("[matrix]\nmodels=a\nweights={model}/{model}.wts\n", jobs));
+    CHECK(!jobs.empty() && jobs[0].weightsPath == "a/a.wts");
+
+    CHECK(planFails("[matrix]\nbatch-sizes=1\n"));
+    CHECK(planFails("[matrix]\nmodels=yolov5s\nbatch-sizes=1,0\n"));
+    CHECK(planFails("[matrix]\nmodels=yolov5s\nbatch-sizes=x\n"));
+    CHECK(planFails("[matrix]\nmodels=yolov5s\nprecisions=fp16,bf16\n"));
+    CHECK(plan("[matrix]\nmodels=yolov5s\nprecisions=int8\n", jobs));
+}
+
+// Records how many builds run at once; jobs whose batch size is 3 fail
+struct StubBuilder
+{
+    std::atomic<int> inFlight{ 0 };
+    std::atomic<int> maxInFlight{ 0 };
+    std::mutex mutex;
+    std::set<std::string> built;
+
+    BuildResult operator()(const BuildJob& job)
+    {
+        int n = ++inFlight;
+        int seen = maxInFlight;
+        while (n > seen && !maxInFlight.compare_exchange_weak(seen, n)) {
+        }
+        usleep(2000);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            built.insert(job.enginePath);
+        }
+        inFlight--;
+
+        BuildResult result;
+        result.success = job.batchSize != 3;
+        result.engineBytes = job.batchSize * 1000;
+        if (!result.success) {
+            result.error = "stub failure";
+        }
+        return result;
+    }
+};
+
+static std::vector<BuildJob> makeJobs(int count)
+{
+    std::vector<BuildJob> jobs(count);
+    for (int i = 0; i < count; i++) {
+        jobs[i].model = "m" + std::to_string(i);
+        jobs[i].batchSize = i + 1;
+        jobs[i].precision = "fp16";
+        jobs[i].gpuId = 0;
+        jobs[i].enginePath = "e" + std::to_string(i) + ".engine";
+    }
+    return jobs;
+}
+
+static void testRunner()
+{
+    std::streambuf* log = std::cout.rdbuf(nullptr);
+    std::vector<BuildJob> jobs = makeJobs(12);
+    for (int maxWorkers : { 0, 1, 2, 4, 32 }) {
+        StubBuilder builder;
+        std::vector<BuildResult> results = runBuildMatrix(jobs, maxWorkers, std::ref(builder));
+        CHECK(builder.maxInFlight.load() >= 1);
+        CHECK(builder.maxInFlight.load() <= std::max(maxWorkers, 1));
+        CHECK_EQ(builder.built.size(), jobs.size());
+        CHECK_EQ(results.size(), jobs.size());
+        // In job order, with the job copied back and the time measured
+        for (size_t i = 0; i < results.size() && i < jobs.size(); i++) {
+            CHECK_EQ(results[i].job.enginePath, jobs[i].enginePath);
+            CHECK_EQ(results[i].success, jobs[i].batchSize != 3);
+            CHECK_EQ(results[i].engineBytes, (uint64_t)jobs[i].batchSize * 1000);
+            CHECK(results[i].buildSeconds > 0.0);
+        }
+    }
+
+    StubBuilder builder;
+    CHECK(runBuildMatrix(std::vector<BuildJob>(), 4, std::ref(builder)).empty());
+    CHECK_EQ(builder.maxInFlight.load(), 0);
+    std::cout.rdbuf(log);
+}
+
+static void testManifest()
+{
+    std::vector<BuildResult> results(2);
+    results[0].job = makeJobs(1)[0];
+    results[0].job.sparseWeights = true;
+    results[0].success = true;
+    results[0].buildSeconds = 12.5;
+    results[0].engineBytes = 123456789;
+    results[1].job = makeJobs(2)[1];
+    results[1].job.enginePath = "dir \"x\"\\e1.engine";
+    results[1].error = "parse \"failed\"";
+
+    std::string path = g_Dir + "/manifest.json";
+    CHECK(writeManifest(path, results));
+    std::ifstream input(path);
+    std::stringstream content;
+    content << input.rdbuf();
+    std::string json = content.str();
+    remove(path.c_str());
+
+    CHECK_EQ(json,
+        std::string("{\n  \"engines\": [\n"
+                    "    {\"model\": \"m0\", \"batch_size\": 1, \"precision\": \"fp16\", \"gpu_id\": 0, "
+                    "\"sparse_weights\": true, \"engine\": \"e0.engine\", \"success\": true, "
+                    "\"build_seconds\": 12.500, \"engine_bytes\": 123456789},\n"
+                    "    {\"model\": \"m1\", \"batch_size\": 2, \"precision\": \"fp16\", \"gpu_id\": 0, "
+                    "\"sparse_weights\": false, \"engine\": \"dir \\\"x\\\"\\\\e1.engine\", \"success\": false, "
+                    "\"build_seconds\": 0.000, \"engine_bytes\": 0, \"error\": \"parse \\\"failed\\\"\"}\n"
+                    "  ]\n}\n"));
+
+    CHECK(writeManifest(path, std::vector<BuildResult>()));
+    std::ifstream empty(path);
+    std::stringstream emptyContent;
+    emptyContent << empty.rdbuf();
+    CHECK_EQ(emptyContent.str(), std::string("{\n  \"engines\": [\n  ]\n}\n"));
+    remove(path.c_str());
+
+    std::streambuf* log = std::cerr.rdbuf(nullptr);
+    bool written = writeManifest(g_Dir + "/missing/manifest.json", results);
+    std::cerr.rdbuf(log);
+    CHECK(!written);
+}
+
+int main()
+{
+    char dir[] = "/tmp/test_build_matrix_XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Unable to create a temporary directory" << std::endl;
+        return 1;
+    }
+    g_Dir = dir;
+
+    testPlanning();
+    testRunner();
+    testManifest();
+
+    rmdir(dir);
+    return testResult("test_build_matrix");
+}
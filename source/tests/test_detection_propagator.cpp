@@ -0,0 +1,257 @@
+/*
+ * DetectionPropagator on hand-made tracks: constant-velocity extrapolation
+ * over 1 to 4 skipped frames and the velocity smoothing, the confidence decay
+ * with its max-frames and min-confidence cutoffs, the greedy class-aware
+ * matching, tracks ending when no detection continues them, and
+ * removeSource(). Also the [propagation] values loadPropagationParams()
+ * rejects.
+ */
+
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+
+#include "custom_config.h"
+#include "detection_propagator.h"
+#include "test_utils.h"
+
+typedef std::vector<NvDsInferParseObjectInfo> Objects;
+
+static NvDsInferParseObjectInfo makeBox(unsigned int classId, float confidence, float left, float top,
+    float width, float height)
+{
+    NvDsInferParseObjectInfo b;
+    b.classId = classId;
+    b.detectionConfidence = confidence;
+    b.left = left;
+    b.top = top;
+    b.width = width;
+    b.height = height;
+    return b;
+}
+
+static bool nearBox(const NvDsInferParseObjectInfo& a, const NvDsInferParseObjectInfo& b)
+{
+    const float eps = 1e-3F;
+    return a.classId == b.classId && std::fabs(a.left - b.left) <= eps && std::fabs(a.top - b.top) <= eps &&
+        std::fabs(a.width - b.width) <= eps && std::fabs(a.height - b.height) <= eps;
+}
+
+// Velocity of the last measurement only, unless a test smooths it
+static PropagationParams rawVelocity()
+{
+    PropagationParams params;
+    params.velocitySmoothing = 1.F;
+    return params;
+}
+
+static void testExtrapolation()
+{
+    DetectionPropagator propagator(rawVelocity());
+    // Center (120, 110) then (132, 106) five frames later: per frame the
+    // center moves by (2.4, -0.8) and the size by (0.8, 0.4)
+    propagator.update(0, 0, { makeBox(2, 0.9F, 100.F, 100.F, 40.F, 20.F) });
+    propagator.update(0, 5, { makeBox(2, 0.9F, 110.F, 95.F, 44.F, 22.F) });
+
+    Objects objects;
+    for (int skipped = 1; skipped <= 4; skipped++) {
+        propagator.propagate(0, 5 + skipped, objects);
+        CHECK_EQ(objects.size(), (size_t)1);
+        if (objects.size() != 1) {
+            continue;
+        }
+        float width = 44.F + 0.8F * skipped, height = 22.F + 0.4F * skipped;
+        float cx = 132.F + 2.4F * skipped, cy = 106.F - 0.8F * skipped;
+        CHECK(nearBox(objects[0], makeBox(2, 0.F, cx - width / 2, cy - height / 2, width, height)));
+        CHECK_NEAR(objects[0].detectionConfidence, 0.9 * std::pow(0.9, skipped), 1e-5);
+    }
+
+    // Smoothed at 0.5: the velocity moves halfway to each measurement, from
+    // 0 to 1 then to 1.5 pixels per frame for steps of 2 pixels per frame
+    PropagationParams params;
+    params.velocitySmoothing = 0.5F;
+    DetectionPropagator smoothed(params);
+    for (int frame = 0; frame <= 4; frame += 2) {
+        smoothed.update(0, frame, { makeBox(0, 0.9F, 100.F + 2.F * frame, 50.F, 40.F, 40.F) });
+    }
+    smoothed.propagate(0, 6, objects);
+    CHECK_EQ(objects.size(), (size_t)1);
+    if (objects.size() == 1) {
+        CHECK(nearBox(objects[0], makeBox(0, 0.F, 108.F + 2 * 1.5F, 50.F, 40.F, 40.F)));
+    }
+}
+
+static void testDecayCutoffs()
+{
+    PropagationParams params;
+    params.confidenceDecay = 0.8F;
+    params.minConfidence = 0.3F;
+    params.maxFrames = 3;
+    DetectionPropagator propagator(params);
+    propagator.update(0, 10, { makeBox(0, 0.5F, 0.F, 0.F, 40.F, 40.F),
+        makeBox(1, 0.9F, 200.F, 0.F, 40.F, 40.F) });
+
+    // 0.5 falls to 0.32 after two frames and below min-confidence after
+    // three, 0.9 lasts until max-frames
+    const size_t expected[] = { 2, 2, 2, 1, 0, 0 };
+    Objects objects;
+    for (int dt = 0; dt <= 5; dt++) {
+        propagator.propagate(0, 10 + dt, objects);
+        CHECK_EQ(objects.size(), expected[dt]);
+        for (const NvDsInferParseObjectInfo& b : objects) {
+            float initial = b.classId == 0 ? 0.5F : 0.9F;
+            CHECK_NEAR(b.detectionConfidence, initial * std::pow(0.8, dt), 1e-5);
+        }
+    }
+    // Frames before the last inferred one get nothing
+    propagator.propagate(0, 9, objects);
+    CHECK(objects.empty());
+
+    // A decay of 1 carries the confidence unchanged up to max-frames
+    params.confidenceDecay = 1.F;
+    params.maxFrames = 0;
+    DetectionPropagator held(params);
+    held.update(0, 0, { makeBox(0, 0.5F, 0.F, 0.F, 40.F, 40.F) });
+    held.propagate(0, 0, objects);
+    CHECK_EQ(objects.size(), (size_t)1);
+    held.propagate(0, 1, objects);
+    CHECK(objects.empty());
+}
+
+static void testClassAwareMatching()
+{
+    // Overlapping tracks of two classes, each detection closer to the
+    // prediction of the other class's track
+    DetectionPropagator propagator(rawVelocity());
+    propagator.update(0, 0, { makeBox(0, 0.9F, 100.F, 100.F, 40.F, 40.F),
+        makeBox(1, 0.9F, 110.F, 100.F, 40.F, 40.F) });
+    propagator.update(0, 2, { makeBox(1, 0.9F, 104.F, 100.F, 40.F, 40.F),
+        makeBox(0, 0.9F, 112.F, 100.F, 40.F, 40.F) });
+
+    // Class 0 went 100 -> 112 and class 1 went 110 -> 104
+    Objects objects;
+    propagator.propagate(0, 3, objects);
+    CHECK_EQ(objects.size(), (size_t)2);
+    if (objects.size() == 2) {
+        CHECK(nearBox(objects[0], makeBox(1, 0.F, 101.F, 100.F, 40.F, 40.F)));
+        CHECK(nearBox(objects[1], makeBox(0, 0.F, 118.F, 100.F, 40.F, 40.F)));
+    }
+
+    // Within a class the best IoU pairs first: the track at 20 takes the
+    // detection at 18 although the track at 0 also overlaps it enough, and
+    // the detection at -30 overlaps no track and starts at rest
+    DetectionPropagator greedy(rawVelocity());
+    greedy.update(0, 0, { makeBox(0, 0.9F, 0.F, 0.F, 40.F, 40.F), makeBox(0, 0.9F, 20.F, 0.F, 40.F, 40.F) });
+    greedy.update(0, 2, { makeBox(0, 0.9F, 18.F, 0.F, 40.F, 40.F), makeBox(0, 0.9F, -30.F, 0.F, 40.F, 40.F) });
+    greedy.propagate(0, 3, objects);
+    CHECK_EQ(objects.size(), (size_t)2);
+    if (objects.size() == 2) {
+        CHECK(nearBox(objects[0], makeBox(0, 0.F, 17.F, 0.F, 40.F, 40.F)));
+        CHECK(nearBox(objects[1], makeBox(0, 0.F, -30.F, 0.F, 40.F, 40.F)));
+    }
+}
+
+static void testUnmatchedTracksEnd()
+{
+    DetectionPropagator propagator(rawVelocity());
+    propagator.update(0, 0, { makeBox(0, 0.9F, 0.F, 0.F, 40.F, 40.F) });
+    propagator.update(0, 1, { makeBox(0, 0.9F, 5.F, 0.F, 40.F, 40.F) });
+
+    // The detector is authoritative: an inferred frame without the object
+    // ends its track, although its prediction would still be kept
+    propagator.update(0, 2, Objects());
+    Objects objects;
+    propagator.propagate(0, 3, objects);
+    CHECK(objects.empty());
+
+    // A detection away from the prediction starts a new track at rest
+    propagator.update(0, 4, { makeBox(0, 0.9F, 0.F, 0.F, 40.F, 40.F) });
+    propagator.update(0, 5, { makeBox(0, 0.9F, 300.F, 0.F, 40.F, 40.F) });
+    propagator.propagate(0, 7, objects);
+    CHECK_EQ(objects.size(), (size_t)1);
+    if (objects.size() == 1) {
+        CHECK(nearBox(objects[0], makeBox(0, 0.F, 300.F, 0.F, 40.F, 40.F)));
+    }
+}
+
+static void testRemoveSource()
+{
+    DetectionPropagator propagator(rawVelocity());
+    for (int source = 0; source < 2; source++) {
+        propagator.update(source, 0, { makeBox(0, 0.9F, 0.F, 0.F, 40.F, 40.F) });
+        propagator.update(source, 1, { makeBox(0, 0.9F, 4.F, 0.F, 40.F, 40.F) });
+    }
+    propagator.removeSource(0);
+
+    Objects objects;
+    propagator.propagate(0, 2, objects);
+    CHECK(objects.empty());
+    propagator.propagate(1, 2, objects);
+    CHECK_EQ(objects.size(), (size_t)1);
+    if (objects.size() == 1) {
+        CHECK(nearBox(objects[0], makeBox(0, 0.F, 8.F, 0.F, 40.F, 40.F)));
+    }
+
+    // A source added again under the same id keeps no velocity of the old one
+    propagator.update(0, 5, { makeBox(0, 0.9F, 4.F, 0.F, 40.F, 40.F) });
+    propagator.propagate(0, 6, objects);
+    CHECK_EQ(objects.size(), (size_t)1);
+    if (objects.size() == 1) {
+        CHECK(nearBox(objects[0], makeBox(0, 0.F, 4.F, 0.F, 40.F, 40.F)));
+    }
+    propagator.removeSource(7);
+}
+
+static PropagationParams loadParams(const std::string& section)
+{
+    char path[] = "/tmp/test_detection_propagator_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    std::ofstream output(path, std::ios::trunc);
+    output << "[propagation]\n" << section;
+    output.close();
+    CustomConfig config;
+    CHECK(config.load(path));
+    remove(path);
+    // Rejected values are reported on std::cerr, quieted here
+    std::streambuf* log = std::cerr.rdbuf(nullptr);
+    PropagationParams params = loadPropagationParams(config);
+    std::cerr.rdbuf(log);
+    return params;
+}
+
+static void testInvalidParams()
+{
+    const PropagationParams defaults;
+    PropagationParams params = loadParams("confidence-decay=1\nmin-confidence=0\nmax-frames=0\n"
+                                          "match-iou=1\nvelocity-smoothing=0\n");
+    CHECK_NEAR(params.confidenceDecay, 1.F, 0);
+    CHECK_NEAR(params.minConfidence, 0.F, 0);
+    CHECK_EQ(params.maxFrames, 0);
+    CHECK_NEAR(params.matchIoU, 1.F, 0);
+    CHECK_NEAR(params.velocitySmoothing, 0.F, 0);
+
+    for (const char* section : { "confidence-decay=1.2\nmin-confidence=-0.1\nmax-frames=-1\n"
+                                 "match-iou=0\nvelocity-smoothing=1.5\n",
+             "confidence-decay=0\nmin-confidence=2\nmax-frames=-4\nmatch-iou=1.1\nvelocity-smoothing=-0.5\n",
+             "confidence-decay=nan\nmin-confidence=nan\nmatch-iou=nan\nvelocity-smoothing=nan\n" }) {
+        params = loadParams(section);
+        CHECK_NEAR(params.confidenceDecay, defaults.confidenceDecay, 0);
+        CHECK_NEAR(params.minConfidence, defaults.minConfidence, 0);
+        CHECK_EQ(params.maxFrames, defaults.maxFrames);
+        CHECK_NEAR(params.matchIoU, defaults.matchIoU, 0);
+        CHECK_NEAR(params.velocitySmoothing, defaults.velocitySmoothing, 0);
+    }
+}
+
+int main()
+{
+    testExtrapolation();
+    testDecayCutoffs();
+    testClassAwareMatching();
+    testUnmatchedTracksEnd();
+    testRemoveSource();
+    testInvalidParams();
+    return testResult("test_detection_propagator");
+}
@@ -0,0 +1,357 @@
+/*
+ * Shared-memory detection ring: ordering, fromOldest, overrun accounting
+ * through getLost(), frame sequences and permissions across reattaching
+ * producers, slot claims against a producer a lap behind, and concurrent SPSC
+ * and MPMC runs on a small ring where every record must be read whole or
+ * counted lost, never torn.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "detection_ring.h"
+#include "test_utils.h"
+
+// Every field derives from (source, seq), so a record mixing two writes is
+// detected
+static DetectionRecord makeRecord(uint32_t source, uint64_t seq)
+{
+    DetectionRecord r;
+    memset(&r, 0, sizeof(r));
+    r.frameSeq = seq;
+    r.sourceId = source;
+    r.classId = (uint16_t)(seq * 7 + source);
+    r.objectIndex = (uint16_t)(seq >> 16);
+    r.numObjects = (uint16_t)seq;
+    r.left = (float)(seq & 0xffff);
+    r.top = (float)((seq >> 8) & 0xffff);
+    r.width = (float)source;
+    r.height = (float)(seq % 977);
+    r.confidence = (float)(seq % 1000) / 1000.F;
+    return r;
+}
+
+static bool isWhole(const DetectionRecord& r)
+{
+    DetectionRecord expected = makeRecord(r.sourceId, r.frameSeq);
+    return memcmp(&r, &expected, sizeof(r)) == 0;
+}
+
+static std::string ringName(const char* tag)
+{
+    return "/yolov5_test_ring_" + std::string(tag) + "_" + std::to_string(getpid());
+}
+
+static void testSingleThreaded()
+{
+    std::string name = ringName("basic");
+    DetectionRingConsumer missing;
+    CHECK(!missing.open(name));
+
+    DetectionRingProducer producer;
+    // Rounded up to 128
+    CHECK(producer.create(name, 100));
+    DetectionRingConsumer consumer;
+    CHECK(consumer.open(name));
+
+    std::vector<DetectionRecord> records(1024);
+    CHECK_EQ(consumer.pop(records.data(), (int)records.size()), 0);
+    for (uint64_t i = 0; i < 10; i++) {
+        producer.push(makeRecord(0, i));
+    }
+    // Bounded by maxRecords, in push order
+    CHECK_EQ(consumer.pop(records.data(), 4), 4);
+    CHECK_EQ(consumer.pop(records.data() + 4, 100), 6);
+    for (uint64_t i = 0; i < 10; i++) {
+        CHECK_EQ(records[i].frameSeq, i);
+        CHECK(isWhole(records[i]));
+    }
+    CHECK_EQ(consumer.getLost(), (uint64_t)0);
+
+    // 128 slots: 300 more records overrun the consumer by 172
+    for (uint64_t i = 10; i < 310; i++) {
+        producer.push(makeRecord(0, i));
+    }
+    int count = consumer.pop(records.data(), (int)records.size());
+    CHECK_EQ(count, 128);
+    CHECK_EQ(consumer.getLost(), (uint64_t)172);
+    CHECK_EQ(records[0].frameSeq, (uint64_t)182);
+    CHECK_EQ(records[count - 1].frameSeq, (uint64_t)309);
+
+    // A late consumer reads the last lap with fromOldest, nothing without
+    DetectionRingConsumer oldest, latest;
+    CHECK(oldest.open(name, true));
+    CHECK(latest.open(name));
+    CHECK_EQ(oldest.pop(records.data(), (int)records.size()), 128);
+    CHECK_EQ(records[0].frameSeq, (uint64_t)182);
+    CHECK_EQ(latest.pop(records.data(), (int)records.size()), 0);
+    CHECK_EQ(oldest.getLost() + latest.getLost(), (uint64_t)0);
+
+    // A second producer with the same capacity shares the ring
+    DetectionRingProducer second;
+    CHECK(second.create(name, 128));
+    second.push(makeRecord(1, 310));
+    producer.push(makeRecord(0, 311));
+    CHECK_EQ(consumer.pop(records.data(), (int)records.size()), 2);
+    CHECK(records[0].sourceId == 1 && records[0].frameSeq == 310);
+    CHECK(records[1].sourceId == 0 && records[1].frameSeq == 311);
+
+    // Frame sequences are shared through the ring and carry on when a
+    // producer reattaches, a ring of another capacity starts over
+    CHECK_EQ(producer.nextFrameSeq(), (uint64_t)0);
+    CHECK_EQ(second.nextFrameSeq(), (uint64_t)1);
+    {
+        DetectionRingProducer restarted;
+        CHECK(restarted.create(name, 128));
+        CHECK_EQ(restarted.nextFrameSeq(), (uint64_t)2);
+    }
+    DetectionRingProducer resized;
+    CHECK(resized.create(name, 256));
+    CHECK_EQ(resized.nextFrameSeq(), (uint64_t)0);
+    producer.unlink();
+    CHECK(!missing.open(name));
+}
+
+static mode_t ringMode(const std::string& name)
+{
+    struct stat st;
+    return stat(("/dev/shm" + name).c_str(), &st) == 0 ? st.st_mode & 0777 : 0;
+}
+
+static void testPermissions()
+{
+    std::string name = ringName("mode");
+    mode_t mask = umask(022);
+    {
+        DetectionRingProducer producer;
+        CHECK(producer.create(name, 16));
+        CHECK_EQ(ringMode(name), (mode_t)0600);
+        // Consumers attach read-only
+        DetectionRingConsumer consumer;
+        CHECK(consumer.open(name));
+    }
+    // Reattaching applies the mode to the existing ring, past the umask
+    DetectionRingProducer group;
+    CHECK(group.create(name, 16, 0660));
+    CHECK_EQ(ringMode(name), (mode_t)0660);
+    DetectionRingProducer narrowed;
+    CHECK(narrowed.create(name, 16, 0640));
+    CHECK_EQ(ringMode(name), (mode_t)0640);
+    group.unlink();
+    umask(mask);
+}
+
+// Writable view of a producer's ring, to stand in for other producers
+struct RingView
+{
+    DetectionRingHeader* header = nullptr;
+    DetectionRingSlot* slots = nullptr;
+    size_t size = 0;
+
+    bool map(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            return false;
+        }
+        size = st.st_size;
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        header = static_cast<DetectionRingHeader*>(addr);
+        slots = reinterpret_cast<DetectionRingSlot*>(header + 1);
+        return true;
+    }
+    ~RingView()
+    {
+        if (header) {
+            munmap(header, size);
+        }
+    }
+
+    // Takes the next position and claims its slot like a producer that then
+    // stalls before publishing
+    uint64_t stallProducer(const DetectionRecord& partial)
+    {
+        uint64_t pos = header->head.fetch_add(1);
+        DetectionRingSlot& slot = slots[pos & (header->capacity - 1)];
+        slot.seq.store(2 * pos + 1);
+        slot.record = partial;
+        return pos;
+    }
+};
+
+static void testSlotClaim()
+{
+    std::string name = ringName("claim");
+    DetectionRingProducer producer;
+    CHECK(producer.create(name, 2));
+    RingView view;
+    CHECK(view.map(name));
+    if (!view.header) {
+        return;
+    }
+    DetectionRingConsumer consumer;
+    CHECK(consumer.open(name, true));
+    producer.push(makeRecord(0, 0));
+    producer.push(makeRecord(0, 1));
+
+    // Position 2 is claimed and half written in slot 0; the producer of
+    // position 4 a lap ahead must wait for its publish rather than write too
+    DetectionRecord partial = makeRecord(1, 2);
+    partial.confidence = 0.F;
+    uint64_t stalled = view.stallProducer(partial);
+    CHECK_EQ(stalled, (uint64_t)2);
+    std::atomic<bool> pushed(false);
+    std::thread lapAhead([&]() {
+        producer.push(makeRecord(0, 3));
+        producer.push(makeRecord(0, 4));
+        pushed = true;
+    });
+    usleep(20000);
+    CHECK(!pushed);
+    CHECK_EQ(view.slots[0].seq.load(), 2 * stalled + 1);
+    CHECK(memcmp(&view.slots[0].record, &partial, sizeof(partial)) == 0);
+    view.slots[0].record = makeRecord(1, 2);
+    view.slots[0].seq.store(2 * stalled + 2);
+    lapAhead.join();
+    CHECK_EQ(view.slots[0].seq.load(), (uint64_t)10);
+    CHECK(isWhole(view.slots[0].record) && view.slots[0].record.frameSeq == 4);
+
+    std::vector<DetectionRecord> records(8);
+    int count = consumer.pop(records.data(), (int)records.size());
+    CHECK_EQ(count, 2);
+    CHECK(count == 2 && records[0].frameSeq == 3 && records[1].frameSeq == 4);
+    CHECK_EQ(consumer.getLost(), (uint64_t)3);
+
+    // A producer that never publishes position 5 is taken over by the next
+    // lap after a timeout, and its position counts as lost
+    stalled = view.stallProducer(partial);
+    CHECK_EQ(stalled, (uint64_t)5);
+    auto start = std::chrono::steady_clock::now();
+    producer.push(makeRecord(0, 6));
+    producer.push(makeRecord(0, 7));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(100));
+    CHECK_EQ(view.slots[1].seq.load(), (uint64_t)16);
+    count = consumer.pop(records.data(), (int)records.size());
+    CHECK(count == 2 && records[0].frameSeq == 6 && records[1].frameSeq == 7 && isWhole(records[1]));
+    CHECK_EQ(consumer.getLost(), (uint64_t)4);
+    producer.unlink();
+}
+
+struct ConsumerStats
+{
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t torn = 0;
+    uint64_t outOfOrder = 0;
+};
+
+// Pops until all producers are done and the ring is drained
+static void consume(const std::string& name, int numSources, const std::atomic<int>& running,
+    ConsumerStats& stats)
+{
+    DetectionRingConsumer consumer;
+    if (!consumer.open(name, true)) {
+        stats.torn = ~0ULL;
+        return;
+    }
+    std::vector<int64_t> last(numSources, -1);
+    std::vector<DetectionRecord> records(256);
+    while (true) {
+        bool done = running == 0;
+        int count = consumer.pop(records.data(), (int)records.size());
+        for (int i = 0; i < count; i++) {
+            const DetectionRecord& r = records[i];
+            if (!isWhole(r) || r.sourceId >= (uint32_t)numSources) {
+                stats.torn++;
+                continue;
+            }
+            // Records of one producer come out in its push order
+            if ((int64_t)r.frameSeq <= last[r.sourceId]) {
+                stats.outOfOrder++;
+            }
+            last[r.sourceId] = (int64_t)r.frameSeq;
+        }
+        stats.received += count;
+        if (done && count == 0) {
+            break;
+        }
+    }
+    stats.lost = consumer.getLost();
+}
+
+static void runConcurrent(const char* tag, int numProducers, int numConsumers, uint64_t perProducer,
+    uint64_t capacity)
+{
+    std::string name = ringName(tag);
+    DetectionRingProducer producer;
+    CHECK(producer.create(name, capacity));
+
+    std::atomic<int> running(numProducers);
+    std::vector<ConsumerStats> stats(numConsumers);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < numConsumers; c++) {
+        consumers.emplace_back(consume, name, numProducers, std::cref(running), std::ref(stats[c]));
+    }
+    // Consumers open fromOldest before the first push, so they see everything
+    usleep(10000);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < numProducers; p++) {
+        producers.emplace_back([&producer, &running, p, perProducer]() {
+            for (uint64_t i = 0; i < perProducer; i++) {
+                producer.push(makeRecord(p, i));
+            }
+            running--;
+        });
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    for (std::thread& t : consumers) {
+        t.join();
+    }
+    producer.unlink();
+
+    const uint64_t total = perProducer * numProducers;
+    for (const ConsumerStats& s : stats) {
+        CHECK_EQ(s.torn, (uint64_t)0);
+        CHECK_EQ(s.outOfOrder, (uint64_t)0);
+        // Every record read or counted lost, exactly once
+        CHECK_EQ(s.received + s.lost, total);
+        CHECK(s.received > 0);
+        if (capacity >= total) {
+            CHECK_EQ(s.lost, (uint64_t)0);
+        }
+    }
+}
+
+static void testConcurrent()
+{
+    // Small rings so the consumers are overrun and slots rewritten mid-read
+    runConcurrent("spsc", 1, 1, 2000000, 256);
+    runConcurrent("mpsc", 4, 1, 500000, 256);
+    runConcurrent("mpmc", 4, 3, 500000, 64);
+    // Large enough that nothing is lost
+    runConcurrent("spsc_large", 1, 1, 100000, 1 << 17);
+}
+
+int main()
+{
+    testSingleThreaded();
+    testPermissions();
+    testSlotClaim();
+    testConcurrent();
+    return testResult("test_detection_ring");
+}
@@ -0,0 +1,330 @@
+/*
+ * EngineReloader with a fake engine built from a small model file: a settled
+ * change, a file still being written, a failed rebuild that keeps the old
+ * engine, an old engine kept alive by a batch in flight, and checkNow()
+ * calls racing the watch thread.
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "engine_reloader.h"
+#include "test_utils.h"
+
+struct FakeEngine
+{
+    explicit FakeEngine(const std::string& m) : model(m) { alive++; }
+    ~FakeEngine() { alive--; }
+
+    std::string model;
+    static std::atomic<int> alive;
+};
+
+std::atomic<int> FakeEngine::alive(0);
+
+// Builds from the file content; a file not ending in "end" is incomplete and
+// one starting with "bad" does not parse
+struct FakeBuilder
+{
+    std::atomic<int> builds{ 0 };
+    std::atomic<int> inFlight{ 0 };
+    std::atomic<int> maxInFlight{ 0 };
+    // While set, builds wait for it to clear
+    std::atomic<bool> hold{ false };
+    std::atomic<bool> holding{ false };
+
+    std::shared_ptr<FakeEngine> operator()(const std::string& path)
+    {
+        int n = ++inFlight;
+        int seen = maxInFlight;
+        while (n > seen && !maxInFlight.compare_exchange_weak(seen, n)) {
+        }
+        builds++;
+        holding = hold.load();
+        while (hold) {
+            usleep(1000);
+        }
+        holding = false;
+
+        std::ifstream input(path);
+        std::stringstream content;
+        content << input.rdbuf();
+        std::string model = content.str();
+        usleep(200);
+        inFlight--;
+        if (model.size() < 3 || model.compare(model.size() - 3, 3, "end") != 0 ||
+            model.compare(0, 3, "bad") == 0) {
+            return nullptr;
+        }
+        return std::make_shared<FakeEngine>(model);
+    }
+};
+
+// Replaces the file in one step and moves its mtime forward, so same-size
+// rewrites within the file system's timestamp resolution still count as
+// changes. Partial writes are made explicit by the tests.
+static void writeModel(const std::string& path, const std::string& content)
+{
+    static time_t mtime = 1000000000;
+    std::string tmpPath = path + ".tmp";
+    std::ofstream output(tmpPath, std::ios::trunc);
+    output << content;
+    output.close();
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = ++mtime;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    utimensat(AT_FDCWD, tmpPath.c_str(), times, 0);
+    rename(tmpPath.c_str(), path.c_str());
+}
+
+typedef EngineReloader<FakeEngine> Reloader;
+
+// The watch thread polls once an hour, the tests drive checkNow() themselves
+static const int kNoPolling = 3600 * 1000;
+
+static void testSettledChange(const std::string& path)
+{
+    writeModel(path, "v1 end");
+    FakeBuilder builder;
+    Reloader reloader(path, std::ref(builder), kNoPolling);
+    CHECK(reloader.start());
+    CHECK_EQ(reloader.getVersion(), (uint64_t)1);
+    CHECK_EQ(reloader.acquire()->model, std::string("v1 end"));
+
+    // Unchanged file, nothing to do
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 1);
+
+    // The first poll after the change only notes it, the next one rebuilds
+    writeModel(path, "v2 end");
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 1);
+    CHECK(reloader.getState() == Reloader::State::kIdle);
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 2);
+    CHECK(reloader.getState() == Reloader::State::kPending);
+    // Not swapped until the next batch boundary
+    CHECK_EQ(reloader.getVersion(), (uint64_t)1);
+
+    std::shared_ptr<FakeEngine> engine = reloader.acquire();
+    CHECK_EQ(engine->model, std::string("v2 end"));
+    CHECK_EQ(reloader.getVersion(), (uint64_t)2);
+    CHECK(reloader.getState() == Reloader::State::kIdle);
+    CHECK(reloader.acquire() == engine);
+
+    // Two builds before a batch boundary: the newer one wins
+    writeModel(path, "v3 end");
+    reloader.checkNow();
+    reloader.checkNow();
+    writeModel(path, "v4 end");
+    reloader.checkNow();
+    reloader.checkNow();
+    CHECK_EQ(reloader.acquire()->model, std::string("v4 end"));
+    CHECK_EQ(reloader.getVersion(), (uint64_t)3);
+    engine.reset();
+    reloader.stop();
+}
+
+static void testHalfWrittenFile(const std::string& path)
+{
+    writeModel(path, "v1 end");
+    FakeBuilder builder;
+    Reloader reloader(path, std::ref(builder), kNoPolling);
+    CHECK(reloader.start());
+
+    // The file grows between polls: never built half written
+    writeModel(path, "v2");
+    reloader.checkNow();
+    writeModel(path, "v2 ....");
+    reloader.checkNow();
+    writeModel(path, "v2 ........ end");
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 1);
+    CHECK(reloader.getState() == Reloader::State::kIdle);
+
+    // Settled
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 2);
+    CHECK_EQ(reloader.acquire()->model, std::string("v2 ........ end"));
+
+    // A removed file is not a new model
+    remove(path.c_str());
+    reloader.checkNow();
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 2);
+    CHECK_EQ(reloader.acquire()->model, std::string("v2 ........ end"));
+    reloader.stop();
+}
+
+static void testFailedRebuild(const std::string& path)
+{
+    writeModel(path, "v1 end");
+    FakeBuilder builder;
+    Reloader reloader(path, std::ref(builder), kNoPolling);
+    CHECK(reloader.start());
+
+    writeModel(path, "bad end");
+    reloader.checkNow();
+    reloader.checkNow();
+    CHECK_EQ(builder.builds.load(), 2);
+    CHECK(reloader.getState() == Reloader::State::kFailed);
+    // The old engine keeps serving
+    CHECK_EQ(reloader.acquire()->model, std::string("v1 end"));
+    CHECK_EQ(reloader.getVersion(), (uint64_t)1);
+    CHECK(reloader.getState() == Reloader::State::kFailed);
+
+    // A fixed file recovers
+    writeModel(path, "v2 end");
+    reloader.checkNow();
+    reloader.checkNow();
+    CHECK(reloader.getState() == Reloader::State::kPending);
+    CHECK_EQ(reloader.acquire()->model, std::string("v2 end"));
+    CHECK(reloader.getState() == Reloader::State::kIdle);
+    reloader.stop();
+
+    // No first engine, no start
+    writeModel(path, "bad end");
+    Reloader broken(path, std::ref(builder), kNoPolling);
+    CHECK(!broken.start());
+}
+
+static void testBatchInFlight(const std::string& path)
+{
+    CHECK_EQ(FakeEngine::alive.load(), 0);
+    writeModel(path, "v1 end");
+    FakeBuilder builder;
+    Reloader reloader(path, std::ref(builder), kNoPolling);
+    CHECK(reloader.start());
+
+    // A batch starts on v1 and is still running when v2 is swapped in
+    std::shared_ptr<FakeEngine> batch = reloader.acquire();
+    std::weak_ptr<FakeEngine> old = batch;
+    writeModel(path, "v2 end");
+    reloader.checkNow();
+    reloader.checkNow();
+    std::shared_ptr<FakeEngine> next = reloader.acquire();
+    CHECK_EQ(next->model, std::string("v2 end"));
+    CHECK(!old.expired());
+    CHECK_EQ(batch->model, std::string("v1 end"));
+    CHECK_EQ(FakeEngine::alive.load(), 2);
+
+    // Released with the last batch holding it
+    batch.reset();
+    CHECK(old.expired());
+    CHECK_EQ(FakeEngine::alive.load(), 1);
+    next.reset();
+    reloader.stop();
+}
+
+static void testAcquireDuringBuild(const std::string& path)
+{
+    writeModel(path, "v1 end");
+    FakeBuilder builder;
+    Reloader reloader(path, std::ref(builder), kNoPolling);
+    CHECK(reloader.start());
+
+    // v2 is pending, v3 is being built when the next batch starts
+    writeModel(path, "v2 end");
+    reloader.checkNow();
+    reloader.checkNow();
+    CHECK(reloader.getState() == Reloader::State::kPending);
+    writeModel(path, "v3 end");
+    reloader.checkNow();
+    builder.hold = true;
+    std::thread building([&reloader]() { reloader.checkNow(); });
+    while (!builder.holding) {
+        usleep(1000);
+    }
+    CHECK(reloader.getState() == Reloader::State::kBuilding);
+
+    CHECK_EQ(reloader.acquire()->model, std::string("v2 end"));
+    // Still building, not idle
+    CHECK(reloader.getState() == Reloader::State::kBuilding);
+
+    builder.hold = false;
+    building.join();
+    CHECK(reloader.getState() == Reloader::State::kPending);
+    CHECK_EQ(reloader.acquire()->model, std::string("v3 end"));
+    CHECK_EQ(reloader.getVersion(), (uint64_t)3);
+    reloader.stop();
+}
+
+static void testConcurrentChecks(const std::string& path)
+{
+    writeModel(path, "v0 end");
+    FakeBuilder builder;
+    // The watch thread polls every millisecond, against four threads calling
+    // checkNow() and one acquiring like the inference thread
+    Reloader reloader(path, std::ref(builder), 1);
+    CHECK(reloader.start());
+    // Quiet the rebuild log of the many changes below
+    std::streambuf* log = std::cout.rdbuf(nullptr);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> checkers;
+    for (int t = 0; t < 4; t++) {
+        checkers.emplace_back([&]() {
+            while (!done) {
+                reloader.checkNow();
+            }
+        });
+    }
+    std::thread batches([&]() {
+        uint64_t version = 0;
+        while (!done) {
+            std::shared_ptr<FakeEngine> engine = reloader.acquire();
+            uint64_t v = reloader.getVersion();
+            CHECK(engine && v >= version);
+            version = v;
+        }
+    });
+
+    const int numChanges = 50;
+    for (int i = 1; i <= numChanges; i++) {
+        writeModel(path, "v" + std::to_string(i) + " end");
+        usleep(5000);
+    }
+    // Wait for the last change to be picked up
+    for (int i = 0; i < 2000 && reloader.acquire()->model != "v50 end"; i++) {
+        usleep(1000);
+    }
+    done = true;
+    for (std::thread& t : checkers) {
+        t.join();
+    }
+    batches.join();
+    reloader.stop();
+    std::cout.rdbuf(log);
+
+    CHECK_EQ(reloader.acquire()->model, std::string("v50 end"));
+    // Builds never overlap and every settled change is built once
+    CHECK_EQ(builder.maxInFlight.load(), 1);
+    CHECK(builder.builds.load() <= numChanges + 1);
+}
+
+int main()
+{
+    char dir[] = "/tmp/test_engine_reloader_XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Unable to create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::string path = std::string(dir) + "/model.wts";
+
+    testSettledChange(path);
+    testHalfWrittenFile(path);
+    testFailedRebuild(path);
+    testBatchInFlight(path);
+    testAcquireDuringBuild(path);
+    testConcurrentChecks(path);
+
+    remove(path.c_str());
+    rmdir(dir);
+    CHECK_EQ(FakeEngine::alive.load(), 0);
+    return testResult("test_engine_reloader");
+}
@@ -0,0 +1,260 @@
+/*
+ * ModelSwitchPolicy on simulated load traces: sustained overload, spikes
+ * shorter than the down-switch count, recovery after the up-switch count and
+ * oscillating load, with the batches at which the variant switches. Also
+ * the [model-switch] values loadModelSwitchParams() rejects.
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+
+#include "custom_config.h"
+#include "model_switch.h"
+#include "test_utils.h"
+
+struct Sample
+{
+    int queueDepth;
+    float latencyMs;
+};
+
+// Load seen by batch i, which runs on the given variant
+typedef std::function<Sample(int, ModelSwitchPolicy::Variant)> Trace;
+
+// Runs numBatches through the policy, returns the batches after which it switched
+static std::vector<int> run(ModelSwitchPolicy& policy, int numBatches, const Trace& trace)
+{
+    std::vector<int> switches;
+    for (int i = 0; i < numBatches; i++) {
+        ModelSwitchPolicy::Variant active = policy.getActive();
+        Sample sample = trace(i, active);
+        if (policy.update(sample.queueDepth, sample.latencyMs) != active) {
+            switches.push_back(i);
+        }
+    }
+    CHECK_EQ((int)switches.size(), policy.getSwitchCount());
+    return switches;
+}
+
+// 45 ms on the accurate variant, 20 ms on the fast one
+static float latencyOf(ModelSwitchPolicy::Variant variant)
+{
+    return variant == ModelSwitchPolicy::kAccurate ? 45.F : 20.F;
+}
+
+static void testSustainedOverload()
+{
+    ModelSwitchParams params;
+    ModelSwitchPolicy policy(params);
+    CHECK_EQ(policy.getActiveModel(), std::string("yolov5m"));
+
+    // Queue backed up and over budget: down after downSwitchBatches, and the
+    // fast variant keeps it there as long as the queue stays deep
+    std::vector<int> switches = run(policy, 1000, [](int, ModelSwitchPolicy::Variant v) {
+        return Sample{ 6, latencyOf(v) };
+    });
+    CHECK_EQ(switches.size(), (size_t)1);
+    CHECK(switches.size() == 1 && switches[0] == params.downSwitchBatches - 1);
+    CHECK_EQ(policy.getActive(), ModelSwitchPolicy::kFast);
+    CHECK_EQ(policy.getActiveModel(), std::string("yolov5s"));
+    CHECK_NEAR(policy.getLatency(ModelSwitchPolicy::kFast), 20.F, 1e-3);
+
+    // Over budget alone, with an empty queue, also switches down
+    ModelSwitchPolicy slow(params);
+    switches = run(slow, 10, [](int, ModelSwitchPolicy::Variant) { return Sample{ 0, 40.F }; });
+    CHECK(switches.size() == 1 && switches[0] == params.downSwitchBatches - 1);
+}
+
+static void testShortSpike()
+{
+    ModelSwitchParams params;
+
+    // Queue spikes one batch shorter than downSwitchBatches, every 20 batches
+    ModelSwitchPolicy policy(params);
+    std::vector<int> switches = run(policy, 1000, [&params](int i, ModelSwitchPolicy::Variant) {
+        return Sample{ i % 20 < params.downSwitchBatches - 1 ? 8 : 1, 25.F };
+    });
+    CHECK(switches.empty());
+    CHECK_EQ(policy.getActive(), ModelSwitchPolicy::kAccurate);
+
+    // A single slow batch is absorbed by the moving average: 25 -> 31 ms
+    ModelSwitchPolicy slowBatch(params);
+    switches = run(slowBatch, 100, [](int i, ModelSwitchPolicy::Variant) {
+        return Sample{ 1, i == 50 ? 55.F : 25.F };
+    });
+    CHECK(switches.empty());
+
+    // A spike of exactly downSwitchBatches switches at its last batch
+    ModelSwitchPolicy longer(params);
+    switches = run(longer, 100, [&params](int i, ModelSwitchPolicy::Variant) {
+        return Sample{ i >= 10 && i < 10 + params.downSwitchBatches ? 8 : 1, 25.F };
+    });
+    CHECK(switches.size() == 1 && switches[0] == 10 + params.downSwitchBatches - 1);
+}
+
+static void testRecovery()
+{
+    ModelSwitchParams params;
+    ModelSwitchPolicy policy(params);
+
+    // Overload for 100 batches, then the queue drains and the fast variant
+    // runs at 10 ms, below idleLatencyRatio of the budget
+    std::vector<int> switches = run(policy, 400, [](int i, ModelSwitchPolicy::Variant v) {
+        if (i < 100) {
+            return Sample{ 6, latencyOf(v) };
+        }
+        return Sample{ 0, v == ModelSwitchPolicy::kAccurate ? 25.F : 10.F };
+    });
+    CHECK_EQ(switches.size(), (size_t)2);
+    CHECK(switches.size() == 2 && switches[0] == params.downSwitchBatches - 1);
+    // The fast average takes two batches to fall from 20 ms to below 16.65 ms
+    CHECK(switches.size() == 2 && switches[1] == 101 + params.upSwitchBatches - 1);
+    CHECK_EQ(policy.getActive(), ModelSwitchPolicy::kAccurate);
+
+    // Drained queue but the fast variant uses more than idleLatencyRatio of
+    // the budget: stays fast
+    ModelSwitchPolicy busy(params);
+    switches = run(busy, 400, [](int i, ModelSwitchPolicy::Variant v) {
+        return Sample{ i < 100 ? 6 : 0, v == ModelSwitchPolicy::kAccurate ? 45.F : 20.F };
+    });
+    CHECK_EQ(switches.size(), (size_t)1);
+
+    // One busy batch in the idle stretch restarts the up-switch count
+    ModelSwitchPolicy restarted(params);
+    switches = run(restarted, 400, [](int i, ModelSwitchPolicy::Variant v) {
+        if (i < 100) {
+            return Sample{ 6, latencyOf(v) };
+        }
+        return Sample{ i == 130 ? 3 : 0, v == ModelSwitchPolicy::kAccurate ? 25.F : 10.F };
+    });
+    CHECK(switches.size() == 2 && switches[1] == 131 + params.upSwitchBatches - 1);
+}
+
+// Batches spent on each variant between switches
+static void checkDwell(const std::vector<int>& switches, const ModelSwitchParams& params)
+{
+    for (size_t s = 1; s < switches.size(); s++) {
+        int dwell = switches[s] - switches[s - 1];
+        // Odd runs are on the fast variant
+        int needed = s % 2 ? params.upSwitchBatches : params.downSwitchBatches;
+        CHECK(dwell >= needed);
+    }
+}
+
+static void testOscillatingLoad()
+{
+    ModelSwitchParams params;
+    const int numBatches = 6000;
+
+    // Load alternating faster than upSwitchBatches: one switch down, then no
+    // return to the accurate variant while the idle stretches are too short
+    for (int period : { 2, 10, 50, 100 }) {
+        ModelSwitchPolicy policy(params);
+        std::vector<int> switches = run(policy, numBatches, [period](int i, ModelSwitchPolicy::Variant v) {
+            bool overloaded = (i / (period / 2)) % 2 == 0;
+            return Sample{ overloaded ? 6 : 0, overloaded ? latencyOf(v) : 10.F };
+        });
+        CHECK(switches.size() <= 1);
+    }
+
+    // Idle stretches longer than upSwitchBatches: at most one round trip per period
+    for (int period : { 200, 500 }) {
+        ModelSwitchPolicy policy(params);
+        std::vector<int> switches = run(policy, numBatches, [period](int i, ModelSwitchPolicy::Variant v) {
+            bool overloaded = i % period < period / 2;
+            return Sample{ overloaded ? 6 : 0, overloaded ? latencyOf(v) : 10.F };
+        });
+        CHECK_EQ((int)switches.size(), 2 * (numBatches / period));
+        checkDwell(switches, params);
+    }
+
+    // Load that depends on the variant: the accurate one hovers around the
+    // budget and backs the queue up, the fast one drains it. The policy flips
+    // back and forth but never faster than the hysteresis allows.
+    ModelSwitchPolicy policy(params);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> jitter(-6.F, 6.F);
+    float queue = 0.F;
+    std::vector<int> switches = run(policy, numBatches, [&](int, ModelSwitchPolicy::Variant v) {
+        float latency = (v == ModelSwitchPolicy::kAccurate ? 33.F : 11.F) + jitter(rng);
+        // One frame arrives per 33.3 ms, one is served per batch
+        queue = std::max(0.F, queue + latency / params.latencyBudgetMs - 1.F);
+        return Sample{ (int)queue, latency };
+    });
+    CHECK(switches.size() >= 2);
+    CHECK((int)switches.size() <= 2 * numBatches / (params.downSwitchBatches + params.upSwitchBatches) + 1);
+    checkDwell(switches, params);
+
+    // Same trace without hysteresis flips far more often
+    ModelSwitchParams eager = params;
+    eager.downSwitchBatches = 1;
+    eager.upSwitchBatches = 1;
+    ModelSwitchPolicy eagerPolicy(eager);
+    rng.seed(1);
+    queue = 0.F;
+    std::vector<int> eagerSwitches = run(eagerPolicy, numBatches, [&](int, ModelSwitchPolicy::Variant v) {
+        float latency = (v == ModelSwitchPolicy::kAccurate ? 33.F : 11.F) + jitter(rng);
+        queue = std::max(0.F, queue + latency / params.latencyBudgetMs - 1.F);
+        return Sample{ (int)queue, latency };
+    });
+    CHECK(eagerSwitches.size() > 5 * switches.size());
+}
+
+static ModelSwitchParams loadParams(const std::string& section)
+{
+    char path[] = "/tmp/test_model_switch_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    std::ofstream output(path, std::ios::trunc);
+    output << "[model-switch]\n" << section;
+    output.close();
+    CustomConfig config;
+    CHECK(config.load(path));
+    remove(path);
+    // Rejected values are reported on std::cerr, quieted here
+    std::streambuf* log = std::cerr.rdbuf(nullptr);
+    ModelSwitchParams params = loadModelSwitchParams(config);
+    std::cerr.rdbuf(log);
+    return params;
+}
+
+static void testInvalidParams()
+{
+    const ModelSwitchParams defaults;
+    ModelSwitchParams params = loadParams("down-switch-batches=5\nup-switch-batches=30\nsmoothing=1\n");
+    CHECK_EQ(params.downSwitchBatches, 5);
+    CHECK_EQ(params.upSwitchBatches, 30);
+    CHECK_NEAR(params.smoothing, 1.F, 0);
+
+    // Streaks below one batch and smoothing outside (0, 1] keep the defaults
+    for (const char* section : { "down-switch-batches=0\nup-switch-batches=-2\nsmoothing=0\n",
+             "down-switch-batches=-1\nup-switch-batches=0\nsmoothing=1.5\n",
+             "down-switch-batches=x\nup-switch-batches=0\nsmoothing=-0.2\n" }) {
+        params = loadParams(section);
+        CHECK_EQ(params.downSwitchBatches, defaults.downSwitchBatches);
+        CHECK_EQ(params.upSwitchBatches, defaults.upSwitchBatches);
+        CHECK_NEAR(params.smoothing, defaults.smoothing, 0);
+
+        // So a calm load with the occasional deep queue never switches
+        ModelSwitchPolicy policy(params);
+        std::vector<int> switches = run(policy, 200, [](int i, ModelSwitchPolicy::Variant) {
+            return Sample{ i % 50 == 0 ? 8 : 1, 25.F };
+        });
+        CHECK(switches.empty());
+    }
+}
+
+int main()
+{
+    testSustainedOverload();
+    testShortSpike();
+    testRecovery();
+    testOscillatingLoad();
+    testInvalidParams();
+    return testResult("test_model_switch");
+}
@@ -0,0 +1,223 @@
+/*
+ * MosaicLayout geometry: tile grids for 1..N sources with automatic and
+ * explicit columns, tile lookup at borders and past the last partial row,
+ * clipping/dropping against the inside ratio, and demux scaling.
+ */
+
+#include "mosaic.h"
+#include "test_utils.h"
+
+static NvDsInferParseObjectInfo makeBox(float left, float top, float width, float height)
+{
+    NvDsInferParseObjectInfo b;
+    b.left = left;
+    b.top = top;
+    b.width = width;
+    b.height = height;
+    b.classId = 0;
+    b.detectionConfidence = 0.9F;
+    return b;
+}
+
+static void checkGrid(int numSources, int columns, int expectedColumns, int expectedRows)
+{
+    const float netWidth = 640.F, netHeight = 480.F;
+    MosaicLayout layout(numSources, netWidth, netHeight, columns);
+    CHECK_EQ(layout.getNumSources(), numSources);
+    CHECK_EQ(layout.getColumns(), expectedColumns);
+    CHECK_EQ(layout.getRows(), expectedRows);
+
+    const float tileWidth = netWidth / expectedColumns;
+    const float tileHeight = netHeight / expectedRows;
+    for (int id = 0; id < numSources; id++) {
+        const TileRect& tile = layout.getTile(id);
+        CHECK_NEAR(tile.left, (id % expectedColumns) * tileWidth, 1e-3);
+        CHECK_NEAR(tile.top, (id / expectedColumns) * tileHeight, 1e-3);
+        CHECK_NEAR(tile.width, tileWidth, 1e-3);
+        CHECK_NEAR(tile.height, tileHeight, 1e-3);
+        // Center and the inside of the top-left corner belong to the tile
+        CHECK_EQ(layout.findTile(tile.left + tile.width / 2, tile.top + tile.height / 2), id);
+        CHECK_EQ(layout.findTile(tile.left + 0.01F, tile.top + 0.01F), id);
+    }
+    // Cells of the last row past the last source hold no tile
+    for (int cell = numSources; cell < expectedColumns * expectedRows; cell++) {
+        float x = (cell % expectedColumns + 0.5F) * tileWidth;
+        float y = (cell / expectedColumns + 0.5F) * tileHeight;
+        CHECK_EQ(layout.findTile(x, y), -1);
+    }
+}
+
+static void testGrids()
+{
+    // columns = 0 picks ceil(sqrt(N)) columns
+    checkGrid(1, 0, 1, 1);
+    checkGrid(2, 0, 2, 1);
+    checkGrid(3, 0, 2, 2);
+    checkGrid(4, 0, 2, 2);
+    checkGrid(5, 0, 3, 2);
+    checkGrid(9, 0, 3, 3);
+    checkGrid(10, 0, 4, 3);
+    checkGrid(16, 0, 4, 4);
+    checkGrid(30, 0, 6, 5);
+
+    // Explicit columns
+    checkGrid(4, 4, 4, 1);
+    checkGrid(4, 1, 1, 4);
+    checkGrid(4, 3, 3, 2);
+    checkGrid(7, 2, 2, 4);
+    checkGrid(2, 5, 5, 1);
+}
+
+static void testFindTileBorders()
+{
+    MosaicLayout layout(3, 640.F, 640.F);
+    // 2 x 2 grid of 320 x 320 tiles, the bottom right cell is empty
+    CHECK_EQ(layout.findTile(0.F, 0.F), 0);
+    CHECK_EQ(layout.findTile(319.99F, 319.99F), 0);
+    CHECK_EQ(layout.findTile(320.F, 0.F), 1);
+    CHECK_EQ(layout.findTile(639.99F, 319.99F), 1);
+    CHECK_EQ(layout.findTile(0.F, 320.F), 2);
+    CHECK_EQ(layout.findTile(319.99F, 639.99F), 2);
+    CHECK_EQ(layout.findTile(320.F, 320.F), -1);
+    CHECK_EQ(layout.findTile(639.99F, 639.99F), -1);
+
+    // Outside the network input
+    CHECK_EQ(layout.findTile(-0.01F, 10.F), -1);
+    CHECK_EQ(layout.findTile(10.F, -0.01F), -1);
+    CHECK_EQ(layout.findTile(640.F, 10.F), -1);
+    CHECK_EQ(layout.findTile(10.F, 640.F), -1);
+}
+
+static void testAssign()
+{
+    MosaicLayout layout(4, 640.F, 640.F);
+    const float minInsideRatio = 0.5F;
+
+    // Inside its tile, unchanged
+    NvDsInferParseObjectInfo inside = makeBox(100.F, 100.F, 50.F, 80.F);
+    CHECK_EQ(layout.assign(inside, minInsideRatio), 0);
+    CHECK_NEAR(inside.left, 100.F, 1e-4);
+    CHECK_NEAR(inside.top, 100.F, 1e-4);
+    CHECK_NEAR(inside.width, 50.F, 1e-4);
+    CHECK_NEAR(inside.height, 80.F, 1e-4);
+
+    // Touching the tile border from inside, unchanged
+    NvDsInferParseObjectInfo touching = makeBox(400.F, 220.F, 100.F, 100.F);
+    CHECK_EQ(layout.assign(touching, minInsideRatio), 1);
+    CHECK_NEAR(touching.height, 100.F, 1e-4);
+
+    // 70% inside tile 0, clipped at x = 320
+    NvDsInferParseObjectInfo crossing = makeBox(250.F, 10.F, 100.F, 40.F);
+    CHECK_EQ(layout.assign(crossing, minInsideRatio), 0);
+    CHECK_NEAR(crossing.left, 250.F, 1e-4);
+    CHECK_NEAR(crossing.width, 70.F, 1e-4);
+    CHECK_NEAR(crossing.height, 40.F, 1e-4);
+
+    // Center in tile 3, crossing both borders: 60% x 60% = 36% inside
+    NvDsInferParseObjectInfo corner = makeBox(300.F, 300.F, 50.F, 50.F);
+    NvDsInferParseObjectInfo cornerCopy = corner;
+    CHECK_EQ(layout.assign(corner, minInsideRatio), -1);
+    // Dropped boxes are left untouched
+    CHECK_NEAR(corner.left, cornerCopy.left, 1e-4);
+    CHECK_NEAR(corner.width, cornerCopy.width, 1e-4);
+    // ... and kept with a lower ratio
+    CHECK_EQ(layout.assign(corner, 0.3F), 3);
+    CHECK_NEAR(corner.left, 320.F, 1e-4);
+    CHECK_NEAR(corner.top, 320.F, 1e-4);
+    CHECK_NEAR(corner.width, 30.F, 1e-4);
+    CHECK_NEAR(corner.height, 30.F, 1e-4);
+
+    // Exactly at the ratio is kept
+    NvDsInferParseObjectInfo half = makeBox(300.F, 10.F, 40.F, 40.F);
+    CHECK_EQ(layout.assign(half, 0.5F), 1);
+    CHECK_NEAR(half.left, 320.F, 1e-4);
+    CHECK_NEAR(half.width, 20.F, 1e-4);
+
+    // Degenerate and off-mosaic boxes
+    NvDsInferParseObjectInfo empty = makeBox(10.F, 10.F, 0.F, 10.F);
+    CHECK_EQ(layout.assign(empty, minInsideRatio), -1);
+    NvDsInferParseObjectInfo outside = makeBox(700.F, 10.F, 20.F, 20.F);
+    CHECK_EQ(layout.assign(outside, minInsideRatio), -1);
+
+    // Center in the empty cell past the last partial row
+    MosaicLayout partial(3, 640.F, 640.F);
+    NvDsInferParseObjectInfo emptyCell = makeBox(400.F, 400.F, 50.F, 50.F);
+    CHECK_EQ(partial.assign(emptyCell, minInsideRatio), -1);
+}
+
+static void testDemux()
+{
+    MosaicLayout layout(4, 640.F, 640.F);
+    std::vector<NvDsInferParseObjectInfo> objects = {
+        makeBox(10.F, 20.F, 32.F, 16.F),    // tile 0
+        makeBox(330.F, 40.F, 64.F, 32.F),   // tile 1
+        makeBox(100.F, 400.F, 10.F, 10.F),  // tile 2
+        makeBox(300.F, 300.F, 50.F, 50.F),  // crossing, dropped
+        makeBox(600.F, 600.F, 40.F, 20.F),  // tile 3, clipped to 40 x 20
+        makeBox(620.F, 620.F, 40.F, 40.F),  // tile 3, 25% inside, dropped
+    };
+
+    // Tile local coordinates when no sizes are given
+    std::vector<std::vector<NvDsInferParseObjectInfo>> perSource;
+    layout.demux(objects, perSource, 0.5F);
+    CHECK_EQ(perSource.size(), (size_t)4);
+    CHECK_EQ(perSource[0].size(), (size_t)1);
+    CHECK_EQ(perSource[1].size(), (size_t)1);
+    CHECK_EQ(perSource[2].size(), (size_t)1);
+    CHECK_EQ(perSource[3].size(), (size_t)1);
+    CHECK_NEAR(perSource[1][0].left, 10.F, 1e-4);
+    CHECK_NEAR(perSource[1][0].top, 40.F, 1e-4);
+    CHECK_NEAR(perSource[2][0].left, 100.F, 1e-4);
+    CHECK_NEAR(perSource[2][0].top, 80.F, 1e-4);
+    CHECK_NEAR(perSource[3][0].left, 280.F, 1e-4);
+    CHECK_NEAR(perSource[3][0].width, 40.F, 1e-4);
+
+    // Scaled to each source: 1920x1080, 1280x720, none, 320x320
+    std::vector<int> widths = { 1920, 1280, 0, 320 };
+    std::vector<int> heights = { 1080, 720, 0, 320 };
+    layout.demux(objects, perSource, 0.5F, widths, heights);
+    const NvDsInferParseObjectInfo& a = perSource[0][0];
+    CHECK_NEAR(a.left, 10.F * 6.F, 1e-3);
+    CHECK_NEAR(a.top, 20.F * 3.375F, 1e-3);
+    CHECK_NEAR(a.width, 32.F * 6.F, 1e-3);
+    CHECK_NEAR(a.height, 16.F * 3.375F, 1e-3);
+    const NvDsInferParseObjectInfo& b = perSource[1][0];
+    CHECK_NEAR(b.left, 10.F * 4.F, 1e-3);
+    CHECK_NEAR(b.top, 40.F * 2.25F, 1e-3);
+    CHECK_NEAR(b.width, 64.F * 4.F, 1e-3);
+    CHECK_NEAR(b.height, 32.F * 2.25F, 1e-3);
+    const NvDsInferParseObjectInfo& c = perSource[2][0];
+    CHECK_NEAR(c.left, 100.F, 1e-3);
+    CHECK_NEAR(c.width, 10.F, 1e-3);
+    const NvDsInferParseObjectInfo& d = perSource[3][0];
+    CHECK_NEAR(d.left, 280.F, 1e-3);
+    CHECK_NEAR(d.top, 280.F, 1e-3);
+
+    // Sizes shorter than the source count leave the rest unscaled
+    layout.demux(objects, perSource, 0.5F, { 640 }, { 640 });
+    CHECK_NEAR(perSource[0][0].width, 64.F, 1e-3);
+    CHECK_NEAR(perSource[1][0].width, 64.F, 1e-3);
+
+    // Demux into fewer, non-square tiles, confidence and class preserved
+    MosaicLayout wide(2, 1280.F, 360.F);
+    NvDsInferParseObjectInfo obj = makeBox(700.F, 100.F, 64.F, 36.F);
+    obj.classId = 7;
+    obj.detectionConfidence = 0.42F;
+    wide.demux({ obj }, perSource, 0.5F, { 1920, 1920 }, { 1080, 1080 });
+    CHECK_EQ(perSource.size(), (size_t)2);
+    CHECK_EQ(perSource[0].size(), (size_t)0);
+    CHECK_EQ(perSource[1].size(), (size_t)1);
+    CHECK_NEAR(perSource[1][0].left, 60.F * 3.F, 1e-3);
+    CHECK_NEAR(perSource[1][0].top, 100.F * 3.F, 1e-3);
+    CHECK_EQ(perSource[1][0].classId, 7u);
+    CHECK_NEAR(perSource[1][0].detectionConfidence, 0.42F, 1e-6);
+}
+
+int main()
+{
+    testGrids();
+    testFindTileBorders();
+    testAssign();
+    testDemux();
+    return testResult("test_mosaic");
+}
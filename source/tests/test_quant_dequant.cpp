@@ -0,0 +1,244 @@
+/*
+ * Explicit quantization of the builder helpers against the recording
+ * INetworkDefinition of tests/mock: convBlock() and bottleneck() with and
+ * without the QAT *_scale blobs, checking the Q/DQ pairs, their scale
+ * constants and axes, and that the convolution takes the dequantized kernel
+ * through setInput(1).
+ */
+
+#include "common.h"
+// common.h defines its own CHECK for CUDA calls
+#undef CHECK
+#include "test_utils.h"
+
+struct ConvSpec
+{
+    const char* lname;
+    int inch;
+    int outch;
+    int ksize;
+    int groups;
+};
+
+// Float weights and folded batch norm inputs of a convBlock, plus the QAT
+// scales when asked for
+static void addConvWeights(WeightStore& weights, const ConvSpec& spec, bool inputScale, bool weightScale)
+{
+    auto add = [&](const char* name, int count, float value) {
+        float* values = weights.allocate(count);
+        for (int i = 0; i < count; i++) {
+            values[i] = value + 0.001F * i;
+        }
+        weights.add(name, Weights{ DataType::kFLOAT, values, count });
+    };
+    add(WeightName(spec.lname, ".conv.weight"),
+        spec.outch * spec.inch / spec.groups * spec.ksize * spec.ksize, 0.1F);
+    add(WeightName(spec.lname, ".bn.weight"), spec.outch, 1.F);
+    add(WeightName(spec.lname, ".bn.bias"), spec.outch, 0.F);
+    add(WeightName(spec.lname, ".bn.running_mean"), spec.outch, 0.F);
+    add(WeightName(spec.lname, ".bn.running_var"), spec.outch, 1.F);
+    if (inputScale) {
+        add(WeightName(spec.lname, ".conv.input_scale"), 1, 0.02F);
+    }
+    if (weightScale) {
+        add(WeightName(spec.lname, ".conv.weight_scale"), spec.outch, 0.005F);
+    }
+}
+
+static ILayer* findLayer(INetworkDefinition& network, const char* name)
+{
+    for (int i = 0; i < network.getNbLayers(); i++) {
+        if (strcmp(network.getLayer(i)->getName(), name) == 0) {
+            return network.getLayer(i);
+        }
+    }
+    return nullptr;
+}
+
+static int countLayers(INetworkDefinition& network, LayerType type)
+{
+    int count = 0;
+    for (int i = 0; i < network.getNbLayers(); i++) {
+        count += network.getLayer(i)->getType() == type;
+    }
+    return count;
+}
+
+static bool sameDims(const Dims& a, const Dims& b)
+{
+    if (a.nbDims != b.nbDims) {
+        return false;
+    }
+    for (int i = 0; i < a.nbDims; i++) {
+        if (a.d[i] != b.d[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks the Q/DQ pair named after scaleName: both read the same constant
+// holding the stored scales, per-tensor (rank 0, no axis) for a single scale,
+// else per-channel along axis 0. Returns the dequantized tensor.
+static ITensor* checkQuantDequant(INetworkDefinition& network, const WeightStore& weights,
+    const char* scaleName, ITensor* expectedInput)
+{
+    IQuantizeLayer* q = dynamic_cast<IQuantizeLayer*>(findLayer(network, WeightName(scaleName, ".quantize")));
+    IDequantizeLayer* dq = dynamic_cast<IDequantizeLayer*>(
+        findLayer(network, WeightName(scaleName, ".dequantize")));
+    CHECK(q && dq);
+    if (!q || !dq) {
+        return nullptr;
+    }
+    Weights scale = weights.get(scaleName);
+    CHECK_EQ(q->getNbInputs(), 2);
+    CHECK(q->getInput(0) == expectedInput);
+    CHECK(dq->getInput(0) == q->getOutput(0));
+    CHECK(q->getInput(1) == dq->getInput(1));
+
+    IConstantLayer* scaleConst = dynamic_cast<IConstantLayer*>(q->getInput(1)->producer);
+    CHECK(scaleConst);
+    if (scaleConst) {
+        CHECK(scaleConst->weights.values == scale.values);
+        CHECK_EQ(scaleConst->weights.count, scale.count);
+        Dims dims = scaleConst->getOutput(0)->getDimensions();
+        if (scale.count == 1) {
+            CHECK_EQ(dims.nbDims, 0);
+        } else {
+            CHECK_EQ(dims.nbDims, 1);
+            CHECK_EQ((int64_t)dims.d[0], scale.count);
+        }
+    }
+    int axis = scale.count == 1 ? -1 : 0;
+    CHECK_EQ(q->getAxis(), axis);
+    CHECK_EQ(dq->getAxis(), axis);
+    return dq->getOutput(0);
+}
+
+static void testConvBlock(bool inputScale, bool weightScale, int groups)
+{
+    const ConvSpec spec = { "model.3", 32, 64, 3, groups };
+    WeightStore weights;
+    addConvWeights(weights, spec, inputScale, weightScale);
+    CHECK_EQ(hasQuantScales(weights), inputScale || weightScale);
+
+    INetworkDefinition network;
+    ITensor* data = network.addInput("data", DataType::kFLOAT, Dims3{ spec.inch, 40, 40 });
+    ILayer* out = convBlock(&network, weights, *data, spec.outch, spec.ksize, 2, groups, spec.lname);
+    CHECK_EQ(out->getName(), std::string("model.3.act"));
+    CHECK(sameDims(out->getOutput(0)->getDimensions(), Dims3{ spec.outch, 20, 20 }));
+
+    // One constant per scale, plus the kernel when the weights are quantized
+    int numPairs = inputScale + weightScale;
+    CHECK_EQ(countLayers(network, LayerType::kQUANTIZE), numPairs);
+    CHECK_EQ(countLayers(network, LayerType::kDEQUANTIZE), numPairs);
+    CHECK_EQ(countLayers(network, LayerType::kCONSTANT), numPairs + weightScale);
+    CHECK_EQ(countLayers(network, LayerType::kCONVOLUTION), 1);
+    CHECK_EQ(network.getNbLayers(), 4 + 2 * numPairs + numPairs + weightScale);
+
+    IConvolutionLayer* conv = dynamic_cast<IConvolutionLayer*>(findLayer(network, "model.3.conv"));
+    CHECK(conv);
+    if (!conv) {
+        return;
+    }
+    CHECK_EQ(conv->nbOutputMaps, spec.outch);
+    CHECK_EQ(conv->groups, groups);
+    CHECK(conv->biasWeights.values == nullptr && conv->biasWeights.count == 0);
+
+    ITensor* convInput = data;
+    if (inputScale) {
+        convInput = checkQuantDequant(network, weights, "model.3.conv.input_scale", data);
+    }
+    CHECK(conv->getInput(0) == convInput);
+
+    Weights kernelWeights = weights.get("model.3.conv.weight");
+    if (weightScale) {
+        // The float kernel becomes a constant input, quantized per output channel
+        CHECK(conv->kernelWeights.values == nullptr && conv->kernelWeights.count == 0);
+        CHECK_EQ(conv->getNbInputs(), 2);
+        ILayer* q = findLayer(network, "model.3.conv.weight_scale.quantize");
+        IConstantLayer* kernel = q ? dynamic_cast<IConstantLayer*>(q->getInput(0)->producer) : nullptr;
+        CHECK(kernel);
+        if (kernel) {
+            CHECK(kernel->weights.values == kernelWeights.values);
+            CHECK_EQ(kernel->weights.count, kernelWeights.count);
+            CHECK(sameDims(kernel->getOutput(0)->getDimensions(),
+                Dims4{ spec.outch, spec.inch / groups, spec.ksize, spec.ksize }));
+            ITensor* qkernel = checkQuantDequant(network, weights, "model.3.conv.weight_scale",
+                kernel->getOutput(0));
+            CHECK(qkernel && conv->getInput(1) == qkernel);
+        }
+    } else {
+        CHECK(conv->kernelWeights.values == kernelWeights.values);
+        CHECK_EQ(conv->kernelWeights.count, kernelWeights.count);
+        CHECK_EQ(conv->getNbInputs(), 1);
+    }
+}
+
+static void testBottleneck(bool quantized, bool shortcut)
+{
+    const int c = 32;
+    WeightStore weights;
+    addConvWeights(weights, ConvSpec{ "model.2.m.0.cv1", c, c, 1, 1 }, quantized, quantized);
+    addConvWeights(weights, ConvSpec{ "model.2.m.0.cv2", c, c, 3, 1 }, quantized, quantized);
+    if (quantized) {
+        float* scale = weights.allocate(1);
+        *scale = 0.03F;
+        weights.add("model.2.m.0.add_input_scale", Weights{ DataType::kFLOAT, scale, 1 });
+    }
+
+    INetworkDefinition network;
+    ITensor* data = network.addInput("data", DataType::kFLOAT, Dims3{ c, 20, 20 });
+    ILayer* out = bottleneck(&network, weights, *data, c, c, shortcut, 1, 1.0, "model.2.m.0");
+    ILayer* cv2 = findLayer(network, "model.2.m.0.cv2.act");
+    CHECK(cv2);
+
+    // Two quantized convs, and the shortcut input when it is added
+    int numPairs = quantized ? 4 + shortcut : 0;
+    CHECK_EQ(countLayers(network, LayerType::kQUANTIZE), numPairs);
+    CHECK_EQ(countLayers(network, LayerType::kDEQUANTIZE), numPairs);
+    if (quantized) {
+        ILayer* cv1 = findLayer(network, "model.2.m.0.cv1.act");
+        CHECK(cv1);
+        checkQuantDequant(network, weights, "model.2.m.0.cv1.conv.input_scale", data);
+        if (cv1) {
+            checkQuantDequant(network, weights, "model.2.m.0.cv2.conv.input_scale", cv1->getOutput(0));
+        }
+    }
+
+    if (!shortcut) {
+        CHECK(out == cv2);
+        CHECK(!findLayer(network, "model.2.m.0.add"));
+        return;
+    }
+    IElementWiseLayer* add = dynamic_cast<IElementWiseLayer*>(out);
+    CHECK(add);
+    if (!add || !cv2) {
+        return;
+    }
+    CHECK_EQ(add->getName(), std::string("model.2.m.0.add"));
+    CHECK(add->operation == ElementWiseOperation::kSUM);
+    CHECK(add->getInput(1) == cv2->getOutput(0));
+    if (quantized) {
+        // The shortcut is quantized like the residual it is added to
+        ITensor* x = checkQuantDequant(network, weights, "model.2.m.0.add_input_scale", data);
+        CHECK(x && add->getInput(0) == x);
+    } else {
+        CHECK(add->getInput(0) == data);
+    }
+}
+
+int main()
+{
+    for (int groups : { 1, 2 }) {
+        testConvBlock(false, false, groups);
+        testConvBlock(true, false, groups);
+        testConvBlock(false, true, groups);
+        testConvBlock(true, true, groups);
+    }
+    testBottleneck(false, true);
+    testBottleneck(false, false);
+    testBottleneck(true, true);
+    testBottleneck(true, false);
+    return testResult("test_quant_dequant");
+}
@@ -0,0 +1,56 @@
+/*
+ * Fused SPPF pooling of SppfLayerPlugin against the layered construction
+ * SPPF() used to build, three chained stride 1 k x k max pools with k/2
+ * padding concatenated with the input. The fused side is computed on the
+ * host both from the full (6r+1)^2 windows and by sppfTiledReference, which
+ * runs the tile steps of sppf_tile.h that CalSppf is made of.
+ */
+
+#include <random>
+#include <vector>
+
+#include "sppf_reference.h"
+#include "test_utils.h"
+
+static void testMapSize(std::mt19937& rng, int channels, int height, int width, int kernelSize)
+{
+    // Few distinct values, so ties and plateaus are common
+    std::uniform_int_distribution<int> value(-20, 20);
+    std::vector<float> in((size_t)channels * height * width);
+    for (float& v : in) {
+        v = value(rng) * 0.25F;
+    }
+    std::vector<float> layered(4 * in.size()), window(4 * in.size()), tiled(4 * in.size(), 1e9F);
+    sppfLayeredReference(in.data(), layered.data(), channels, height, width, kernelSize);
+    sppfReference(in.data(), window.data(), channels, height, width, kernelSize);
+    sppfTiledReference(in.data(), tiled.data(), channels, height, width, kernelSize);
+
+    size_t windowDiff = 0, tiledDiff = 0;
+    for (size_t i = 0; i < layered.size(); i++) {
+        windowDiff += window[i] != layered[i];
+        tiledDiff += tiled[i] != layered[i];
+    }
+    if (windowDiff || tiledDiff) {
+        std::cerr << "k=" << kernelSize << " " << channels << "x" << height << "x" << width << std::endl;
+    }
+    CHECK_EQ(windowDiff, (size_t)0);
+    CHECK_EQ(tiledDiff, (size_t)0);
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    // Maps smaller than a window, single rows and columns, the yolov5 SPPF
+    // map sizes at 640 and 1280, and sizes that are not multiples of the
+    // Sppf::TILE_W x Sppf::TILE_H tile
+    const int sizes[][2] = {
+        { 1, 1 }, { 1, 9 }, { 9, 1 }, { 2, 3 }, { 7, 7 }, { 8, 32 }, { 9, 33 },
+        { 13, 21 }, { 20, 20 }, { 40, 40 }, { 17, 70 },
+    };
+    for (int kernelSize : { 3, 5 }) {
+        for (const int* size : sizes) {
+            testMapSize(rng, 3, size[0], size[1], kernelSize);
+        }
+    }
+    return testResult("test_sppf");
+}
@@ -0,0 +1,225 @@
+/*
+ * TilePlanner and mergeTileDetections: tile coverage and overlap, adaptive
+ * scheduling with periodic refresh, and merging of boxes cut at tile edges.
+ */
+
+#include <algorithm>
+
+#include "test_utils.h"
+#include "tiling.h"
+
+static NvDsInferParseObjectInfo makeBox(float left, float top, float width, float height,
+    float confidence = 0.9F, unsigned int classId = 0)
+{
+    NvDsInferParseObjectInfo b;
+    b.left = left;
+    b.top = top;
+    b.width = width;
+    b.height = height;
+    b.classId = classId;
+    b.detectionConfidence = confidence;
+    return b;
+}
+
+// Distinct sorted offsets along one axis of the planned tiles
+static std::vector<float> axisOffsets(const std::vector<TileRect>& tiles, bool horizontal)
+{
+    std::vector<float> offsets;
+    for (const TileRect& tile : tiles) {
+        offsets.push_back(horizontal ? tile.left : tile.top);
+    }
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+    return offsets;
+}
+
+static void checkAxis(const std::vector<float>& offsets, int length, int tileLength, float overlap)
+{
+    int extent = std::min(tileLength, length);
+    CHECK(!offsets.empty());
+    CHECK_NEAR(offsets.front(), 0.F, 1e-6);
+    CHECK_NEAR(offsets.back() + extent, (float)length, 1e-6);
+    for (size_t i = 1; i < offsets.size(); i++) {
+        float shared = offsets[i - 1] + extent - offsets[i];
+        // Offsets are rounded to whole pixels
+        CHECK(shared >= overlap * tileLength - 1.F);
+        CHECK(offsets[i] > offsets[i - 1]);
+    }
+    // No more tiles than needed: one tile less would space them wider than
+    // the overlap allows
+    if (offsets.size() > 2) {
+        float sparser = (float)(length - extent) / (offsets.size() - 2);
+        CHECK(sparser > tileLength * (1.F - overlap));
+    }
+}
+
+static void checkCoverage(int frameWidth, int frameHeight, int tileWidth, int tileHeight, float overlap)
+{
+    TilePlanner planner(frameWidth, frameHeight, tileWidth, tileHeight, overlap);
+    const std::vector<TileRect>& tiles = planner.getTiles();
+    std::vector<float> xs = axisOffsets(tiles, true);
+    std::vector<float> ys = axisOffsets(tiles, false);
+    CHECK_EQ(tiles.size(), xs.size() * ys.size());
+    checkAxis(xs, frameWidth, tileWidth, overlap);
+    checkAxis(ys, frameHeight, tileHeight, overlap);
+
+    for (const TileRect& tile : tiles) {
+        CHECK_NEAR(tile.width, (float)std::min(tileWidth, frameWidth), 1e-6);
+        CHECK_NEAR(tile.height, (float)std::min(tileHeight, frameHeight), 1e-6);
+        CHECK(tile.left >= 0.F && tile.left + tile.width <= frameWidth);
+        CHECK(tile.top >= 0.F && tile.top + tile.height <= frameHeight);
+    }
+
+    // Every pixel, sampled on a grid, is covered
+    for (int y = 0; y < frameHeight; y += 7) {
+        for (int x = 0; x < frameWidth; x += 7) {
+            bool covered = false;
+            for (const TileRect& tile : tiles) {
+                covered = covered || (x >= tile.left && x < tile.left + tile.width &&
+                    y >= tile.top && y < tile.top + tile.height);
+            }
+            CHECK(covered);
+        }
+    }
+}
+
+static void testCoverage()
+{
+    checkCoverage(3840, 2160, 640, 640, 0.2F);
+    checkCoverage(3840, 2160, 1280, 1280, 0.25F);
+    checkCoverage(1920, 1080, 640, 640, 0.F);
+    checkCoverage(1920, 1080, 640, 640, 0.5F);
+    checkCoverage(1280, 1280, 640, 640, 0.F);
+    checkCoverage(1000, 700, 640, 640, 0.1F);
+    // Frame smaller than a tile on one or both axes
+    checkCoverage(500, 2000, 640, 640, 0.2F);
+    checkCoverage(320, 240, 640, 640, 0.2F);
+
+    // Exact fit without overlap: 2 x 2 tiles
+    TilePlanner exact(1280, 1280, 640, 640, 0.F);
+    CHECK_EQ(exact.getTiles().size(), (size_t)4);
+    // 4K with 20% overlap of 640 tiles: 8 x 4 tiles
+    TilePlanner uhd(3840, 2160, 640, 640, 0.2F);
+    CHECK_EQ(axisOffsets(uhd.getTiles(), true).size(), (size_t)8);
+    CHECK_EQ(axisOffsets(uhd.getTiles(), false).size(), (size_t)4);
+}
+
+static void testSchedule()
+{
+    // 2 x 2 tiles of 640 over 1280 x 1280, refresh every 3 frames
+    TilePlanner planner(1280, 1280, 640, 640, 0.F, 3, 32.F);
+    std::vector<NvDsInferParseObjectInfo> none;
+
+    // Frame 0 refreshes
+    CHECK_EQ(planner.schedule(none).size(), (size_t)4);
+    // Nothing detected, nothing runs until the next refresh
+    CHECK_EQ(planner.schedule(none).size(), (size_t)0);
+
+    // An object well inside tile 3 only activates tile 3
+    std::vector<NvDsInferParseObjectInfo> previous = { makeBox(900.F, 900.F, 50.F, 50.F) };
+    std::vector<int> ids = planner.schedule(previous);
+    CHECK_EQ(ids.size(), (size_t)1);
+    CHECK(ids.size() == 1 && ids[0] == 3);
+
+    // Frame 3 refreshes again whatever was detected
+    CHECK_EQ(planner.schedule(none).size(), (size_t)4);
+
+    // Within margin of the tile 0/1 border activates both
+    previous = { makeBox(580.F, 100.F, 40.F, 40.F) };
+    ids = planner.schedule(previous);
+    CHECK_EQ(ids.size(), (size_t)2);
+    CHECK(ids.size() == 2 && ids[0] == 0 && ids[1] == 1);
+
+    // Farther than the margin from the border only activates tile 0
+    previous = { makeBox(500.F, 100.F, 40.F, 40.F) };
+    ids = planner.schedule(previous);
+    CHECK(ids.size() == 1 && ids[0] == 0);
+
+    // Straddling the center activates all four
+    planner.reset();
+    CHECK_EQ(planner.schedule(none).size(), (size_t)4);
+    previous = { makeBox(620.F, 620.F, 40.F, 40.F) };
+    CHECK_EQ(planner.schedule(previous).size(), (size_t)4);
+
+    // reset() makes the next frame a refresh
+    planner.schedule(none);
+    planner.reset();
+    CHECK_EQ(planner.schedule(none).size(), (size_t)4);
+
+    // refreshInterval 1 (and invalid values) run all tiles every frame
+    TilePlanner always(1280, 1280, 640, 640, 0.F, 0);
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(always.schedule(none).size(), (size_t)4);
+    }
+}
+
+static void testMerge()
+{
+    // Two 1280 x 1280 tiles overlapping by 320, on a 640 x 640 network input
+    std::vector<TileRect> tiles = { { 0.F, 0.F, 1280.F, 1280.F }, { 960.F, 0.F, 1280.F, 1280.F } };
+    std::vector<int> ids = { 0, 1 };
+
+    // An object at x 1200..1400 in the frame: tile 0 sees it cut at its right
+    // edge (1200..1280), tile 1 sees it whole (240..440 in tile 1)
+    std::vector<std::vector<NvDsInferParseObjectInfo>> perTile(2);
+    perTile[0].push_back(makeBox(600.F, 100.F, 40.F, 50.F, 0.6F));
+    perTile[1].push_back(makeBox(120.F, 100.F, 100.F, 50.F, 0.8F));
+    // An unrelated object of tile 1, outside the overlap
+    perTile[1].push_back(makeBox(400.F, 400.F, 20.F, 20.F, 0.7F));
+
+    std::vector<NvDsInferParseObjectInfo> merged;
+    mergeTileDetections(tiles, ids, perTile, 640.F, 640.F, merged,
+        TileMergeMode::kNms, 0.5F, BoxMatchMetric::kIoS);
+    CHECK_EQ(merged.size(), (size_t)2);
+    // The full box survives, mapped to frame coordinates
+    CHECK_NEAR(merged[0].left, 1200.F, 1e-3);
+    CHECK_NEAR(merged[0].top, 200.F, 1e-3);
+    CHECK_NEAR(merged[0].width, 200.F, 1e-3);
+    CHECK_NEAR(merged[0].height, 100.F, 1e-3);
+    CHECK_NEAR(merged[0].detectionConfidence, 0.8F, 1e-6);
+    CHECK_NEAR(merged[1].left, 960.F + 800.F, 1e-3);
+
+    // IoU of the cut and the full box is 0.4, so IoU matching keeps both
+    mergeTileDetections(tiles, ids, perTile, 640.F, 640.F, merged,
+        TileMergeMode::kNms, 0.5F, BoxMatchMetric::kIoU);
+    CHECK_EQ(merged.size(), (size_t)3);
+
+    // Different classes never merge
+    perTile[0][0].classId = 1;
+    mergeTileDetections(tiles, ids, perTile, 640.F, 640.F, merged,
+        TileMergeMode::kNms, 0.5F, BoxMatchMetric::kIoS);
+    CHECK_EQ(merged.size(), (size_t)3);
+    perTile[0][0].classId = 0;
+
+    // Fusion: confidence weighted mean of 1200..1280 (0.6) and 1200..1400 (0.8)
+    mergeTileDetections(tiles, ids, perTile, 640.F, 640.F, merged,
+        TileMergeMode::kFusion, 0.5F, BoxMatchMetric::kIoS);
+    CHECK_EQ(merged.size(), (size_t)2);
+    CHECK_NEAR(merged[0].left, 1200.F, 1e-3);
+    CHECK_NEAR(merged[0].width, (0.6F * 80.F + 0.8F * 200.F) / 1.4F, 1e-3);
+    CHECK_NEAR(merged[0].detectionConfidence, 0.8F, 1e-6);
+
+    // Boxes reaching past their tile are clipped, empty ones dropped
+    perTile.assign(1, std::vector<NvDsInferParseObjectInfo>());
+    perTile[0].push_back(makeBox(620.F, 10.F, 40.F, 40.F));
+    perTile[0].push_back(makeBox(650.F, 10.F, 40.F, 40.F));
+    mergeTileDetections(tiles, { 0 }, perTile, 640.F, 640.F, merged);
+    CHECK_EQ(merged.size(), (size_t)1);
+    CHECK_NEAR(merged[0].left, 1240.F, 1e-3);
+    CHECK_NEAR(merged[0].width, 40.F, 1e-3);
+
+    // Only the scheduled tiles are mapped, through tileIds
+    perTile.assign(1, std::vector<NvDsInferParseObjectInfo>(1, makeBox(0.F, 0.F, 64.F, 64.F)));
+    mergeTileDetections(tiles, { 1 }, perTile, 640.F, 640.F, merged);
+    CHECK_EQ(merged.size(), (size_t)1);
+    CHECK_NEAR(merged[0].left, 960.F, 1e-3);
+    CHECK_NEAR(merged[0].width, 128.F, 1e-3);
+}
+
+int main()
+{
+    testCoverage();
+    testSchedule();
+    testMerge();
+    return testResult("test_tiling");
+}
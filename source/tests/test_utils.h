@@ -0,0 +1,52 @@
+#ifndef _TEST_UTILS_H_
+#define _TEST_UTILS_H_
+
+#include <cmath>
+#include <iostream>
+
+// Checks of the CPU tests. A failed check is reported and counted, and
+// testResult() turns the count into the exit status.
+static int g_TestFailures = 0;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed"  \
+                      << std::endl;                                                  \
+            g_TestFailures++;                                                        \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                               \
+    do {                                                                             \
+        auto va = (a);                                                               \
+        auto vb = (b);                                                               \
+        if (!(va == vb)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #a ", " #b     \
+                      << ") failed: " << va << " != " << vb << std::endl;            \
+            g_TestFailures++;                                                        \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps)                                                        \
+    do {                                                                             \
+        double va = (a);                                                             \
+        double vb = (b);                                                             \
+        if (!(std::fabs(va - vb) <= (eps))) {                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_NEAR(" #a ", " #b   \
+                      << ") failed: " << va << " != " << vb << std::endl;            \
+            g_TestFailures++;                                                        \
+        }                                                                            \
+    } while (0)
+
+static inline int testResult(const char* name)
+{
+    if (g_TestFailures) {
+        std::cerr << name << ": " << g_TestFailures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": passed" << std::endl;
+    return 0;
+}
+
+#endif // _TEST_UTILS_H_
@@ -0,0 +1,375 @@
+/*
+ * 2:4 weight pruning: inferConvShape against every conv of the P5 and P6
+ * layouts built in yolov5.cpp at all model widths, then pruning, idempotence,
+ * the skip list, the dense stem and a wts file round trip.
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "test_utils.h"
+#include "weight_pruning.h"
+
+static const int kNumOutputs = 3 * (80 + 5);
+
+static int getWidth(int x, float gw)
+{
+    int w = int(x * gw);
+    return w % 8 == 0 ? w : (int(x * gw / 8) + 1) * 8;
+}
+
+static int getDepth(int x, float gd)
+{
+    return x == 1 ? 1 : std::max(1, (int)std::round(x * gd));
+}
+
+// Blob names and sizes of a yolov5 v6.1 wts file, mirroring the builders of
+// common.h, with the expected shape of every conv weight
+struct ModelLayout
+{
+    std::map<std::string, size_t> sizes;
+    std::map<std::string, ConvShape> convs;
+    std::vector<std::string> order;
+
+    void add(const std::string& name, size_t count)
+    {
+        sizes[name] = count;
+        order.push_back(name);
+    }
+
+    void conv(const std::string& lname, int c1, int c2, int ksize)
+    {
+        std::string name = lname + ".conv.weight";
+        add(name, (size_t)c2 * c1 * ksize * ksize);
+        for (const char* suffix : { ".bn.weight", ".bn.bias", ".bn.running_mean", ".bn.running_var" }) {
+            add(lname + suffix, c2);
+        }
+        ConvShape shape;
+        shape.outChannels = c2;
+        shape.inChannels = c1;
+        shape.kernelSize = ksize;
+        convs[name] = shape;
+    }
+
+    void c3(const std::string& lname, int c1, int c2, int n)
+    {
+        int c_ = c2 / 2;
+        conv(lname + ".cv1", c1, c_, 1);
+        conv(lname + ".cv2", c1, c_, 1);
+        for (int i = 0; i < n; i++) {
+            std::string m = lname + ".m." + std::to_string(i);
+            conv(m + ".cv1", c_, c_, 1);
+            conv(m + ".cv2", c_, c_, 3);
+        }
+        conv(lname + ".cv3", 2 * c_, c2, 1);
+    }
+
+    void sppf(const std::string& lname, int c1, int c2)
+    {
+        conv(lname + ".cv1", c1, c1 / 2, 1);
+        conv(lname + ".cv2", c1 / 2 * 4, c2, 1);
+    }
+
+    void detect(const std::string& lname, const std::vector<int>& inputs)
+    {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            std::string m = lname + ".m." + std::to_string(i);
+            add(m + ".weight", (size_t)kNumOutputs * inputs[i]);
+            add(m + ".bias", kNumOutputs);
+            ConvShape shape;
+            shape.outChannels = kNumOutputs;
+            shape.inChannels = inputs[i];
+            shape.kernelSize = 1;
+            convs[m + ".weight"] = shape;
+        }
+        add(lname + ".anchor_grid", inputs.size() * 6);
+    }
+};
+
+static ModelLayout buildP5(float gd, float gw)
+{
+    ModelLayout m;
+    auto w = [gw](int x) { return getWidth(x, gw); };
+    m.conv("model.0", 3, w(64), 6);
+    m.conv("model.1", w(64), w(128), 3);
+    m.c3("model.2", w(128), w(128), getDepth(3, gd));
+    m.conv("model.3", w(128), w(256), 3);
+    m.c3("model.4", w(256), w(256), getDepth(6, gd));
+    m.conv("model.5", w(256), w(512), 3);
+    m.c3("model.6", w(512), w(512), getDepth(9, gd));
+    m.conv("model.7", w(512), w(1024), 3);
+    m.c3("model.8", w(1024), w(1024), getDepth(3, gd));
+    m.sppf("model.9", w(1024), w(1024));
+    m.conv("model.10", w(1024), w(512), 1);
+    m.c3("model.13", w(1024), w(512), getDepth(3, gd));
+    m.conv("model.14", w(512), w(256), 1);
+    m.c3("model.17", w(512), w(256), getDepth(3, gd));
+    m.conv("model.18", w(256), w(256), 3);
+    m.c3("model.20", w(512), w(512), getDepth(3, gd));
+    m.conv("model.21", w(512), w(512), 3);
+    m.c3("model.23", w(1024), w(1024), getDepth(3, gd));
+    m.detect("model.24", { w(256), w(512), w(1024) });
+    return m;
+}
+
+static ModelLayout buildP6(float gd, float gw)
+{
+    ModelLayout m;
+    auto w = [gw](int x) { return getWidth(x, gw); };
+    m.conv("model.0", 3, w(64), 6);
+    m.conv("model.1", w(64), w(128), 3);
+    m.c3("model.2", w(128), w(128), getDepth(3, gd));
+    m.conv("model.3", w(128), w(256), 3);
+    m.c3("model.4", w(256), w(256), getDepth(6, gd));
+    m.conv("model.5", w(256), w(512), 3);
+    m.c3("model.6", w(512), w(512), getDepth(9, gd));
+    m.conv("model.7", w(512), w(768), 3);
+    m.c3("model.8", w(768), w(768), getDepth(3, gd));
+    m.conv("model.9", w(768), w(1024), 3);
+    m.c3("model.10", w(1024), w(1024), getDepth(3, gd));
+    m.sppf("model.11", w(1024), w(1024));
+    m.conv("model.12", w(1024), w(768), 1);
+    m.c3("model.15", w(1536), w(768), getDepth(3, gd));
+    m.conv("model.16", w(768), w(512), 1);
+    m.c3("model.19", w(1024), w(512), getDepth(3, gd));
+    m.conv("model.20", w(512), w(256), 1);
+    m.c3("model.23", w(512), w(256), getDepth(3, gd));
+    m.conv("model.24", w(256), w(256), 3);
+    m.c3("model.26", w(512), w(512), getDepth(3, gd));
+    m.conv("model.27", w(512), w(512), 3);
+    m.c3("model.29", w(1024), w(768), getDepth(3, gd));
+    m.conv("model.30", w(768), w(768), 3);
+    m.c3("model.32", w(1536), w(1024), getDepth(3, gd));
+    m.detect("model.33", { w(256), w(512), w(768), w(1024) });
+    return m;
+}
+
+static void checkShapes(const ModelLayout& model)
+{
+    for (const std::string& name : model.order) {
+        ConvShape shape;
+        bool isConv = inferConvShape(model.sizes, name, model.sizes.at(name), shape);
+        auto expected = model.convs.find(name);
+        if (expected == model.convs.end()) {
+            if (isConv) {
+                std::cerr << name << " taken for a conv" << std::endl;
+            }
+            CHECK(!isConv);
+            continue;
+        }
+        if (!isConv || shape.outChannels != expected->second.outChannels ||
+            shape.inChannels != expected->second.inChannels ||
+            shape.kernelSize != expected->second.kernelSize) {
+            std::cerr << name << ": got " << (isConv ? shape.outChannels : 0) << "x"
+                      << shape.inChannels << "x" << shape.kernelSize << ", expected "
+                      << expected->second.outChannels << "x" << expected->second.inChannels
+                      << "x" << expected->second.kernelSize << std::endl;
+            g_TestFailures++;
+        }
+    }
+}
+
+static void testInferConvShape()
+{
+    // n, s, m, l, x
+    const float depths[] = { 0.33F, 0.33F, 0.67F, 1.0F, 1.33F };
+    const float widths[] = { 0.25F, 0.50F, 0.75F, 1.0F, 1.25F };
+    for (int i = 0; i < 5; i++) {
+        checkShapes(buildP5(depths[i], widths[i]));
+        checkShapes(buildP6(depths[i], widths[i]));
+    }
+
+    // Missing sibling or sizes that do not divide are not convs
+    std::map<std::string, size_t> sizes = { { "a.conv.weight", 100 }, { "b.conv.weight", 64 },
+        { "b.bn.weight", 12 }, { "c.weight", 16 } };
+    ConvShape shape;
+    CHECK(!inferConvShape(sizes, "a.conv.weight", 100, shape));
+    CHECK(!inferConvShape(sizes, "b.conv.weight", 64, shape));
+    CHECK(!inferConvShape(sizes, "c.weight", 16, shape));
+}
+
+static std::vector<WeightBlob> makeBlobs(const ModelLayout& model, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.F, 1.F);
+    std::vector<WeightBlob> blobs;
+    for (const std::string& name : model.order) {
+        WeightBlob blob;
+        blob.name = name;
+        blob.values.resize(model.sizes.at(name));
+        for (uint32_t& v : blob.values) {
+            float f = normal(rng);
+            memcpy(&v, &f, sizeof(v));
+        }
+        blobs.push_back(std::move(blob));
+    }
+    return blobs;
+}
+
+static std::vector<float> toFloats(const WeightBlob& blob)
+{
+    std::vector<float> weights(blob.values.size());
+    memcpy(weights.data(), blob.values.data(), weights.size() * sizeof(float));
+    return weights;
+}
+
+static void testPrune24()
+{
+    // One output channel, eight input channels, 1x1
+    ConvShape shape;
+    shape.outChannels = 1;
+    shape.inChannels = 8;
+    shape.kernelSize = 1;
+    float w[8] = { 0.1F, -0.9F, 0.5F, 0.2F, 0.3F, 0.3F, -0.3F, 0.F };
+    CHECK(!isSparse24(w, shape));
+    prune24(w, shape);
+    const float expected[8] = { 0.F, -0.9F, 0.5F, 0.F, 0.3F, 0.3F, 0.F, 0.F };
+    for (int i = 0; i < 8; i++) {
+        // Ties keep the first indices
+        CHECK_EQ(w[i], expected[i]);
+    }
+    CHECK(isSparse24(w, shape));
+    CHECK_NEAR(zeroFraction(w, 8), 0.5, 1e-6);
+
+    // Groups run along the input channels, not along the kernel positions
+    shape.inChannels = 4;
+    shape.kernelSize = 3;
+    std::vector<float> k(4 * 9);
+    for (int c = 0; c < 4; c++) {
+        for (int p = 0; p < 9; p++) {
+            k[c * 9 + p] = (float)(c + 1) * (p % 2 ? 1.F : -1.F);
+        }
+    }
+    prune24(k.data(), shape);
+    for (int p = 0; p < 9; p++) {
+        CHECK_EQ(k[0 * 9 + p], 0.F);
+        CHECK_EQ(k[1 * 9 + p], 0.F);
+        CHECK(k[2 * 9 + p] != 0.F && k[3 * 9 + p] != 0.F);
+    }
+    CHECK(isSparse24(k.data(), shape));
+}
+
+static void testPruneModel()
+{
+    ModelLayout model = buildP5(0.33F, 0.25F);
+    const std::vector<WeightBlob> original = makeBlobs(model, 1);
+    std::vector<WeightBlob> blobs = original;
+
+    std::vector<PruneReport> reports = pruneWeights24(blobs, {});
+    CHECK_EQ(reports.size(), model.convs.size());
+    for (const PruneReport& report : reports) {
+        if (report.name == "model.0.conv.weight") {
+            // 3 input channels, the stem stays dense
+            CHECK(!report.pruned);
+            CHECK_EQ(report.reason, std::string("input channels not a multiple of 4"));
+            continue;
+        }
+        CHECK(report.pruned);
+        CHECK_NEAR(report.sparsityAfter, 0.5, 1e-6);
+    }
+
+    for (size_t i = 0; i < blobs.size(); i++) {
+        auto conv = model.convs.find(blobs[i].name);
+        if (conv == model.convs.end() || blobs[i].name == "model.0.conv.weight") {
+            // Everything else is bit-identical
+            CHECK(blobs[i].values == original[i].values);
+            continue;
+        }
+        std::vector<float> pruned = toFloats(blobs[i]);
+        std::vector<float> dense = toFloats(original[i]);
+        CHECK(isSparse24(pruned.data(), conv->second));
+        // Kept weights are unchanged, and no dropped weight is larger than a
+        // kept one of its group
+        const ConvShape& s = conv->second;
+        const int rs = s.kernelSize * s.kernelSize;
+        bool ordered = true;
+        for (size_t g = 0; g < pruned.size(); g++) {
+            ordered = ordered && (pruned[g] == 0.F || pruned[g] == dense[g]);
+        }
+        for (int kc = 0; kc < s.outChannels * s.inChannels; kc += 4) {
+            for (int p = 0; p < rs; p++) {
+                float minKept = INFINITY, maxDropped = 0.F;
+                for (int c = 0; c < 4; c++) {
+                    size_t idx = (size_t)(kc + c) * rs + p;
+                    if (pruned[idx] != 0.F) {
+                        minKept = std::min(minKept, std::fabs(dense[idx]));
+                    } else {
+                        maxDropped = std::max(maxDropped, std::fabs(dense[idx]));
+                    }
+                }
+                ordered = ordered && maxDropped <= minKept;
+            }
+        }
+        CHECK(ordered);
+    }
+
+    // Pruning a pruned model changes nothing
+    std::vector<WeightBlob> again = blobs;
+    pruneWeights24(again, {});
+    for (size_t i = 0; i < blobs.size(); i++) {
+        CHECK(again[i].values == blobs[i].values);
+    }
+}
+
+static void testSkipList()
+{
+    ModelLayout model = buildP5(0.33F, 0.25F);
+    const std::vector<WeightBlob> original = makeBlobs(model, 2);
+    std::vector<WeightBlob> blobs = original;
+
+    // A layer and everything below it, and a wildcard
+    std::vector<PruneReport> reports = pruneWeights24(blobs, { "model.24", "model.2.m.*" });
+    for (const PruneReport& report : reports) {
+        bool skipped = report.name.compare(0, 9, "model.24.") == 0 ||
+            report.name.compare(0, 10, "model.2.m.") == 0;
+        if (skipped) {
+            CHECK(!report.pruned);
+            CHECK_EQ(report.reason, std::string("skip list"));
+        } else if (report.name != "model.0.conv.weight") {
+            // model.2 does not skip model.20
+            CHECK(report.pruned);
+        }
+    }
+    for (size_t i = 0; i < blobs.size(); i++) {
+        if (blobs[i].name.compare(0, 9, "model.24.") == 0 || blobs[i].name.compare(0, 10, "model.2.m.") == 0) {
+            CHECK(blobs[i].values == original[i].values);
+        }
+    }
+}
+
+static void testWtsRoundTrip()
+{
+    ModelLayout model = buildP5(0.33F, 0.25F);
+    std::vector<WeightBlob> blobs = makeBlobs(model, 3);
+    pruneWeights24(blobs, {});
+
+    char path[] = "/tmp/test_weight_pruning_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    close(fd);
+    CHECK(writeWtsFile(path, blobs));
+    std::vector<WeightBlob> read;
+    CHECK(readWtsFile(path, read));
+    CHECK_EQ(read.size(), blobs.size());
+    for (size_t i = 0; i < read.size() && i < blobs.size(); i++) {
+        CHECK(read[i].name == blobs[i].name && read[i].values == blobs[i].values);
+    }
+    remove(path);
+}
+
+int main()
+{
+    testInferConvShape();
+    testPrune24();
+    testPruneModel();
+    testSkipList();
+    testWtsRoundTrip();
+    return testResult("test_weight_pruning");
+}
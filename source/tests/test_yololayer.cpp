@@ -0,0 +1,256 @@
+/*
+ * Host side of YoloLayerPlugin with the CUDA calls mocked: many threads
+ * enqueue on the plugin and on clones of it, each on its own stream, like
+ * concurrent execution contexts of one engine. Checks that enqueue leaves
+ * the serialized state unchanged, that clone() is a plain copy, and that
+ * every image's detection count is zeroed through cudaMemset2DAsync before
+ * the decode of each scale is launched on the same stream.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "yololayer.h"
+#include "test_utils.h"
+
+using namespace nvinfer1;
+
+// CUDA work recorded per calling thread, in call order
+struct Call
+{
+    enum Kind { kMemset, kLaunch } kind;
+    cudaStream_t stream;
+    // cudaMemset2DAsync
+    void* ptr;
+    size_t pitch;
+    int value;
+    size_t width;
+    size_t height;
+    // launchDetection
+    const float* input;
+    float* output;
+    int numElem;
+    int netWidth;
+    int netHeight;
+    int maxOut;
+    Yolo::YoloKernel yolo;
+    int classCount;
+    int outputElem;
+    int threadCount;
+};
+
+static thread_local std::vector<Call> t_Calls;
+static thread_local bool t_FailMemset = false;
+
+// Also clears the counts on the host buffer, so the tests can look at them
+cudaError_t cudaMemset2DAsync(void* ptr, size_t pitch, int value, size_t width, size_t height,
+    cudaStream_t stream)
+{
+    Call call = Call();
+    call.kind = Call::kMemset;
+    call.stream = stream;
+    call.ptr = ptr;
+    call.pitch = pitch;
+    call.value = value;
+    call.width = width;
+    call.height = height;
+    t_Calls.push_back(call);
+    if (t_FailMemset) {
+        return cudaErrorInvalidValue;
+    }
+    for (size_t row = 0; row < height; row++) {
+        memset((char*)ptr + row * pitch, value, width);
+    }
+    return cudaSuccess;
+}
+
+cudaError_t cudaGetLastError()
+{
+    return cudaSuccess;
+}
+
+namespace Yolo
+{
+    void launchDetection(const float* input, float* output, int numElem, int netWidth, int netHeight,
+        int maxOut, const YoloKernel& yolo, int classCount, int outputElem, int threadCount,
+        cudaStream_t stream)
+    {
+        Call call = Call();
+        call.kind = Call::kLaunch;
+        call.stream = stream;
+        call.input = input;
+        call.output = output;
+        call.numElem = numElem;
+        call.netWidth = netWidth;
+        call.netHeight = netHeight;
+        call.maxOut = maxOut;
+        call.yolo = yolo;
+        call.classCount = classCount;
+        call.outputElem = outputElem;
+        call.threadCount = threadCount;
+        t_Calls.push_back(call);
+    }
+}
+
+static const int kNetSize = 640;
+static const int kMaxOut = 1000;
+static const int kOutputElem = 1 + kMaxOut * sizeof(Yolo::Detection) / sizeof(float);
+static const int kMaxBatch = 4;
+
+// P6 layout, four scales of strides 8 to 64
+static std::vector<Yolo::YoloKernel> makeKernels(int netSize)
+{
+    std::vector<Yolo::YoloKernel> kernels(4);
+    for (int i = 0; i < 4; i++) {
+        kernels[i].width = kernels[i].height = netSize / (8 << i);
+        for (int j = 0; j < 2 * Yolo::CHECK_COUNT; j++) {
+            kernels[i].anchors[j] = 10.F * (i + 1) + j;
+        }
+    }
+    return kernels;
+}
+
+static std::vector<char> serialized(const IPluginV2& plugin)
+{
+    std::vector<char> data(plugin.getSerializationSize());
+    plugin.serialize(data.data());
+    return data;
+}
+
+// Runs one enqueue and checks the recorded calls; inputs are fake pointers,
+// only passed through
+static bool enqueueAndCheck(IPluginV2& plugin, int netSize, const std::vector<Yolo::YoloKernel>& kernels,
+    int batchSize, cudaStream_t stream, std::vector<float>& output)
+{
+    const float* inputs[4];
+    for (int i = 0; i < 4; i++) {
+        inputs[i] = (const float*)(uintptr_t)(0x1000 * (i + 1));
+    }
+    void* outputs[1] = { output.data() };
+    std::fill(output.begin(), output.end(), 7.F);
+    t_Calls.clear();
+    if (plugin.enqueue(batchSize, (const void* const*)inputs, outputs, nullptr, stream) != 0) {
+        return false;
+    }
+
+    bool ok = t_Calls.size() == 1 + kernels.size();
+    // One 2D memset of a float per image, at the output pitch, before any launch
+    const Call& memsetCall = t_Calls[0];
+    ok = ok && memsetCall.kind == Call::kMemset && memsetCall.stream == stream &&
+        memsetCall.ptr == output.data() && memsetCall.pitch == kOutputElem * sizeof(float) &&
+        memsetCall.value == 0 && memsetCall.width == sizeof(float) &&
+        memsetCall.height == (size_t)batchSize;
+    for (size_t i = 0; ok && i < kernels.size(); i++) {
+        const Call& launch = t_Calls[1 + i];
+        int numElem = kernels[i].width * kernels[i].height * batchSize;
+        ok = launch.kind == Call::kLaunch && launch.stream == stream && launch.input == inputs[i] &&
+            launch.output == output.data() && launch.numElem == numElem &&
+            launch.netWidth == netSize && launch.netHeight == netSize && launch.maxOut == kMaxOut &&
+            memcmp(&launch.yolo, &kernels[i], sizeof(Yolo::YoloKernel)) == 0 &&
+            launch.classCount == Yolo::CLASS_NUM && launch.outputElem == kOutputElem &&
+            launch.threadCount == std::min(256, numElem);
+    }
+    // Counts of the batch cleared, nothing else touched
+    for (int b = 0; b < kMaxBatch; b++) {
+        const float* image = &output[b * kOutputElem];
+        ok = ok && image[0] == (b < batchSize ? 0.F : 7.F) && image[1] == 7.F &&
+            image[kOutputElem - 1] == 7.F;
+    }
+    return ok;
+}
+
+// At 128 the coarse scales have fewer cells than a block has threads
+static void testEnqueue(int netSize)
+{
+    std::vector<Yolo::YoloKernel> kernels = makeKernels(netSize);
+    YoloLayerPlugin plugin(Yolo::CLASS_NUM, netSize, netSize, kMaxOut, kernels);
+    std::vector<float> output(kMaxBatch * kOutputElem);
+    for (int batchSize = 1; batchSize <= kMaxBatch; batchSize++) {
+        CHECK(enqueueAndCheck(plugin, netSize, kernels, batchSize, (cudaStream_t)(uintptr_t)batchSize, output));
+    }
+
+    // A failed memset launches nothing
+    t_FailMemset = true;
+    t_Calls.clear();
+    void* outputs[1] = { output.data() };
+    const void* inputs[4] = {};
+    CHECK_EQ(plugin.enqueue(1, inputs, outputs, nullptr, nullptr), -1);
+    CHECK_EQ(t_Calls.size(), (size_t)1);
+    t_FailMemset = false;
+}
+
+static void testClone()
+{
+    std::vector<Yolo::YoloKernel> kernels = makeKernels(kNetSize);
+    YoloLayerPlugin plugin(Yolo::CLASS_NUM, kNetSize, kNetSize, kMaxOut, kernels);
+    plugin.setPluginNamespace("yolo_ns");
+    std::vector<char> state = serialized(plugin);
+
+    IPluginV2* clone = plugin.clone();
+    CHECK(clone != &plugin);
+    CHECK(serialized(*clone) == state);
+    CHECK_EQ(std::string(clone->getPluginNamespace()), std::string("yolo_ns"));
+    CHECK_EQ(std::string(clone->getPluginType()), std::string(plugin.getPluginType()));
+    Dims dims = clone->getOutputDimensions(0, nullptr, 4);
+    CHECK(dims.nbDims == 3 && dims.d[0] == kOutputElem && dims.d[1] == 1 && dims.d[2] == 1);
+
+    // The clone enqueues the same work and owns nothing of the original
+    std::vector<float> output(kMaxBatch * kOutputElem);
+    CHECK(enqueueAndCheck(*clone, kNetSize, kernels, 3, nullptr, output));
+    std::vector<Call> cloneCalls = t_Calls;
+    clone->setPluginNamespace("other");
+    CHECK_EQ(std::string(plugin.getPluginNamespace()), std::string("yolo_ns"));
+    clone->destroy();
+    CHECK(enqueueAndCheck(plugin, kNetSize, kernels, 3, nullptr, output));
+    CHECK_EQ(t_Calls.size(), cloneCalls.size());
+    CHECK(serialized(plugin) == state);
+
+    // Deserializing the state gives the same plugin again
+    YoloLayerPlugin restored(state.data(), state.size());
+    CHECK(serialized(restored) == state);
+    CHECK(enqueueAndCheck(restored, kNetSize, kernels, 2, nullptr, output));
+}
+
+static void testConcurrentEnqueue()
+{
+    std::vector<Yolo::YoloKernel> kernels = makeKernels(kNetSize);
+    YoloLayerPlugin plugin(Yolo::CLASS_NUM, kNetSize, kNetSize, kMaxOut, kernels);
+    std::vector<char> state = serialized(plugin);
+
+    const int numThreads = 8;
+    const int iterations = 5000;
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            // One stream and one output buffer per context
+            cudaStream_t stream = (cudaStream_t)(uintptr_t)(0x100 + t);
+            std::vector<float> output(kMaxBatch * kOutputElem);
+            for (int i = 0; i < iterations; i++) {
+                int batchSize = 1 + (i + t) % kMaxBatch;
+                IPluginV2* clone = plugin.clone();
+                failures += !enqueueAndCheck(*clone, kNetSize, kernels, batchSize, stream, output);
+                clone->destroy();
+                failures += !enqueueAndCheck(plugin, kNetSize, kernels, batchSize, stream, output);
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    CHECK_EQ(failures.load(), 0);
+    CHECK(serialized(plugin) == state);
+}
+
+int main()
+{
+    testEnqueue(1280);
+    testEnqueue(128);
+    testClone();
+    testConcurrentEnqueue();
+    return testResult("test_yololayer");
+}
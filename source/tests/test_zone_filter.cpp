@@ -0,0 +1,393 @@
+/*
+ * Zone filtering: ZoneMask rasterization against a per-polygon even-odd test
+ * at the cell centers (edges, concave and self-intersecting polygons), test()
+ * clamping, include/exclude precedence per source and [zones] key parsing.
+ * Also the parser in mosaic mode, which tests each kept box against the
+ * zones of its tile's source in tile coordinates.
+ */
+
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+#include "custom_config.h"
+#include "nvdsinfer_custom_impl.h"
+#include "test_utils.h"
+#include "yololayer.h"
+#include "zone_filter.h"
+
+extern "C" bool NvDsInferParseCustomYoloV5(
+    std::vector<NvDsInferLayerInfo> const& outputLayersInfo,
+    NvDsInferNetworkInfo const& networkInfo,
+    NvDsInferParseDetectionParams const& detectionParams,
+    std::vector<NvDsInferParseObjectInfo>& objectList);
+
+static const double kPi = 3.14159265358979323846;
+
+// Even-odd rule for one point, the reference the bitmap must match at every
+// cell center
+static bool insidePolygon(const std::vector<ZonePoint>& polygon, float x, float y)
+{
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const ZonePoint& a = polygon[i];
+        const ZonePoint& b = polygon[j];
+        if ((a.y > y) != (b.y > y) && x < a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static bool cellSet(const ZoneMask& mask, int gridWidth, int gridHeight, int col, int row)
+{
+    return mask.test((col + 0.5F) / gridWidth, (row + 0.5F) / gridHeight);
+}
+
+// Number of cells where the mask and the union of the polygons disagree
+static int countMismatches(const std::vector<std::vector<ZonePoint>>& polygons, int gridWidth, int gridHeight)
+{
+    ZoneMask mask(gridWidth, gridHeight);
+    for (const std::vector<ZonePoint>& polygon : polygons) {
+        mask.addPolygon(polygon);
+    }
+    int mismatches = 0;
+    for (int row = 0; row < gridHeight; row++) {
+        for (int col = 0; col < gridWidth; col++) {
+            float x = (col + 0.5F) / gridWidth;
+            float y = (row + 0.5F) / gridHeight;
+            bool inside = false;
+            for (const std::vector<ZonePoint>& polygon : polygons) {
+                inside = inside || insidePolygon(polygon, x, y);
+            }
+            mismatches += inside != cellSet(mask, gridWidth, gridHeight, col, row);
+        }
+    }
+    return mismatches;
+}
+
+static void testRectangleEdges()
+{
+    // Edges exactly on cell centers of a 10 x 10 grid: a center on the left
+    // or top edge is inside, one on the right or bottom edge is not
+    ZoneMask mask(10, 10);
+    CHECK(mask.empty());
+    mask.addPolygon({ { 0.25F, 0.25F }, { 0.75F, 0.25F }, { 0.75F, 0.75F }, { 0.25F, 0.75F } });
+    CHECK(!mask.empty());
+    for (int row = 0; row < 10; row++) {
+        for (int col = 0; col < 10; col++) {
+            bool expected = col >= 2 && col < 7 && row >= 2 && row < 7;
+            CHECK_EQ(cellSet(mask, 10, 10, col, row), expected);
+        }
+    }
+
+    // Edges between centers: the cells whose centers are covered
+    ZoneMask between(10, 10);
+    between.addPolygon({ { 0.2F, 0.2F }, { 0.8F, 0.2F }, { 0.8F, 0.8F }, { 0.2F, 0.8F } });
+    for (int row = 0; row < 10; row++) {
+        for (int col = 0; col < 10; col++) {
+            CHECK_EQ(cellSet(between, 10, 10, col, row), col >= 2 && col < 8 && row >= 2 && row < 8);
+        }
+    }
+
+    // A zone thinner than a cell that misses every center sets nothing
+    ZoneMask thin(10, 10);
+    thin.addPolygon({ { 0.11F, 0.F }, { 0.14F, 0.F }, { 0.14F, 1.F }, { 0.11F, 1.F } });
+    CHECK(thin.empty());
+
+    // Fewer than three vertices are ignored
+    ZoneMask degenerate(10, 10);
+    degenerate.addPolygon({ { 0.F, 0.F }, { 1.F, 1.F } });
+    CHECK(degenerate.empty());
+
+    // The full frame sets every cell, on a grid that is not a multiple of 64
+    ZoneMask full(130, 7);
+    full.addPolygon({ { 0.F, 0.F }, { 1.F, 0.F }, { 1.F, 1.F }, { 0.F, 1.F } });
+    int set = 0;
+    for (int row = 0; row < 7; row++) {
+        for (int col = 0; col < 130; col++) {
+            set += cellSet(full, 130, 7, col, row);
+        }
+    }
+    CHECK_EQ(set, 130 * 7);
+}
+
+static void testShapes()
+{
+    // Concave L, a triangle with slanted edges, clockwise and counter-clockwise
+    std::vector<ZonePoint> lShape = { { 0.1F, 0.1F }, { 0.4F, 0.1F }, { 0.4F, 0.6F },
+        { 0.9F, 0.6F }, { 0.9F, 0.9F }, { 0.1F, 0.9F } };
+    std::vector<ZonePoint> triangle = { { 0.5F, 0.05F }, { 0.95F, 0.95F }, { 0.05F, 0.7F } };
+    std::vector<ZonePoint> reversed(triangle.rbegin(), triangle.rend());
+    // Self-intersecting star: the even-odd rule leaves the center pentagon out
+    std::vector<ZonePoint> star;
+    for (int i = 0; i < 5; i++) {
+        float angle = (float)(-kPi / 2 + i * 4 * kPi / 5);
+        star.push_back({ 0.5F + 0.45F * std::cos(angle), 0.5F + 0.45F * std::sin(angle) });
+    }
+    // Comb of narrow teeth, several crossings per row
+    std::vector<ZonePoint> comb = { { 0.F, 0.9F }, { 0.F, 0.1F } };
+    for (int t = 0; t < 8; t++) {
+        float x = t / 8.F;
+        comb.push_back({ x + 0.03F, 0.1F });
+        comb.push_back({ x + 0.03F, 0.7F });
+        comb.push_back({ x + 0.09F, 0.7F });
+        comb.push_back({ x + 0.09F, 0.1F });
+    }
+    comb.push_back({ 1.F, 0.1F });
+    comb.push_back({ 1.F, 0.9F });
+
+    for (int grid : { 16, 64, 100, 128, 200 }) {
+        CHECK_EQ(countMismatches({ lShape }, grid, grid), 0);
+        CHECK_EQ(countMismatches({ triangle }, grid, grid), 0);
+        CHECK_EQ(countMismatches({ reversed }, grid, grid), 0);
+        CHECK_EQ(countMismatches({ star }, grid, grid), 0);
+        CHECK_EQ(countMismatches({ comb }, grid, grid / 2 + 1), 0);
+        // Overlapping polygons are a union, not even-odd across polygons
+        CHECK_EQ(countMismatches({ lShape, triangle, star }, grid, grid), 0);
+    }
+    ZoneMask starMask(100, 100);
+    starMask.addPolygon(star);
+    CHECK(!starMask.test(0.5F, 0.5F));
+    CHECK(starMask.test(0.5F, 0.1F));
+
+    // Random polygons, vertices partly outside the frame
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-0.2F, 1.2F);
+    for (int n = 0; n < 200; n++) {
+        std::vector<ZonePoint> polygon(3 + rng() % 20);
+        for (ZonePoint& p : polygon) {
+            p = { coord(rng), coord(rng) };
+        }
+        CHECK_EQ(countMismatches({ polygon }, 97, 61), 0);
+    }
+}
+
+static void testClamping()
+{
+    ZoneMask mask(8, 8);
+    // Right column and bottom row only
+    mask.addPolygon({ { 0.875F, 0.F }, { 1.F, 0.F }, { 1.F, 1.F }, { 0.875F, 1.F } });
+    mask.addPolygon({ { 0.F, 0.875F }, { 1.F, 0.875F }, { 1.F, 1.F }, { 0.F, 1.F } });
+    // Exactly 1.0 and beyond map to the last cell, below 0 to the first
+    CHECK(mask.test(1.F, 0.5F));
+    CHECK(mask.test(5.F, 0.5F));
+    CHECK(mask.test(0.5F, 1.F));
+    CHECK(mask.test(0.5F, 1.5F));
+    CHECK(!mask.test(-1.F, 0.5F));
+    CHECK(!mask.test(0.5F, -0.01F));
+    CHECK(mask.test(-1.F, 1.F));
+    CHECK(!mask.test(0.874F, 0.5F));
+}
+
+static NvDsInferParseObjectInfo makeBox(float left, float top, float width, float height)
+{
+    NvDsInferParseObjectInfo b;
+    b.left = left;
+    b.top = top;
+    b.width = width;
+    b.height = height;
+    b.classId = 0;
+    b.detectionConfidence = 0.9F;
+    return b;
+}
+
+static void testFilter()
+{
+    const std::vector<ZonePoint> leftHalf = { { 0.F, 0.F }, { 0.5F, 0.F }, { 0.5F, 1.F }, { 0.F, 1.F } };
+    const std::vector<ZonePoint> topLeft = { { 0.F, 0.F }, { 0.25F, 0.F }, { 0.25F, 0.5F }, { 0.F, 0.5F } };
+    const std::vector<ZonePoint> rightHalf = { { 0.5F, 0.F }, { 1.F, 0.F }, { 1.F, 1.F }, { 0.5F, 1.F } };
+
+    ZoneFilter filter(64, 64, ZoneAnchor::kBottomCenter);
+    CHECK(!filter.hasZones(0));
+    CHECK(filter.accept(0, makeBox(10.F, 10.F, 5.F, 5.F), 640.F, 640.F));
+
+    // Default zones: include the left half, exclude its top-left quarter
+    filter.addInclude(-1, leftHalf);
+    filter.addExclude(-1, topLeft);
+    // Source 3 has its own zones, only an exclude, which replace the default
+    filter.addExclude(3, rightHalf);
+    CHECK(filter.hasZones(0));
+    CHECK(filter.hasZones(3));
+
+    // Anchored at the bottom center: (100, 400) inside include only
+    CHECK(filter.accept(0, makeBox(80.F, 350.F, 40.F, 50.F), 640.F, 640.F));
+    // Included and excluded: exclude wins
+    CHECK(!filter.accept(0, makeBox(80.F, 100.F, 40.F, 50.F), 640.F, 640.F));
+    // Box mostly in the exclude zone but anchored below it
+    CHECK(filter.accept(0, makeBox(80.F, 100.F, 40.F, 300.F), 640.F, 640.F));
+    // Outside the include zone
+    CHECK(!filter.accept(0, makeBox(400.F, 350.F, 40.F, 50.F), 640.F, 640.F));
+    // Bottom edge of the frame maps to the last row
+    CHECK(filter.accept(0, makeBox(80.F, 600.F, 40.F, 40.F), 640.F, 640.F));
+
+    // Source 3: no include zone means everywhere but the exclude
+    CHECK(filter.accept(3, makeBox(80.F, 100.F, 40.F, 50.F), 640.F, 640.F));
+    CHECK(!filter.accept(3, makeBox(400.F, 350.F, 40.F, 50.F), 640.F, 640.F));
+
+    // Center anchor: the same box is judged at its center
+    ZoneFilter centered(64, 64, ZoneAnchor::kCenter);
+    centered.addExclude(-1, topLeft);
+    CHECK(!centered.accept(0, makeBox(80.F, 100.F, 40.F, 300.F), 640.F, 640.F));
+    CHECK(centered.accept(0, makeBox(80.F, 300.F, 40.F, 300.F), 640.F, 640.F));
+
+    // Frame size scales the box into normalized coordinates
+    CHECK(filter.accept(0, makeBox(160.F, 700.F, 80.F, 100.F), 1280.F, 1280.F));
+    CHECK(!filter.accept(0, makeBox(160.F, 700.F, 80.F, 100.F), 1280.F, 2000.F));
+
+    // filter() keeps the accepted objects in order
+    std::vector<NvDsInferParseObjectInfo> objects = {
+        makeBox(80.F, 350.F, 40.F, 50.F),
+        makeBox(80.F, 100.F, 40.F, 50.F),
+        makeBox(400.F, 350.F, 40.F, 50.F),
+        makeBox(20.F, 500.F, 40.F, 50.F),
+    };
+    filter.filter(0, objects, 640.F, 640.F);
+    CHECK_EQ(objects.size(), (size_t)2);
+    CHECK(objects.size() == 2 && objects[0].left == 80.F && objects[1].left == 20.F);
+}
+
+static bool loadConfig(const std::string& text, CustomConfig& config)
+{
+    char path[] = "/tmp/test_zone_filter_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    std::ofstream(path) << text;
+    bool ok = config.load(path);
+    remove(path);
+    return ok;
+}
+
+static void testLoadFromConfig()
+{
+    CustomConfig config;
+    CHECK(loadConfig(
+        "[zones]\n"
+        "anchor=center\n"
+        "grid-size=64\n"
+        "# default include, two polygons\n"
+        "include = 0,0; 0.5,0; 0.5,0.5; 0,0.5 | 0.5,0.5;1,0.5;1,1;0.5,1\n"
+        "exclude-2=0,0;1,0;1,0.25;0,0.25\n"
+        "include-10=0.5,0;1,0;1,1;0.5,1\n"
+        "include-=0,0;1,0;1,1\n"
+        "includes=0,0;1,0;1,1\n"
+        "exclude2=0,0;1,0;1,1\n", config));
+
+    ZoneFilter filter(64, 64, ZoneAnchor::kCenter);
+    CHECK(filter.loadFromConfig(config));
+    // Default: top-left and bottom-right quarters
+    CHECK(filter.accept(0, makeBox(0.2F, 0.2F, 0.F, 0.F), 1.F, 1.F));
+    CHECK(filter.accept(0, makeBox(0.7F, 0.7F, 0.F, 0.F), 1.F, 1.F));
+    CHECK(!filter.accept(0, makeBox(0.7F, 0.2F, 0.F, 0.F), 1.F, 1.F));
+    // Source 2: exclude the top quarter, no include
+    CHECK(!filter.accept(2, makeBox(0.7F, 0.1F, 0.F, 0.F), 1.F, 1.F));
+    CHECK(filter.accept(2, makeBox(0.7F, 0.4F, 0.F, 0.F), 1.F, 1.F));
+    // Source 10: include the right half
+    CHECK(filter.accept(10, makeBox(0.7F, 0.2F, 0.F, 0.F), 1.F, 1.F));
+    CHECK(!filter.accept(10, makeBox(0.2F, 0.2F, 0.F, 0.F), 1.F, 1.F));
+    // Sources without keys of their own use the default
+    CHECK(filter.accept(1, makeBox(0.2F, 0.2F, 0.F, 0.F), 1.F, 1.F));
+    CHECK(!filter.accept(1, makeBox(0.7F, 0.2F, 0.F, 0.F), 1.F, 1.F));
+    // "include-", "includes" and "exclude2" are not zone keys: the triangle
+    // they hold would include (0.7, 0.2) above and exclude (0.9, 0.6) here
+    CHECK(filter.accept(0, makeBox(0.9F, 0.6F, 0.F, 0.F), 1.F, 1.F));
+
+    // Malformed polygons fail the load
+    const char* invalid[] = {
+        "[zones]\ninclude=0,0;1,0\n",
+        "[zones]\ninclude=0,0;1,0;1\n",
+        "[zones]\nexclude-1=0,0;1,0;1,1|0,0\n",
+    };
+    for (const char* text : invalid) {
+        CustomConfig bad;
+        CHECK(loadConfig(text, bad));
+        ZoneFilter rejected;
+        CHECK(!rejected.loadFromConfig(bad));
+    }
+
+    std::vector<ZonePoint> polygon;
+    CHECK(parseZonePolygon(" 0.1 , 0.2 ;0.3,0.4; 0.5,0.6 ", polygon));
+    CHECK_EQ(polygon.size(), (size_t)3);
+    CHECK(polygon.size() == 3 && polygon[0].x == 0.1F && polygon[2].y == 0.6F);
+    CHECK(!parseZonePolygon("", polygon));
+}
+
+// The custom config is read once per process, so this is the only test that
+// goes through the parser
+static void testParserMosaicZones()
+{
+    char path[] = "/tmp/test_zone_filter_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    // 2x2 tiles of 320x320. Default zones keep the left half of a tile,
+    // source 1 keeps its right half and source 2 excludes its whole tile.
+    std::ofstream(path) << "[mosaic]\n"
+                           "enable=1\n"
+                           "num-sources=4\n"
+                           "[zones]\n"
+                           "enable=1\n"
+                           "anchor=center\n"
+                           "include=0,0;0.5,0;0.5,1;0,1\n"
+                           "include-1=0.5,0;1,0;1,1;0.5,1\n"
+                           "exclude-2=0,0;1,0;1,1;0,1\n";
+    setenv("YOLOV5_CUSTOM_CONFIG", path, 1);
+
+    // Centers in mosaic coordinates, all 20x20
+    const float centers[][2] = {
+        { 80.F, 160.F },  // tile 0 at x 0.25, kept
+        { 240.F, 160.F }, // tile 0 at x 0.75, dropped
+        { 400.F, 160.F }, // tile 1 at x 0.25, dropped by include-1
+        { 560.F, 160.F }, // tile 1 at x 0.75, kept
+        { 80.F, 480.F },  // tile 2, excluded
+        { 400.F, 480.F }, // tile 3 at x 0.25, kept though right of the mosaic center
+        { 320.F, 160.F }, // straddles tiles 0 and 1, dropped by the mosaic
+    };
+    const int numBoxes = sizeof(centers) / sizeof(centers[0]);
+    std::vector<float> output(1 + Yolo::MAX_OUTPUT_BBOX_COUNT * sizeof(Yolo::Detection) / sizeof(float), 0.F);
+    output[0] = (float)numBoxes;
+    Yolo::Detection* dets = (Yolo::Detection*)(output.data() + 1);
+    for (int i = 0; i < numBoxes; i++) {
+        dets[i].bbox[0] = centers[i][0];
+        dets[i].bbox[1] = centers[i][1];
+        dets[i].bbox[2] = 20.F;
+        dets[i].bbox[3] = 20.F;
+        dets[i].conf = 0.9F;
+        dets[i].class_id = (float)i;
+    }
+
+    std::vector<NvDsInferLayerInfo> layers(1);
+    layers[0].buffer = output.data();
+    NvDsInferNetworkInfo networkInfo = { 640, 640, 3 };
+    NvDsInferParseDetectionParams detectionParams;
+    std::vector<NvDsInferParseObjectInfo> objects;
+    CHECK(NvDsInferParseCustomYoloV5(layers, networkInfo, detectionParams, objects));
+    remove(path);
+
+    // In mosaic coordinates, in output order
+    CHECK_EQ(objects.size(), (size_t)3);
+    if (objects.size() == 3) {
+        CHECK_EQ(objects[0].classId, 0U);
+        CHECK_EQ(objects[1].classId, 3U);
+        CHECK_EQ(objects[2].classId, 5U);
+        CHECK_NEAR(objects[2].left, 390.F, 1e-4);
+        CHECK_NEAR(objects[2].top, 470.F, 1e-4);
+    }
+}
+
+int main()
+{
+    testRectangleEdges();
+    testShapes();
+    testClamping();
+    testFilter();
+    testLoadFromConfig();
+    testParserMosaicZones();
+    return testResult("test_zone_filter");
+}
@@ -0,0 +1,112 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int numThreads)
+    : m_Remaining(0)
+{
+    if (numThreads <= 0) {
+        numThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+    }
+    for (int i = 0; i < numThreads; i++) {
+        m_Queues.emplace_back(new WorkQueue());
+    }
+    // Worker 0 is the thread calling parallelFor()
+    for (int i = 1; i < numThreads; i++) {
+        m_Threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wakeup.notify_all();
+    for (auto& t : m_Threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& func)
+{
+    if (count <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> call(m_CallMutex);
+
+    m_Func = &func;
+    m_Remaining = count;
+    int numQueues = getNumThreads();
+    int chunk = (count + numQueues - 1) / numQueues;
+    for (int q = 0; q < numQueues; q++) {
+        std::lock_guard<std::mutex> lock(m_Queues[q]->mutex);
+        for (int i = q * chunk; i < std::min((q + 1) * chunk, count); i++) {
+            m_Queues[q]->items.push_back(i);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Generation++;
+    }
+    m_Wakeup.notify_all();
+
+    runItems(0);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Done.wait(lock, [this] { return m_Remaining.load() == 0; });
+    m_Func = nullptr;
+}
+
+void ThreadPool::workerLoop(int worker)
+{
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wakeup.wait(lock, [&] { return m_Stop || m_Generation != seen; });
+            if (m_Stop) {
+                return;
+            }
+            seen = m_Generation;
+        }
+        runItems(worker);
+    }
+}
+
+void ThreadPool::runItems(int worker)
+{
+    int item;
+    while (popOrSteal(worker, item)) {
+        (*m_Func)(item, worker);
+        if (m_Remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::popOrSteal(int worker, int& item)
+{
+    {
+        WorkQueue& own = *m_Queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty()) {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+    int numQueues = getNumThreads();
+    for (int k = 1; k < numQueues; k++) {
+        WorkQueue& victim = *m_Queues[(worker + k) % numQueues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
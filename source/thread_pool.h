@@ -0,0 +1,60 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size work-stealing pool. parallelFor() deals the indices out in
+ * contiguous chunks, one queue per worker; a worker pops from the front of
+ * its own queue and steals from the back of the others once it runs dry,
+ * which balances frames with very different object counts. The calling
+ * thread works as well. Tasks must not call parallelFor() on the same pool.
+ */
+class ThreadPool {
+public:
+    // numThreads counts the calling thread, 0 uses all hardware threads
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+
+    // Runs func(index, worker) for every index in [0, count) and waits.
+    // worker is in [0, getNumThreads()) and identifies per-thread scratch.
+    void parallelFor(int count, const std::function<void(int index, int worker)>& func);
+
+    int getNumThreads() const { return (int)m_Queues.size(); }
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<int> items;
+    };
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void workerLoop(int worker);
+    void runItems(int worker);
+    bool popOrSteal(int worker, int& item);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+    std::vector<std::thread> m_Threads;
+
+    std::mutex m_CallMutex;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wakeup;
+    std::condition_variable m_Done;
+    const std::function<void(int, int)>* m_Func = nullptr;
+    std::atomic<int> m_Remaining;
+    uint64_t m_Generation = 0;
+    bool m_Stop = false;
+};
+
+#endif // _THREAD_POOL_H_
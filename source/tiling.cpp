@@ -0,0 +1,97 @@
+#include "tiling.h"
+
+#include <cassert>
+#include <cmath>
+
+// Start offsets of tiles covering [0, length), evenly spread so the first
+// tile starts at 0, the last one ends at length, and neighbours overlap by
+// at least overlap * tileLength
+static std::vector<float> tileOffsets(int length, int tileLength, float overlap)
+{
+    if (length <= tileLength) {
+        return std::vector<float>(1, 0.F);
+    }
+    float step = tileLength * (1.F - overlap);
+    int count = (int)std::ceil((length - tileLength) / step) + 1;
+    std::vector<float> offsets;
+    for (int i = 0; i < count; i++) {
+        offsets.push_back(std::round((float)i * (length - tileLength) / (count - 1)));
+    }
+    return offsets;
+}
+
+TilePlanner::TilePlanner(int frameWidth, int frameHeight, int tileWidth, int tileHeight,
+    float overlap, int refreshInterval, float margin)
+    : m_RefreshInterval(std::max(refreshInterval, 1)),
+      m_Margin(margin)
+{
+    assert(frameWidth > 0 && frameHeight > 0 && tileWidth > 0 && tileHeight > 0);
+    assert(overlap >= 0.F && overlap < 1.F);
+
+    std::vector<float> xs = tileOffsets(frameWidth, tileWidth, overlap);
+    std::vector<float> ys = tileOffsets(frameHeight, tileHeight, overlap);
+    for (float y : ys) {
+        for (float x : xs) {
+            TileRect tile;
+            tile.left = x;
+            tile.top = y;
+            tile.width = std::min(tileWidth, frameWidth);
+            tile.height = std::min(tileHeight, frameHeight);
+            m_Tiles.push_back(tile);
+        }
+    }
+}
+
+std::vector<int> TilePlanner::schedule(const std::vector<NvDsInferParseObjectInfo>& previous)
+{
+    bool refresh = (m_FrameCount % m_RefreshInterval) == 0;
+    m_FrameCount++;
+
+    std::vector<int> ids;
+    for (size_t i = 0; i < m_Tiles.size(); i++) {
+        const TileRect& tile = m_Tiles[i];
+        bool active = refresh;
+        for (size_t j = 0; !active && j < previous.size(); j++) {
+            const NvDsInferParseObjectInfo& obj = previous[j];
+            active = obj.left - m_Margin < tile.left + tile.width &&
+                obj.left + obj.width + m_Margin > tile.left &&
+                obj.top - m_Margin < tile.top + tile.height &&
+                obj.top + obj.height + m_Margin > tile.top;
+        }
+        if (active) {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+
+void mergeTileDetections(const std::vector<TileRect>& tiles, const std::vector<int>& tileIds,
+    const std::vector<std::vector<NvDsInferParseObjectInfo>>& perTile,
+    float netWidth, float netHeight, std::vector<NvDsInferParseObjectInfo>& merged,
+    TileMergeMode mode, float threshold, BoxMatchMetric metric)
+{
+    assert(tileIds.size() == perTile.size());
+    merged.clear();
+    for (size_t i = 0; i < tileIds.size(); i++) {
+        const TileRect& tile = tiles[tileIds[i]];
+        float sx = tile.width / netWidth;
+        float sy = tile.height / netHeight;
+        for (const auto& object : perTile[i]) {
+            NvDsInferParseObjectInfo obj = object;
+            obj.left = tile.left + obj.left * sx;
+            obj.top = tile.top + obj.top * sy;
+            obj.width *= sx;
+            obj.height *= sy;
+            clipBox(obj, tile.left, tile.top, tile.width, tile.height);
+            if (boxArea(obj) > 0.F) {
+                merged.push_back(obj);
+            }
+        }
+    }
+
+    if (mode == TileMergeMode::kFusion) {
+        fuseBoxes(merged, threshold, metric);
+    } else {
+        nonMaximumSuppression(merged, threshold, metric);
+    }
+}
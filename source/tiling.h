@@ -0,0 +1,48 @@
+#ifndef _TILING_H_
+#define _TILING_H_
+
+#include <vector>
+#include "box_utils.h"
+
+/**
+ * Plans overlapping tiles for sliced inference of one high resolution
+ * source. Each tile is scaled into the network input, so a 640x640 tile of a
+ * 3840x2160 frame keeps small objects at native resolution.
+ *
+ * Scheduling is adaptive: a tile only runs when a detection of the previous
+ * frame (grown by margin pixels) overlaps it, and every refreshInterval
+ * frames all tiles run so that objects entering empty tiles are found.
+ */
+class TilePlanner {
+public:
+    TilePlanner(int frameWidth, int frameHeight, int tileWidth, int tileHeight,
+        float overlap, int refreshInterval = 1, float margin = 32.F);
+
+    const std::vector<TileRect>& getTiles() const { return m_Tiles; }
+
+    // Indices of the tiles to infer for the next frame
+    std::vector<int> schedule(const std::vector<NvDsInferParseObjectInfo>& previous);
+
+    void reset() { m_FrameCount = 0; }
+
+private:
+    std::vector<TileRect> m_Tiles;
+    int m_RefreshInterval;
+    float m_Margin;
+    int m_FrameCount = 0;
+};
+
+enum class TileMergeMode { kNms, kFusion };
+
+/**
+ * Maps per-tile detections back to frame coordinates and merges duplicates
+ * found by overlapping tiles. perTile[i] holds the detections of
+ * tiles[tileIds[i]] in network coordinates of a netWidth x netHeight input.
+ */
+void mergeTileDetections(const std::vector<TileRect>& tiles, const std::vector<int>& tileIds,
+    const std::vector<std::vector<NvDsInferParseObjectInfo>>& perTile,
+    float netWidth, float netHeight, std::vector<NvDsInferParseObjectInfo>& merged,
+    TileMergeMode mode = TileMergeMode::kNms, float threshold = 0.5F,
+    BoxMatchMetric metric = BoxMatchMetric::kIoS);
+
+#endif // _TILING_H_
@@ -0,0 +1,243 @@
+#include "weight_pruning.h"
+#include "precision_profile.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+bool readWtsFile(const std::string& path, std::vector<WeightBlob>& blobs)
+{
+    std::ifstream input(path);
+    if (!input.is_open()) {
+        std::cerr << "Unable to open weights file: " << path << std::endl;
+        return false;
+    }
+
+    int32_t count = 0;
+    input >> count;
+    if (count <= 0) {
+        std::cerr << "Invalid weights file: " << path << std::endl;
+        return false;
+    }
+
+    blobs.clear();
+    blobs.reserve(count);
+    while (count--) {
+        WeightBlob blob;
+        uint32_t size = 0;
+        input >> blob.name >> std::dec >> size;
+        blob.values.resize(size);
+        for (uint32_t i = 0; i < size; i++) {
+            input >> std::hex >> blob.values[i];
+        }
+        if (!input) {
+            std::cerr << "Truncated weights file: " << path << std::endl;
+            return false;
+        }
+        blobs.push_back(std::move(blob));
+    }
+    return true;
+}
+
+bool writeWtsFile(const std::string& path, const std::vector<WeightBlob>& blobs)
+{
+    std::ofstream output(path);
+    if (!output.is_open()) {
+        std::cerr << "Unable to write weights file: " << path << std::endl;
+        return false;
+    }
+
+    output << blobs.size() << "\n";
+    for (const WeightBlob& blob : blobs) {
+        output << blob.name << " " << std::dec << blob.values.size();
+        output << std::hex << std::setfill('0');
+        for (uint32_t v : blob.values) {
+            output << " " << std::setw(8) << v;
+        }
+        output << "\n";
+    }
+    return output.good();
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() &&
+        s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// model.<N>.conv.weight
+static bool isTopLevelConv(const std::string& name)
+{
+    if (name.compare(0, 6, "model.") != 0) {
+        return false;
+    }
+    size_t pos = 6;
+    while (pos < name.size() && isdigit(name[pos])) {
+        pos++;
+    }
+    return pos > 6 && name.compare(pos, std::string::npos, ".conv.weight") == 0;
+}
+
+bool inferConvShape(const std::map<std::string, size_t>& blobSizes,
+    const std::string& name, size_t count, ConvShape& shape)
+{
+    std::string outName;
+    if (endsWith(name, ".conv.weight")) {
+        outName = name.substr(0, name.size() - 12) + ".bn.weight";
+    }
+    else if (endsWith(name, ".weight")) {
+        outName = name.substr(0, name.size() - 7) + ".bias";
+    }
+    else {
+        return false;
+    }
+    auto it = blobSizes.find(outName);
+    if (it == blobSizes.end() || it->second == 0 ||
+        count <= it->second || count % it->second != 0) {
+        // Not a conv, e.g. a batch norm weight next to its bias
+        return false;
+    }
+
+    int k = (int)it->second;
+    int e = (int)(count / it->second);
+    int ks = 1;
+    if (name.compare(0, 8, "model.0.") == 0) {
+        ks = 6;
+    }
+    else if (name.find(".cv2.conv.weight") != std::string::npos &&
+        name.find(".m.") != std::string::npos) {
+        ks = 3;
+    }
+    else if (isTopLevelConv(name) && e % 9 == 0 && 2 * (e / 9) >= k && e / 9 <= k) {
+        ks = 3;
+    }
+    if (e % (ks * ks) != 0) {
+        return false;
+    }
+
+    shape.outChannels = k;
+    shape.inChannels = e / (ks * ks);
+    shape.kernelSize = ks;
+    return true;
+}
+
+void prune24(float* weights, const ConvShape& shape)
+{
+    const int rs = shape.kernelSize * shape.kernelSize;
+    for (int k = 0; k < shape.outChannels; k++) {
+        for (int c = 0; c < shape.inChannels; c += 4) {
+            for (int p = 0; p < rs; p++) {
+                float* w[4];
+                for (int i = 0; i < 4; i++) {
+                    w[i] = weights + ((size_t)k * shape.inChannels + c + i) * rs + p;
+                }
+                // Keep the two largest magnitudes, first index wins ties
+                int first = 0, second = -1;
+                for (int i = 1; i < 4; i++) {
+                    if (std::fabs(*w[i]) > std::fabs(*w[first])) {
+                        second = first;
+                        first = i;
+                    }
+                    else if (second < 0 || std::fabs(*w[i]) > std::fabs(*w[second])) {
+                        second = i;
+                    }
+                }
+                for (int i = 0; i < 4; i++) {
+                    if (i != first && i != second) {
+                        *w[i] = 0.f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool isSparse24(const float* weights, const ConvShape& shape)
+{
+    if (shape.inChannels % 4 != 0) {
+        return false;
+    }
+    const int rs = shape.kernelSize * shape.kernelSize;
+    for (int k = 0; k < shape.outChannels; k++) {
+        for (int c = 0; c < shape.inChannels; c += 4) {
+            for (int p = 0; p < rs; p++) {
+                int nonZeros = 0;
+                for (int i = 0; i < 4; i++) {
+                    if (weights[((size_t)k * shape.inChannels + c + i) * rs + p] != 0.f) {
+                        nonZeros++;
+                    }
+                }
+                if (nonZeros > 2) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+float zeroFraction(const float* weights, size_t count)
+{
+    if (count == 0) {
+        return 0.f;
+    }
+    size_t zeros = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (weights[i] == 0.f) {
+            zeros++;
+        }
+    }
+    return (float)zeros / count;
+}
+
+static bool isSkipped(const std::string& name, const std::vector<std::string>& skipPatterns)
+{
+    for (const std::string& pattern : skipPatterns) {
+        if (wildcardMatch(pattern.c_str(), name.c_str()) ||
+            wildcardMatch((pattern + ".*").c_str(), name.c_str())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<PruneReport> pruneWeights24(std::vector<WeightBlob>& blobs,
+    const std::vector<std::string>& skipPatterns)
+{
+    std::map<std::string, size_t> blobSizes;
+    for (const WeightBlob& blob : blobs) {
+        blobSizes[blob.name] = blob.values.size();
+    }
+
+    std::vector<PruneReport> reports;
+    std::vector<float> weights;
+    for (WeightBlob& blob : blobs) {
+        PruneReport report;
+        if (!inferConvShape(blobSizes, blob.name, blob.values.size(), report.shape)) {
+            continue;
+        }
+        report.name = blob.name;
+
+        weights.resize(blob.values.size());
+        memcpy(weights.data(), blob.values.data(), weights.size() * sizeof(float));
+        report.sparsityBefore = zeroFraction(weights.data(), weights.size());
+
+        if (isSkipped(blob.name, skipPatterns)) {
+            report.reason = "skip list";
+        }
+        else if (report.shape.inChannels % 4 != 0) {
+            report.reason = "input channels not a multiple of 4";
+        }
+        else {
+            prune24(weights.data(), report.shape);
+            memcpy(blob.values.data(), weights.data(), weights.size() * sizeof(float));
+            report.pruned = true;
+        }
+        report.sparsityAfter = zeroFraction(weights.data(), weights.size());
+        reports.push_back(report);
+    }
+    return reports;
+}
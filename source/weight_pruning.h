@@ -0,0 +1,71 @@
+#ifndef _WEIGHT_PRUNING_H_
+#define _WEIGHT_PRUNING_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// One named blob of a .wts file, values kept as raw float bit patterns so a
+// read/write round trip is exact
+struct WeightBlob
+{
+    std::string name;
+    std::vector<uint32_t> values;
+};
+
+bool readWtsFile(const std::string& path, std::vector<WeightBlob>& blobs);
+bool writeWtsFile(const std::string& path, const std::vector<WeightBlob>& blobs);
+
+// KCRS shape of a conv weight blob
+struct ConvShape
+{
+    int outChannels = 0;
+    int inChannels = 0;
+    int kernelSize = 0;
+};
+
+/**
+ * Recovers the shape of a conv weight from the names and sizes in the file,
+ * which carries no shapes. The output channels come from the sibling
+ * "<lname>.bn.weight" or "<lname>.bias" blob. The kernel size follows the
+ * yolov5 v6.1 layout built in yolov5.cpp: 6x6 for the model.0 stem, 3x3 for
+ * bottleneck cv2 and the stride 2 top-level convs (input channels between
+ * half and all of the output channels), 1x1 everywhere else. Returns false
+ * for blobs that are not conv weights.
+ */
+bool inferConvShape(const std::map<std::string, size_t>& blobSizes,
+    const std::string& name, size_t count, ConvShape& shape);
+
+// Zeroes the two smallest magnitudes in every group of four consecutive input
+// channels at each (k, r, s), the 2:4 pattern of sparse tensor cores.
+// inChannels must be a multiple of 4.
+void prune24(float* weights, const ConvShape& shape);
+
+// True when every group of four input channels has at most two non-zeros
+bool isSparse24(const float* weights, const ConvShape& shape);
+
+// Fraction of exact zeros
+float zeroFraction(const float* weights, size_t count);
+
+struct PruneReport
+{
+    std::string name;
+    ConvShape shape;
+    bool pruned = false;
+    std::string reason;
+    float sparsityBefore = 0.f;
+    float sparsityAfter = 0.f;
+};
+
+/**
+ * 2:4 magnitude pruning of all conv weights in blobs, in place. Layers whose
+ * name matches a skip pattern (a layer name, optionally with '*', matching
+ * the layer or anything below it as in precision profiles) or whose input
+ * channels are not a multiple of 4 are left dense. Returns one report per
+ * conv weight blob.
+ */
+std::vector<PruneReport> pruneWeights24(std::vector<WeightBlob>& blobs,
+    const std::vector<std::string>& skipPatterns);
+
+#endif // _WEIGHT_PRUNING_H_
@@ -0,0 +1,381 @@
+#include "weight_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+static const size_t kArenaAlignment = 64;
+
+WeightArena::WeightArena(size_t chunkBytes)
+    : m_ChunkBytes(chunkBytes)
+{
+}
+
+WeightArena::~WeightArena()
+{
+    for (void* chunk : m_Chunks) {
+        free(chunk);
+    }
+}
+
+void* WeightArena::allocate(size_t bytes)
+{
+    bytes = (bytes + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+    if (bytes > m_Remaining) {
+        // Blobs larger than a quarter chunk get a chunk of their own so the
+        // tail of the current chunk is not wasted
+        size_t chunkBytes = bytes > m_ChunkBytes / 4 ? bytes : m_ChunkBytes;
+        void* chunk = nullptr;
+        if (posix_memalign(&chunk, kArenaAlignment, chunkBytes) != 0) {
+            std::cerr << "Weight arena out of memory" << std::endl;
+            abort();
+        }
+        m_Chunks.push_back(chunk);
+        m_BytesReserved += chunkBytes;
+        if (chunkBytes == bytes) {
+            return chunk;
+        }
+        m_Cursor = static_cast<char*>(chunk);
+        m_Remaining = chunkBytes;
+    }
+    void* p = m_Cursor;
+    m_Cursor += bytes;
+    m_Remaining -= bytes;
+    return p;
+}
+
+// FNV-1a
+static uint64_t hashName(const char* name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+WeightStore::WeightStore(const WeightStore* parent)
+    : m_Parent(parent), m_Slots(256)
+{
+    for (Entry& slot : m_Slots) {
+        slot.name = nullptr;
+    }
+}
+
+const WeightStore::Entry* WeightStore::lookup(const char* name, size_t length, uint64_t hash) const
+{
+    const size_t mask = m_Slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Entry& slot = m_Slots[i];
+        if (!slot.name) {
+            return nullptr;
+        }
+        if (slot.hash == hash && strncmp(slot.name, name, length) == 0 && slot.name[length] == '\0') {
+            return &slot;
+        }
+    }
+}
+
+const nvinfer1::Weights* WeightStore::find(const char* name) const
+{
+    size_t length = strlen(name);
+    uint64_t hash = hashName(name, length);
+    for (const WeightStore* store = this; store; store = store->m_Parent) {
+        const Entry* entry = store->lookup(name, length, hash);
+        if (entry) {
+            return &entry->weights;
+        }
+    }
+    return nullptr;
+}
+
+nvinfer1::Weights WeightStore::get(const char* name) const
+{
+    const nvinfer1::Weights* weights = find(name);
+    if (!weights) {
+        return nvinfer1::Weights{ nvinfer1::DataType::kFLOAT, nullptr, 0 };
+    }
+    return *weights;
+}
+
+float* WeightStore::allocate(size_t count)
+{
+    return static_cast<float*>(m_Arena.allocate(count * sizeof(float)));
+}
+
+void WeightStore::add(const char* name, const nvinfer1::Weights& weights)
+{
+    insert(name, strlen(name), weights);
+}
+
+void WeightStore::insert(const char* name, size_t length, const nvinfer1::Weights& weights)
+{
+    // Keep the load factor below 1/2
+    if (2 * (m_Size + 1) > m_Slots.size()) {
+        rehash(2 * m_Slots.size());
+    }
+    uint64_t hash = hashName(name, length);
+    const size_t mask = m_Slots.size() - 1;
+    size_t i = hash & mask;
+    for (; m_Slots[i].name; i = (i + 1) & mask) {
+        Entry& slot = m_Slots[i];
+        if (slot.hash == hash && strncmp(slot.name, name, length) == 0 && slot.name[length] == '\0') {
+            slot.weights = weights;
+            return;
+        }
+    }
+    char* interned = static_cast<char*>(m_Arena.allocate(length + 1));
+    memcpy(interned, name, length);
+    interned[length] = '\0';
+    m_Slots[i].hash = hash;
+    m_Slots[i].name = interned;
+    m_Slots[i].weights = weights;
+    m_Size++;
+}
+
+void WeightStore::rehash(size_t capacity)
+{
+    std::vector<Entry> slots(capacity);
+    for (Entry& slot : slots) {
+        slot.name = nullptr;
+    }
+    const size_t mask = capacity - 1;
+    for (const Entry& entry : m_Slots) {
+        if (!entry.name) {
+            continue;
+        }
+        size_t i = entry.hash & mask;
+        while (slots[i].name) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = entry;
+    }
+    m_Slots.swap(slots);
+}
+
+void WeightStore::forEach(const std::function<void(const char* name, const nvinfer1::Weights& weights)>& func) const
+{
+    for (const WeightStore* store = this; store; store = store->m_Parent) {
+        for (const Entry& entry : store->m_Slots) {
+            if (entry.name) {
+                func(entry.name, entry.weights);
+            }
+        }
+    }
+}
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+namespace
+{
+// Space delimited tokens of a file read through a fixed window, so the text
+// of the file never sits in memory as a whole. A token stays valid until the
+// next call.
+class TokenReader {
+public:
+    TokenReader(int fd, uint64_t fileSize)
+        : m_Fd(fd), m_FileSize(fileSize), m_Buffer(1 << 20)
+    {
+        m_Pos = m_End = m_Buffer.data();
+    }
+
+    // False at the end of the file, on a read error or on a token longer
+    // than the window
+    bool next(const char*& token, size_t& length)
+    {
+        for (;;) {
+            while (m_Pos < m_End && isSpace(*m_Pos)) {
+                m_Pos++;
+            }
+            const char* p = m_Pos;
+            while (p < m_End && !isSpace(*p)) {
+                p++;
+            }
+            // A token running into the end of the window may go on in the
+            // part of the file not read yet
+            if (p < m_End || (m_Eof && p > m_Pos)) {
+                token = m_Pos;
+                length = p - m_Pos;
+                m_Pos = p;
+                return true;
+            }
+            if (m_Eof || !refill()) {
+                return false;
+            }
+        }
+    }
+
+    // Bytes of the file after the last token
+    uint64_t remaining() const { return m_FileSize - m_Consumed - (m_Pos - m_Buffer.data()); }
+
+private:
+    bool refill()
+    {
+        size_t kept = m_End - m_Pos;
+        if (kept == m_Buffer.size()) {
+            return false;
+        }
+        m_Consumed += m_Pos - m_Buffer.data();
+        memmove(m_Buffer.data(), m_Pos, kept);
+        ssize_t bytes;
+        do {
+            bytes = read(m_Fd, m_Buffer.data() + kept, m_Buffer.size() - kept);
+        } while (bytes < 0 && errno == EINTR);
+        if (bytes < 0) {
+            return false;
+        }
+        m_Pos = m_Buffer.data();
+        m_End = m_Pos + kept + bytes;
+        m_Eof = bytes == 0;
+        return true;
+    }
+
+    const int m_Fd;
+    const uint64_t m_FileSize;
+    std::vector<char> m_Buffer;
+    const char* m_Pos;
+    const char* m_End;
+    uint64_t m_Consumed = 0;
+    bool m_Eof = false;
+};
+}
+
+static inline bool parseHex(const char* digits, size_t length, uint32_t& value)
+{
+    uint32_t v = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = digits[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9') {
+            d = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            d = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            d = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        v = (v << 4) | d;
+    }
+    value = v;
+    return true;
+}
+
+static inline bool parseDecimal(const char* digits, size_t length, uint64_t& value)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (digits[i] < '0' || digits[i] > '9' || v > (UINT64_MAX - 9) / 10) {
+            return false;
+        }
+        v = v * 10 + (digits[i] - '0');
+    }
+    value = v;
+    return true;
+}
+
+// TensorRT weight files have a simple space delimited format:
+// [count] then per blob [name] [size] <data x size in hex>
+// The file is read through a small window rather than streamed through
+// iostreams, which dominated the load time, or mapped, which kept megabytes
+// of its text resident ahead of the parse, and the values are decoded
+// straight into the arena.
+bool WeightStore::load(const std::string& filePath)
+{
+    std::cout << "Loading weights: " << filePath << std::endl;
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Unable to load weight file, please check the wts file path: " << filePath << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "Invalid weight map file: " << filePath << std::endl;
+        close(fd);
+        return false;
+    }
+    TokenReader reader(fd, st.st_size);
+    const char* token;
+    size_t length;
+
+    uint64_t count = 0;
+    bool ok = reader.next(token, length) && parseDecimal(token, length, count) && count > 0;
+    std::string name;
+    while (ok && count--) {
+        ok = reader.next(token, length);
+        if (!ok) {
+            break;
+        }
+        name.assign(token, length);
+
+        // Every value takes a hex digit and a separator at least, so a larger
+        // size is a corrupt file rather than a blob worth allocating
+        uint64_t size = 0;
+        ok = reader.next(token, length) && parseDecimal(token, length, size) &&
+            size <= reader.remaining() / 2;
+        if (!ok) {
+            break;
+        }
+
+        uint32_t* values = static_cast<uint32_t*>(m_Arena.allocate(size * sizeof(uint32_t)));
+        for (uint64_t i = 0; i < size && ok; i++) {
+            ok = reader.next(token, length) && parseHex(token, length, values[i]);
+        }
+        if (ok) {
+            nvinfer1::Weights weights{ nvinfer1::DataType::kFLOAT, values, (int64_t)size };
+            insert(name.data(), name.size(), weights);
+        }
+    }
+    close(fd);
+
+    if (!ok) {
+        std::cerr << "Invalid weight map file: " << filePath << std::endl;
+    }
+    return ok;
+}
+
+WeightName::WeightName(const char* prefix, const char* suffix)
+{
+    append(prefix, strlen(prefix));
+    append(suffix, strlen(suffix));
+}
+
+WeightName::WeightName(const char* prefix, const char* suffix, int index)
+{
+    append(prefix, strlen(prefix));
+    append(suffix, strlen(suffix));
+    char digits[16];
+    char* p = digits + sizeof(digits);
+    unsigned int v = index < 0 ? 0U - (unsigned int)index : (unsigned int)index;
+    do {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (index < 0) {
+        *--p = '-';
+    }
+    append(p, digits + sizeof(digits) - p);
+}
+
+void WeightName::append(const char* text, size_t length)
+{
+    // A truncated name would silently look up the wrong blob, or none, in
+    // release builds as well
+    if (m_Length + length >= sizeof(m_Name)) {
+        m_Name[m_Length] = '\0';
+        std::cerr << "Weight name too long (" << m_Length + length << " characters, at most "
+                  << sizeof(m_Name) - 1 << "): " << m_Name << "..." << std::endl;
+        abort();
+    }
+    memcpy(m_Name + m_Length, text, length);
+    m_Length += length;
+    m_Name[m_Length] = '\0';
+}
@@ -0,0 +1,111 @@
+#ifndef _WEIGHT_STORE_H_
+#define _WEIGHT_STORE_H_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+
+/**
+ * Monotonic allocator owning all builder-time weight memory. Allocations are
+ * bumped out of large chunks and only released, all at once, when the arena
+ * is destroyed.
+ */
+class WeightArena {
+public:
+    explicit WeightArena(size_t chunkBytes = 4 << 20);
+    ~WeightArena();
+
+    // 64-byte aligned, uninitialized
+    void* allocate(size_t bytes);
+    size_t getBytesReserved() const { return m_BytesReserved; }
+
+private:
+    WeightArena(const WeightArena&) = delete;
+    WeightArena& operator=(const WeightArena&) = delete;
+
+    const size_t m_ChunkBytes;
+    std::vector<void*> m_Chunks;
+    char* m_Cursor = nullptr;
+    size_t m_Remaining = 0;
+    size_t m_BytesReserved = 0;
+};
+
+/**
+ * Named weights of a network, keyed by the wts blob names. Names are interned
+ * in the arena and indexed by an open-addressing hash table, so lookups take
+ * a plain C string and never allocate.
+ *
+ * A store may sit on top of a read-only parent, e.g. weights loaded once and
+ * shared by concurrent engine builds: lookups fall through to the parent and
+ * derived weights (folded batch norms) go into the child.
+ */
+class WeightStore {
+public:
+    explicit WeightStore(const WeightStore* parent = nullptr);
+
+    // Parses a wts file into the arena
+    bool load(const std::string& filePath);
+
+    // nullptr when neither this store nor its parent holds name
+    const nvinfer1::Weights* find(const char* name) const;
+    bool contains(const char* name) const { return find(name) != nullptr; }
+    // Empty weights when name is missing, like the map lookups this replaces
+    nvinfer1::Weights get(const char* name) const;
+
+    // Float buffer owned by the store, for weights derived while building
+    float* allocate(size_t count);
+    void add(const char* name, const nvinfer1::Weights& weights);
+
+    // Calls func for every entry of this store, then of its parent
+    void forEach(const std::function<void(const char* name, const nvinfer1::Weights& weights)>& func) const;
+
+    size_t size() const { return m_Size; }
+    size_t getBytesReserved() const { return m_Arena.getBytesReserved(); }
+
+private:
+    struct Entry
+    {
+        uint64_t hash;
+        const char* name;
+        nvinfer1::Weights weights;
+    };
+
+    WeightStore(const WeightStore&) = delete;
+    WeightStore& operator=(const WeightStore&) = delete;
+
+    const Entry* lookup(const char* name, size_t length, uint64_t hash) const;
+    void insert(const char* name, size_t length, const nvinfer1::Weights& weights);
+    void rehash(size_t capacity);
+
+    const WeightStore* m_Parent;
+    WeightArena m_Arena;
+    // Power of two slots, empty slots have a null name
+    std::vector<Entry> m_Slots;
+    size_t m_Size = 0;
+};
+
+/**
+ * Weight or layer name composed in a fixed buffer, e.g.
+ * WeightName(lname, ".bn.weight") or WeightName(lname, ".m.", i), so builder
+ * helpers compose names without std::string temporaries or printf
+ * formatting on every lookup. Names longer than the buffer abort.
+ */
+class WeightName {
+public:
+    WeightName(const char* prefix, const char* suffix);
+    // prefix and suffix followed by index in decimal
+    WeightName(const char* prefix, const char* suffix, int index);
+    operator const char*() const { return m_Name; }
+    const char* c_str() const { return m_Name; }
+
+private:
+    void append(const char* text, size_t length);
+
+    char m_Name[128];
+    size_t m_Length = 0;
+};
+
+#endif // _WEIGHT_STORE_H_
@@ -0,0 +1,61 @@
+#ifndef _YOLO_DECODE_H_
+#define _YOLO_DECODE_H_
+
+#include <cmath>
+#include "host_device.h"
+#include "yololayer.h"
+
+/*
+ * Decode of one anchor of one grid cell of a detect conv output, shared by
+ * the CalDetection kernel and yoloDecodeReference. cell points at the first
+ * channel of the anchor, its channels are totalGrid floats apart:
+ * [x y w h objectness class scores...].
+ */
+namespace Yolo
+{
+    HOST_DEVICE inline float logist(float data) { return 1.0f / (1.0f + expf(-data)); }
+
+    // Objectness times the best class probability, false when the objectness
+    // is below IGNORE_THRESH
+    HOST_DEVICE inline bool decodeScore(const float* cell, int totalGrid, int classes,
+        float& conf, int& classId)
+    {
+        float boxProb = logist(cell[4 * totalGrid]);
+        if (boxProb < IGNORE_THRESH) {
+            return false;
+        }
+        float maxClsProb = 0.0f;
+        classId = 0;
+        for (int c = 0; c < classes; c++) {
+            float p = logist(cell[(5 + c) * totalGrid]);
+            if (p > maxClsProb) {
+                maxClsProb = p;
+                classId = c;
+            }
+        }
+        conf = boxProb * maxClsProb;
+        return true;
+    }
+
+    // Center and size of anchor k at (row, col), in network input pixels
+    HOST_DEVICE inline void decodeBox(const float* cell, int totalGrid, const YoloKernel& yolo, int k,
+        int row, int col, int netWidth, int netHeight, float bbox[LOCATIONS])
+    {
+        // pytorch:
+        //  y = x[i].sigmoid()
+        //  y[..., 0:2] = (y[..., 0:2] * 2. - 0.5 + self.grid[i].to(x[i].device)) * self.stride[i]  # xy
+        //  y[..., 2:4] = (y[..., 2:4] * 2) ** 2 * self.anchor_grid[i]  # wh
+        //  X: (sigmoid(tx) + cx)/FeaturemapW *  netwidth
+        bbox[0] = (col - 0.5f + 2.0f * logist(cell[0])) * netWidth / yolo.width;
+        bbox[1] = (row - 0.5f + 2.0f * logist(cell[totalGrid])) * netHeight / yolo.height;
+
+        // W: (Pw * e^tw) / FeaturemapW * netwidth
+        // v5: https://github.com/ultralytics/yolov5/issues/471
+        bbox[2] = 2.0f * logist(cell[2 * totalGrid]);
+        bbox[2] = bbox[2] * bbox[2] * yolo.anchors[2 * k];
+        bbox[3] = 2.0f * logist(cell[3 * totalGrid]);
+        bbox[3] = bbox[3] * bbox[3] * yolo.anchors[2 * k + 1];
+    }
+}
+
+#endif // _YOLO_DECODE_H_
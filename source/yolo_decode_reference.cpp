@@ -0,0 +1,36 @@
+#include "yolo_decode_reference.h"
+#include "yolo_decode.h"
+
+void yoloDecodeReference(const std::vector<const float*>& inputs,
+    const std::vector<Yolo::YoloKernel>& kernels, int netWidth, int netHeight,
+    int classes, int maxOut, float* output)
+{
+    const int infoLen = 5 + classes;
+    int count = 0;
+    Yolo::Detection* dets = reinterpret_cast<Yolo::Detection*>(output + 1);
+    for (size_t i = 0; i < kernels.size(); i++) {
+        const Yolo::YoloKernel& yolo = kernels[i];
+        const int totalGrid = yolo.width * yolo.height;
+        for (int idx = 0; idx < totalGrid; idx++) {
+            for (int k = 0; k < Yolo::CHECK_COUNT; k++) {
+                const float* cell = inputs[i] + k * infoLen * totalGrid + idx;
+                float conf;
+                int classId;
+                if (!Yolo::decodeScore(cell, totalGrid, classes, conf, classId)) {
+                    continue;
+                }
+                if (count >= maxOut) {
+                    // The plugin keeps counting past maxOut
+                    count++;
+                    continue;
+                }
+                Yolo::Detection& det = dets[count++];
+                Yolo::decodeBox(cell, totalGrid, yolo, k, idx / yolo.width, idx % yolo.width,
+                    netWidth, netHeight, det.bbox);
+                det.conf = conf;
+                det.class_id = classId;
+            }
+        }
+    }
+    output[0] = count;
+}
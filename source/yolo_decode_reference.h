@@ -0,0 +1,16 @@
+#ifndef _YOLO_DECODE_REFERENCE_H_
+#define _YOLO_DECODE_REFERENCE_H_
+
+#include <vector>
+#include "yololayer.h"
+
+// Host reference of the CalDetection decode of YoloLayerPlugin for one image,
+// with the per-cell steps of yolo_decode.h the kernel runs. inputs[i] is the
+// CHW output of the detect conv of kernels[i]; output gets the plugin's
+// "prob" layout, a detection count then up to maxOut Yolo::Detection, filled
+// in grid order.
+void yoloDecodeReference(const std::vector<const float*>& inputs,
+    const std::vector<Yolo::YoloKernel>& kernels, int netWidth, int netHeight,
+    int classes, int maxOut, float* output);
+
+#endif // _YOLO_DECODE_REFERENCE_H_
@@ -21,6 +21,7 @@
  */
 
 #include "yolo_trt.h"
+#include "precision_profile.h"
 #include <cassert>
 #include <iostream>
 #include <fstream>
@@ -30,10 +31,73 @@ Yolo::Yolo(const NetworkInfo& networkInfo)
       m_ConfigFilePath(networkInfo.configFilePath),
       m_WtsFilePath(networkInfo.wtsFilePath),
       m_DeviceType(networkInfo.deviceType),
-      m_InputBlobName(networkInfo.inputBlobName)
+      m_InputBlobName(networkInfo.inputBlobName),
+      m_PrecisionProfilePath(networkInfo.precisionProfilePath),
+      m_SparseWeights(networkInfo.sparseWeights)
 {
 }
 
+static nvinfer1::DataType toDataType(LayerPrecision precision)
+{
+    switch (precision) {
+    case LayerPrecision::kFP16:
+        return nvinfer1::DataType::kHALF;
+    case LayerPrecision::kINT8:
+        return nvinfer1::DataType::kINT8;
+    default:
+        return nvinfer1::DataType::kFLOAT;
+    }
+}
+
+// Pins the precision and output types of the layers matched by the profile.
+// quantScales tells whether the network carries explicit Q/DQ scales.
+static bool applyPrecisionProfile(nvinfer1::INetworkDefinition& network,
+    nvinfer1::IBuilderConfig* config, const std::string& profilePath, bool quantScales)
+{
+    PrecisionProfile profile;
+    if (!profile.load(profilePath)) {
+        return false;
+    }
+    // Without a calibrator or QAT scales TensorRT has no INT8 ranges and
+    // fails deep in the build, or silently falls back to higher precision
+    if (profile.uses(LayerPrecision::kINT8) && !config->getInt8Calibrator() && !quantScales) {
+        std::cerr << "Precision profile " << profilePath << " pins INT8 layers, but there is no "
+                  << "INT8 calibrator and the weights carry no quantization scales. Provide a "
+                  << "calibration table (int8-calib-file) or weights exported from a QAT model" << std::endl;
+        return false;
+    }
+
+    int pinned = 0;
+    for (int i = 0; i < network.getNbLayers(); i++) {
+        nvinfer1::ILayer* layer = network.getLayer(i);
+        nvinfer1::LayerType type = layer->getType();
+        // Constants and Q/DQ carry their own types, the yolo plugin is FP32 only
+        if (type == nvinfer1::LayerType::kCONSTANT || type == nvinfer1::LayerType::kQUANTIZE ||
+            type == nvinfer1::LayerType::kDEQUANTIZE || type == nvinfer1::LayerType::kPLUGIN_V2) {
+            continue;
+        }
+        const PrecisionRule* rule = profile.match(layer->getName());
+        if (!rule) {
+            continue;
+        }
+        layer->setPrecision(toDataType(rule->precision));
+        for (int j = 0; j < layer->getNbOutputs(); j++) {
+            layer->setOutputType(j, toDataType(rule->outputType));
+        }
+        pinned++;
+    }
+
+    if (profile.uses(LayerPrecision::kFP16)) {
+        config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    }
+    if (profile.uses(LayerPrecision::kINT8)) {
+        config->setFlag(nvinfer1::BuilderFlag::kINT8);
+    }
+    config->setFlag(nvinfer1::BuilderFlag::kOBEY_PRECISION_CONSTRAINTS);
+    std::cout << "Precision profile pinned " << pinned << " layers" << std::endl;
+    return true;
+}
+
 Yolo::~Yolo()
 {
     destroyNetworkUtils();
@@ -50,6 +114,25 @@ nvinfer1::ICudaEngine *Yolo::createEngine (
         return nullptr;
     }
 
+    const bool quantScales = hasQuantScales(*m_TrtWeights);
+    if (quantScales) {
+        // Explicit quantization, Q/DQ scales replace the calibration table
+        std::cout << "Using quantization scales from the weights file" << std::endl;
+        config->setFlag(nvinfer1::BuilderFlag::kINT8);
+        config->setInt8Calibrator(nullptr);
+    }
+
+    if (m_SparseWeights) {
+        std::cout << "Enabling sparse weights" << std::endl;
+        config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
+    }
+
+    if (!m_PrecisionProfilePath.empty() &&
+        !applyPrecisionProfile(*network, config, m_PrecisionProfilePath, quantScales)) {
+        network->destroy();
+        return nullptr;
+    }
+
     // Build the engine
     std::cout << "Building the TensorRT Engine..." << std::endl;
     nvinfer1::ICudaEngine * engine = builder->buildEngineWithConfig(*network, *config);
@@ -65,64 +148,61 @@ nvinfer1::ICudaEngine *Yolo::createEngine (
 
 NvDsInferStatus Yolo::parseModel(nvinfer1::INetworkDefinition& network) {
     destroyNetworkUtils();
-    m_TrtWeights = loadWeights(m_WtsFilePath);
+    // Derived weights go into this store, shared weights are only read
+    m_TrtWeights.reset(new WeightStore(m_SharedWeights));
+    if (!m_SharedWeights && !m_TrtWeights->load(m_WtsFilePath)) {
+        return NVDSINFER_CONFIG_FAILED;
+    }
 
     std::cout << "Building YoloV5 network..." << std::endl;
     float gd = 1.0, gw = 1.0;
-    if (m_NetworkType == "yolov5s") {
-        gd = 0.33;
-        gw = 0.50;
-        buildNetwork(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5m") {
-        gd = 0.67;
-        gw = 0.75;
-        buildNetwork(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5l") {
-        gd = 1.0;
-        gw = 1.0;
-        buildNetwork(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5x") {
-        gd = 1.33;
-        gw = 1.25;
-        buildNetwork(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5s_p6") {
-        gd = 0.33;
-        gw = 0.50;
-        buildNetwork_p6(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5m_p6") {
-        gd = 0.67;
-        gw = 0.75;
-        buildNetwork_p6(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5l_p6") {
-        gd = 1.0;
-        gw = 1.0;
-        buildNetwork_p6(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else if (m_NetworkType == "yolov5x_p6") {
-        gd = 1.33;
-        gw = 1.25;
-        buildNetwork_p6(&network, gd, gw, m_TrtWeights, m_InputBlobName, "prob");
-    }
-    else {
+    bool p6 = false;
+    if (!getYoloScaling(m_NetworkType, gd, gw, p6)) {
         std::cout << "Building YoloV5 network failed!" << std::endl;
         return NVDSINFER_CONFIG_FAILED;
     }
+    if (p6) {
+        buildNetwork_p6(&network, gd, gw, *m_TrtWeights, m_InputBlobName, "prob");
+    }
+    else {
+        buildNetwork(&network, gd, gw, *m_TrtWeights, m_InputBlobName, "prob");
+    }
     std::cout << "Building YoloV5 network complete!" << std::endl;
 
     return NVDSINFER_SUCCESS;
 }
 
-void Yolo::destroyNetworkUtils() {
-    // Deallocate the weights
-    for (auto& mem : m_TrtWeights)
-    {
-        free(const_cast<void *>(mem.second.values));
+bool getYoloScaling(const std::string& networkType, float& gd, float& gw, bool& p6)
+{
+    // Depth and width multiples of the yolov5 size variants
+    static const struct {
+        const char* name;
+        float gd;
+        float gw;
+    } variants[] = {
+        { "yolov5s", 0.33, 0.50 },
+        { "yolov5m", 0.67, 0.75 },
+        { "yolov5l", 1.0, 1.0 },
+        { "yolov5x", 1.33, 1.25 },
+    };
+
+    std::string name = networkType;
+    p6 = false;
+    if (name.size() > 3 && name.compare(name.size() - 3, 3, "_p6") == 0) {
+        name.erase(name.size() - 3);
+        p6 = true;
     }
-    m_TrtWeights.clear();
+    for (const auto& v : variants) {
+        if (name == v.name) {
+            gd = v.gd;
+            gw = v.gw;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Yolo::destroyNetworkUtils() {
+    // Deallocate the weights, all of them live in the store's arena
+    m_TrtWeights.reset();
 }
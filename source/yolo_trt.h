@@ -30,6 +30,7 @@
 #include <memory>
 
 #include "NvInfer.h"
+#include "weight_store.h"
 #include "nvdsinfer_custom_impl.h"
 using namespace nvinfer1;
 
@@ -43,6 +44,9 @@ struct NetworkInfo
     std::string wtsFilePath;
     std::string deviceType;
     std::string inputBlobName;
+    std::string precisionProfilePath;
+    // Enables 2:4 sparse tensor core kernels for weights pruned with yolov5_prune
+    bool sparseWeights = false;
 };
 
 class Yolo : public IModelParser {
@@ -59,24 +63,35 @@ public:
     nvinfer1::ICudaEngine *createEngine (
         nvinfer1::IBuilder* builder, nvinfer1::IBuilderConfig* config);
 
+    // Builds from weights loaded by the caller instead of the wts file.
+    // They are only read and must outlive the engine build.
+    void setSharedWeights(const WeightStore* weights) {
+        m_SharedWeights = weights;
+    }
+
 protected:
     const std::string m_NetworkType;
     const std::string m_ConfigFilePath;
     const std::string m_WtsFilePath;
     const std::string m_DeviceType;
     const std::string m_InputBlobName;
+    const std::string m_PrecisionProfilePath;
+    const bool m_SparseWeights;
 
     // TRT specific members
-    std::map<std::string, Weights> m_TrtWeights;
+    std::unique_ptr<WeightStore> m_TrtWeights;
+    const WeightStore* m_SharedWeights = nullptr;
 
 private:
     void destroyNetworkUtils();
 };
 
-void buildNetwork(INetworkDefinition* network, float gd, float gw, std::map<std::string, 
-    Weights>& weightMap, std::string inputBlobName, std::string outputBlobName);
-void buildNetwork_p6(INetworkDefinition* network, float gd, float gw, std::map<std::string, 
-    Weights>& weightMap, std::string inputBlobName, std::string outputBlobName);
-std::map<std::string, Weights> loadWeights(const std::string file);
+void buildNetwork(INetworkDefinition* network, float gd, float gw, WeightStore& weights,
+    std::string inputBlobName, std::string outputBlobName);
+void buildNetwork_p6(INetworkDefinition* network, float gd, float gw, WeightStore& weights,
+    std::string inputBlobName, std::string outputBlobName);
+bool hasQuantScales(const WeightStore& weights);
+// Looks up depth/width multiples of a yolov5{s,m,l,x}[_p6] network type
+bool getYoloScaling(const std::string& networkType, float& gd, float& gw, bool& p6);
 
 #endif // _YOLO_TRT_H_
@@ -34,6 +34,9 @@ namespace Yolo
     static constexpr int CLASS_NUM = 80;
     static constexpr int INPUT_H = 640;
     static constexpr int INPUT_W = 640;
+    // P6 models add a stride 64 output and are trained at 1280
+    static constexpr int INPUT_H_P6 = 1280;
+    static constexpr int INPUT_W_P6 = 1280;
 
     static constexpr int LOCATIONS = 4;
     struct alignas(float) Detection {
@@ -41,6 +44,13 @@ namespace Yolo
         float conf;
         float class_id;
     };
+
+    // Decodes one output scale into the detections following each image's
+    // count on stream, in yololayer.cu; YoloLayerPlugin::enqueue zeroes the
+    // counts and calls it once per scale
+    void launchDetection(const float* input, float* output, int numElem, int netWidth, int netHeight,
+        int maxOut, const YoloKernel& yolo, int classCount, int outputElem, int threadCount,
+        cudaStream_t stream);
 }
 
 namespace nvinfer1
@@ -51,7 +61,7 @@ namespace nvinfer1
         YoloLayerPlugin(int classCount, int netWidth, int netHeight, int maxOut, 
             const std::vector<Yolo::YoloKernel>& vYoloKernel);
         YoloLayerPlugin(const void* data, size_t length);
-        ~YoloLayerPlugin();
+        ~YoloLayerPlugin() override = default;
 
         const char* getPluginType () const noexcept override { return "YoloLayer_TRT"; }
         const char* getPluginVersion () const noexcept override { return "1"; }
@@ -89,13 +99,13 @@ namespace nvinfer1
 
     private:
         std::string mNamespace;
+        // Block size cap, only read in enqueue; kept in the serialized format
         int mThreadCount = 256;
         int mKernelCount;
         int mClassCount;
         int mYoloV5NetWidth;
         int mYoloV5NetHeight;
         int mMaxOutObject;
-        void **mAnchor;
         std::vector<Yolo::YoloKernel> mYoloKernel;
     };
 
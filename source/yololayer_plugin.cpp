@@ -0,0 +1,172 @@
+#include <assert.h>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include "cuda_runtime_api.h"
+#include "yololayer.h"
+
+using namespace Yolo;
+
+namespace
+{
+    template<typename T> 
+    void write(char*& buffer, const T& val)
+    {
+        *reinterpret_cast<T*>(buffer) = val;
+        buffer += sizeof(T);
+    }
+
+    template<typename T> 
+    void read(const char*& buffer, T& val)
+    {
+        val = *reinterpret_cast<const T*>(buffer);
+        buffer += sizeof(T);
+    }
+}
+
+namespace nvinfer1
+{
+    YoloLayerPlugin::YoloLayerPlugin(int classCount, int netWidth, int netHeight, int maxOut, 
+        const std::vector<Yolo::YoloKernel>& vYoloKernel)
+    {
+        mClassCount = classCount;
+        mYoloV5NetWidth = netWidth;
+        mYoloV5NetHeight = netHeight;
+        mMaxOutObject = maxOut;
+        mYoloKernel = vYoloKernel;
+        mKernelCount = vYoloKernel.size();
+    }
+
+    // create the plugin at runtime from a byte stream
+    YoloLayerPlugin::YoloLayerPlugin(const void* data, size_t length)
+    {
+        const char *d = reinterpret_cast<const char *>(data), *a = d;
+        read(d, mClassCount);
+        read(d, mThreadCount);
+        read(d, mKernelCount);
+        read(d, mYoloV5NetWidth);
+        read(d, mYoloV5NetHeight);
+        read(d, mMaxOutObject);
+        mYoloKernel.resize(mKernelCount);
+        auto kernelSize = mKernelCount * sizeof(YoloKernel);
+        memcpy(mYoloKernel.data(), d, kernelSize);
+        d += kernelSize;
+        assert(d == a + length);
+    }
+
+    void YoloLayerPlugin::serialize(void* buffer) const noexcept
+    {
+        char* d = static_cast<char*>(buffer), *a = d;
+        write(d, mClassCount);
+        write(d, mThreadCount);
+        write(d, mKernelCount);
+        write(d, mYoloV5NetWidth);
+        write(d, mYoloV5NetHeight);
+        write(d, mMaxOutObject);
+        auto kernelSize = mKernelCount * sizeof(YoloKernel);
+        memcpy(d, mYoloKernel.data(), kernelSize);
+        d += kernelSize;
+
+        assert(d == a + getSerializationSize());
+    }
+
+    size_t YoloLayerPlugin::getSerializationSize() const noexcept
+    {
+        return sizeof(mClassCount) + sizeof(mThreadCount) + sizeof(mKernelCount) + 
+            sizeof(Yolo::YoloKernel) * mYoloKernel.size() + sizeof(mYoloV5NetWidth) + 
+            sizeof(mYoloV5NetHeight) + sizeof(mMaxOutObject);
+    }
+
+    Dims YoloLayerPlugin::getOutputDimensions(int index, const Dims* inputs, int nbInputDims) noexcept
+    {
+        //output the result to channel
+        int totalsize = mMaxOutObject * sizeof(Detection) / sizeof(float);
+
+        return Dims3(totalsize + 1, 1, 1);
+    }
+
+    bool YoloLayerPlugin::supportsFormat (
+        DataType type, PluginFormat format) const noexcept {
+        return (type == DataType::kFLOAT && format == PluginFormat::kLINEAR);
+    }
+
+    void YoloLayerPlugin::configureWithFormat (
+        const Dims* inputDims, int nbInputs,
+        const Dims* outputDims, int nbOutputs,
+        DataType type, PluginFormat format, int maxBatchSize) noexcept
+    {
+        assert(nbInputs == 3 || nbInputs == 4);
+        assert (format == PluginFormat::kLINEAR);
+        assert(inputDims != nullptr);
+    }
+
+    // Clone the plugin, a plain copy since it owns no device memory
+    IPluginV2* YoloLayerPlugin::clone() const noexcept
+    {
+        YoloLayerPlugin* p = new YoloLayerPlugin(*this);
+        p->setPluginNamespace(mNamespace.c_str());
+        return p;
+    }
+
+    // Re-entrant: reads the plugin state only and orders all work on stream,
+    // so several execution contexts of one engine can run concurrently
+    int32_t YoloLayerPlugin::enqueue(int32_t batchSize, void const* const* inputs, 
+        void* const* outputs, void* workspace, cudaStream_t stream) noexcept
+    {
+        const float* const* input_data = (const float* const*)inputs;
+        float *output = (float*)outputs[0];
+        int outputElem = 1 + mMaxOutObject * sizeof(Detection) / sizeof(float);
+        // Zero the detection count heading each image's output
+        if (cudaMemset2DAsync(output, outputElem * sizeof(float), 0, sizeof(float),
+                batchSize, stream) != cudaSuccess) {
+            return -1;
+        }
+        for (unsigned int i = 0; i < mYoloKernel.size(); ++i) {
+            const auto& yolo = mYoloKernel[i];
+            int numElem = yolo.width * yolo.height * batchSize;
+            int threadCount = std::min(mThreadCount, numElem);
+            launchDetection(input_data[i], output, numElem, mYoloV5NetWidth, mYoloV5NetHeight,
+                mMaxOutObject, yolo, mClassCount, outputElem, threadCount, stream);
+        }
+        return cudaGetLastError() == cudaSuccess ? 0 : -1;
+    }
+
+    PluginFieldCollection YoloPluginCreator::mFC{};
+    std::vector<PluginField> YoloPluginCreator::mPluginAttributes;
+
+    YoloPluginCreator::YoloPluginCreator()
+    {
+        mPluginAttributes.clear();
+
+        mFC.nbFields = mPluginAttributes.size();
+        mFC.fields = mPluginAttributes.data();
+    }
+
+    IPluginV2* YoloPluginCreator::createPlugin(const char* name, const PluginFieldCollection* fc) noexcept
+    {
+        assert(fc->nbFields == 2);
+        assert(strcmp(fc->fields[0].name, "netinfo") == 0);
+        assert(strcmp(fc->fields[1].name, "kernels") == 0);
+        int *p_netinfo = (int*)(fc->fields[0].data);
+        int class_count = p_netinfo[0];
+        int input_w = p_netinfo[1];
+        int input_h = p_netinfo[2];
+        int max_output_object_count = p_netinfo[3];
+        std::vector<Yolo::YoloKernel> kernels(fc->fields[1].length);
+        memcpy(&kernels[0], fc->fields[1].data, kernels.size() * sizeof(Yolo::YoloKernel));
+        YoloLayerPlugin* obj = new YoloLayerPlugin(class_count, input_w, input_h, max_output_object_count, kernels);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+
+    IPluginV2* YoloPluginCreator::deserializePlugin(const char* name, 
+        const void* serialData, size_t serialLength) noexcept
+    {
+        // This object will be deleted when the network is destroyed, which will
+        // call YoloLayerPlugin::destroy()
+        YoloLayerPlugin* obj = new YoloLayerPlugin(serialData, serialLength);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+}
+
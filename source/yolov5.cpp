@@ -17,131 +17,153 @@ static int get_depth(int x, float gd) {
     }
 }
 
-void buildNetwork(INetworkDefinition* network, float gd, float gw, std::map<std::string, Weights>& weightMap, std::string inputBlobName, std::string outputBlobName) {
+void buildNetwork(INetworkDefinition* network, float gd, float gw, WeightStore& weights, std::string inputBlobName, std::string outputBlobName) {
     // Create input tensor of shape {3, INPUT_H, INPUT_W} with name INPUT_BLOB_NAME
     ITensor* data = network->addInput(inputBlobName.c_str(), DataType::kFLOAT, Dims3{3, Yolo::INPUT_H, Yolo::INPUT_W});
 
     /* ------ yolov5 backbone------ */
-    auto conv0 = convBlock(network, weightMap, *data, get_width(64, gw), 6, 2, 1, "model.0", 2);
-    auto conv1 = convBlock(network, weightMap, *conv0->getOutput(0), get_width(128, gw), 3, 2, 1, "model.1");
-    auto bottleneck_CSP2 = C3(network, weightMap, *conv1->getOutput(0), get_width(128, gw), get_width(128, gw), get_depth(3, gd), true, 1, 0.5, "model.2");
-    auto conv3 = convBlock(network, weightMap, *bottleneck_CSP2->getOutput(0), get_width(256, gw), 3, 2, 1, "model.3");
-    auto bottleneck_csp4 = C3(network, weightMap, *conv3->getOutput(0), get_width(256, gw), get_width(256, gw), get_depth(6, gd), true, 1, 0.5, "model.4");
-    auto conv5 = convBlock(network, weightMap, *bottleneck_csp4->getOutput(0), get_width(512, gw), 3, 2, 1, "model.5");
-    auto bottleneck_csp6 = C3(network, weightMap, *conv5->getOutput(0), get_width(512, gw), get_width(512, gw), get_depth(9, gd), true, 1, 0.5, "model.6");
-    auto conv7 = convBlock(network, weightMap, *bottleneck_csp6->getOutput(0), get_width(1024, gw), 3, 2, 1, "model.7");
-    auto bottleneck_csp8 = C3(network, weightMap, *conv7->getOutput(0), get_width(1024, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.8");
-    auto spp9 = SPPF(network, weightMap, *bottleneck_csp8->getOutput(0), get_width(1024, gw), get_width(1024, gw), 5, "model.9");
+    auto conv0 = convBlock(network, weights, *data, get_width(64, gw), 6, 2, 1, "model.0", 2);
+    auto conv1 = convBlock(network, weights, *conv0->getOutput(0), get_width(128, gw), 3, 2, 1, "model.1");
+    auto bottleneck_CSP2 = C3(network, weights, *conv1->getOutput(0), get_width(128, gw), get_width(128, gw), get_depth(3, gd), true, 1, 0.5, "model.2");
+    auto conv3 = convBlock(network, weights, *bottleneck_CSP2->getOutput(0), get_width(256, gw), 3, 2, 1, "model.3");
+    auto bottleneck_csp4 = C3(network, weights, *conv3->getOutput(0), get_width(256, gw), get_width(256, gw), get_depth(6, gd), true, 1, 0.5, "model.4");
+    auto conv5 = convBlock(network, weights, *bottleneck_csp4->getOutput(0), get_width(512, gw), 3, 2, 1, "model.5");
+    auto bottleneck_csp6 = C3(network, weights, *conv5->getOutput(0), get_width(512, gw), get_width(512, gw), get_depth(9, gd), true, 1, 0.5, "model.6");
+    auto conv7 = convBlock(network, weights, *bottleneck_csp6->getOutput(0), get_width(1024, gw), 3, 2, 1, "model.7");
+    auto bottleneck_csp8 = C3(network, weights, *conv7->getOutput(0), get_width(1024, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.8");
+    auto spp9 = SPPF(network, weights, *bottleneck_csp8->getOutput(0), get_width(1024, gw), get_width(1024, gw), 5, "model.9");
 
     /* ------ yolov5 head ------ */
-    auto conv10 = convBlock(network, weightMap, *spp9->getOutput(0), get_width(512, gw), 1, 1, 1, "model.10");
+    auto conv10 = convBlock(network, weights, *spp9->getOutput(0), get_width(512, gw), 1, 1, 1, "model.10");
 
     auto upsample11 = network->addResize(*conv10->getOutput(0));
     assert(upsample11);
+    upsample11->setName("model.11");
     upsample11->setResizeMode(ResizeMode::kNEAREST);
     upsample11->setOutputDimensions(bottleneck_csp6->getOutput(0)->getDimensions());
 
     ITensor* inputTensors12[] = { upsample11->getOutput(0), bottleneck_csp6->getOutput(0) };
     auto cat12 = network->addConcatenation(inputTensors12, 2);
-    auto bottleneck_csp13 = C3(network, weightMap, *cat12->getOutput(0), get_width(1024, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.13");
-    auto conv14 = convBlock(network, weightMap, *bottleneck_csp13->getOutput(0), get_width(256, gw), 1, 1, 1, "model.14");
+    cat12->setName("model.12");
+    auto bottleneck_csp13 = C3(network, weights, *cat12->getOutput(0), get_width(1024, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.13");
+    auto conv14 = convBlock(network, weights, *bottleneck_csp13->getOutput(0), get_width(256, gw), 1, 1, 1, "model.14");
 
     auto upsample15 = network->addResize(*conv14->getOutput(0));
     assert(upsample15);
+    upsample15->setName("model.15");
     upsample15->setResizeMode(ResizeMode::kNEAREST);
     upsample15->setOutputDimensions(bottleneck_csp4->getOutput(0)->getDimensions());
 
     ITensor* inputTensors16[] = { upsample15->getOutput(0), bottleneck_csp4->getOutput(0) };
     auto cat16 = network->addConcatenation(inputTensors16, 2);
+    cat16->setName("model.16");
 
-    auto bottleneck_csp17 = C3(network, weightMap, *cat16->getOutput(0), get_width(512, gw), get_width(256, gw), get_depth(3, gd), false, 1, 0.5, "model.17");
+    auto bottleneck_csp17 = C3(network, weights, *cat16->getOutput(0), get_width(512, gw), get_width(256, gw), get_depth(3, gd), false, 1, 0.5, "model.17");
 
     /* ------ detect ------ */
-    IConvolutionLayer* det0 = network->addConvolutionNd(*bottleneck_csp17->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.24.m.0.weight"], weightMap["model.24.m.0.bias"]);
-    auto conv18 = convBlock(network, weightMap, *bottleneck_csp17->getOutput(0), get_width(256, gw), 3, 2, 1, "model.18");
+    IConvolutionLayer* det0 = network->addConvolutionNd(*bottleneck_csp17->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.24.m.0.weight"), weights.get("model.24.m.0.bias"));
+    det0->setName("model.24.m.0");
+    auto conv18 = convBlock(network, weights, *bottleneck_csp17->getOutput(0), get_width(256, gw), 3, 2, 1, "model.18");
     ITensor* inputTensors19[] = { conv18->getOutput(0), conv14->getOutput(0) };
     auto cat19 = network->addConcatenation(inputTensors19, 2);
-    auto bottleneck_csp20 = C3(network, weightMap, *cat19->getOutput(0), get_width(512, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.20");
-    IConvolutionLayer* det1 = network->addConvolutionNd(*bottleneck_csp20->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.24.m.1.weight"], weightMap["model.24.m.1.bias"]);
-    auto conv21 = convBlock(network, weightMap, *bottleneck_csp20->getOutput(0), get_width(512, gw), 3, 2, 1, "model.21");
+    cat19->setName("model.19");
+    auto bottleneck_csp20 = C3(network, weights, *cat19->getOutput(0), get_width(512, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.20");
+    IConvolutionLayer* det1 = network->addConvolutionNd(*bottleneck_csp20->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.24.m.1.weight"), weights.get("model.24.m.1.bias"));
+    det1->setName("model.24.m.1");
+    auto conv21 = convBlock(network, weights, *bottleneck_csp20->getOutput(0), get_width(512, gw), 3, 2, 1, "model.21");
     ITensor* inputTensors22[] = { conv21->getOutput(0), conv10->getOutput(0) };
     auto cat22 = network->addConcatenation(inputTensors22, 2);
-    auto bottleneck_csp23 = C3(network, weightMap, *cat22->getOutput(0), get_width(1024, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.23");
-    IConvolutionLayer* det2 = network->addConvolutionNd(*bottleneck_csp23->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.24.m.2.weight"], weightMap["model.24.m.2.bias"]);
+    cat22->setName("model.22");
+    auto bottleneck_csp23 = C3(network, weights, *cat22->getOutput(0), get_width(1024, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.23");
+    IConvolutionLayer* det2 = network->addConvolutionNd(*bottleneck_csp23->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.24.m.2.weight"), weights.get("model.24.m.2.bias"));
+    det2->setName("model.24.m.2");
 
-    auto yolo = addYoLoLayer(network, weightMap, "model.24", std::vector<IConvolutionLayer*>{det0, det1, det2});
+    auto yolo = addYoLoLayer(network, weights, "model.24", std::vector<IConvolutionLayer*>{det0, det1, det2});
     yolo->getOutput(0)->setName(outputBlobName.c_str());
     network->markOutput(*yolo->getOutput(0));
 }
 
-void buildNetwork_p6(INetworkDefinition* network, float gd, float gw, std::map<std::string, Weights>& weightMap, std::string inputBlobName, std::string outputBlobName) {
-    // Create input tensor of shape {3, INPUT_H, INPUT_W} with name INPUT_BLOB_NAME
-    ITensor* data = network->addInput(inputBlobName.c_str(), DataType::kFLOAT, Dims3{3, Yolo::INPUT_H, Yolo::INPUT_W});
+void buildNetwork_p6(INetworkDefinition* network, float gd, float gw, WeightStore& weights, std::string inputBlobName, std::string outputBlobName) {
+    // Create input tensor of shape {3, INPUT_H_P6, INPUT_W_P6} with name INPUT_BLOB_NAME
+    ITensor* data = network->addInput(inputBlobName.c_str(), DataType::kFLOAT, Dims3{3, Yolo::INPUT_H_P6, Yolo::INPUT_W_P6});
 
     /* ------ yolov5 backbone------ */
-    auto conv0 = convBlock(network, weightMap, *data, get_width(64, gw), 6, 2, 1, "model.0", 2);
-    auto conv1 = convBlock(network, weightMap, *conv0->getOutput(0), get_width(128, gw), 3, 2, 1, "model.1");
-    auto c3_2 = C3(network, weightMap, *conv1->getOutput(0), get_width(128, gw), get_width(128, gw), get_depth(3, gd), true, 1, 0.5, "model.2");
-    auto conv3 = convBlock(network, weightMap, *c3_2->getOutput(0), get_width(256, gw), 3, 2, 1, "model.3");
-    auto c3_4 = C3(network, weightMap, *conv3->getOutput(0), get_width(256, gw), get_width(256, gw), get_depth(6, gd), true, 1, 0.5, "model.4");
-    auto conv5 = convBlock(network, weightMap, *c3_4->getOutput(0), get_width(512, gw), 3, 2, 1, "model.5");
-    auto c3_6 = C3(network, weightMap, *conv5->getOutput(0), get_width(512, gw), get_width(512, gw), get_depth(9, gd), true, 1, 0.5, "model.6");
-    auto conv7 = convBlock(network, weightMap, *c3_6->getOutput(0), get_width(768, gw), 3, 2, 1, "model.7");
-    auto c3_8 = C3(network, weightMap, *conv7->getOutput(0), get_width(768, gw), get_width(768, gw), get_depth(3, gd), true, 1, 0.5, "model.8");
-    auto conv9 = convBlock(network, weightMap, *c3_8->getOutput(0), get_width(1024, gw), 3, 2, 1, "model.9");
-    auto c3_10 = C3(network, weightMap, *conv9->getOutput(0), get_width(1024, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.10");
-    auto spp11 = SPPF(network, weightMap, *c3_10->getOutput(0), get_width(1024, gw), get_width(1024, gw), 5, "model.11");
+    auto conv0 = convBlock(network, weights, *data, get_width(64, gw), 6, 2, 1, "model.0", 2);
+    auto conv1 = convBlock(network, weights, *conv0->getOutput(0), get_width(128, gw), 3, 2, 1, "model.1");
+    auto c3_2 = C3(network, weights, *conv1->getOutput(0), get_width(128, gw), get_width(128, gw), get_depth(3, gd), true, 1, 0.5, "model.2");
+    auto conv3 = convBlock(network, weights, *c3_2->getOutput(0), get_width(256, gw), 3, 2, 1, "model.3");
+    auto c3_4 = C3(network, weights, *conv3->getOutput(0), get_width(256, gw), get_width(256, gw), get_depth(6, gd), true, 1, 0.5, "model.4");
+    auto conv5 = convBlock(network, weights, *c3_4->getOutput(0), get_width(512, gw), 3, 2, 1, "model.5");
+    auto c3_6 = C3(network, weights, *conv5->getOutput(0), get_width(512, gw), get_width(512, gw), get_depth(9, gd), true, 1, 0.5, "model.6");
+    auto conv7 = convBlock(network, weights, *c3_6->getOutput(0), get_width(768, gw), 3, 2, 1, "model.7");
+    auto c3_8 = C3(network, weights, *conv7->getOutput(0), get_width(768, gw), get_width(768, gw), get_depth(3, gd), true, 1, 0.5, "model.8");
+    auto conv9 = convBlock(network, weights, *c3_8->getOutput(0), get_width(1024, gw), 3, 2, 1, "model.9");
+    auto c3_10 = C3(network, weights, *conv9->getOutput(0), get_width(1024, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.10");
+    auto spp11 = SPPF(network, weights, *c3_10->getOutput(0), get_width(1024, gw), get_width(1024, gw), 5, "model.11");
 
     /* ------ yolov5 head ------ */
-    auto conv12 = convBlock(network, weightMap, *spp11->getOutput(0), get_width(768, gw), 1, 1, 1, "model.12");
+    auto conv12 = convBlock(network, weights, *spp11->getOutput(0), get_width(768, gw), 1, 1, 1, "model.12");
     auto upsample13 = network->addResize(*conv12->getOutput(0));
     assert(upsample13);
+    upsample13->setName("model.13");
     upsample13->setResizeMode(ResizeMode::kNEAREST);
     upsample13->setOutputDimensions(c3_8->getOutput(0)->getDimensions());
     ITensor* inputTensors14[] = { upsample13->getOutput(0), c3_8->getOutput(0) };
     auto cat14 = network->addConcatenation(inputTensors14, 2);
-    auto c3_15 = C3(network, weightMap, *cat14->getOutput(0), get_width(1536, gw), get_width(768, gw), get_depth(3, gd), false, 1, 0.5, "model.15");
+    cat14->setName("model.14");
+    auto c3_15 = C3(network, weights, *cat14->getOutput(0), get_width(1536, gw), get_width(768, gw), get_depth(3, gd), false, 1, 0.5, "model.15");
 
-    auto conv16 = convBlock(network, weightMap, *c3_15->getOutput(0), get_width(512, gw), 1, 1, 1, "model.16");
+    auto conv16 = convBlock(network, weights, *c3_15->getOutput(0), get_width(512, gw), 1, 1, 1, "model.16");
     auto upsample17 = network->addResize(*conv16->getOutput(0));
     assert(upsample17);
+    upsample17->setName("model.17");
     upsample17->setResizeMode(ResizeMode::kNEAREST);
     upsample17->setOutputDimensions(c3_6->getOutput(0)->getDimensions());
     ITensor* inputTensors18[] = { upsample17->getOutput(0), c3_6->getOutput(0) };
     auto cat18 = network->addConcatenation(inputTensors18, 2);
-    auto c3_19 = C3(network, weightMap, *cat18->getOutput(0), get_width(1024, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.19");
+    cat18->setName("model.18");
+    auto c3_19 = C3(network, weights, *cat18->getOutput(0), get_width(1024, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.19");
 
-    auto conv20 = convBlock(network, weightMap, *c3_19->getOutput(0), get_width(256, gw), 1, 1, 1, "model.20");
+    auto conv20 = convBlock(network, weights, *c3_19->getOutput(0), get_width(256, gw), 1, 1, 1, "model.20");
     auto upsample21 = network->addResize(*conv20->getOutput(0));
     assert(upsample21);
+    upsample21->setName("model.21");
     upsample21->setResizeMode(ResizeMode::kNEAREST);
     upsample21->setOutputDimensions(c3_4->getOutput(0)->getDimensions());
     ITensor* inputTensors21[] = { upsample21->getOutput(0), c3_4->getOutput(0) };
     auto cat22 = network->addConcatenation(inputTensors21, 2);
-    auto c3_23 = C3(network, weightMap, *cat22->getOutput(0), get_width(512, gw), get_width(256, gw), get_depth(3, gd), false, 1, 0.5, "model.23");
+    cat22->setName("model.22");
+    auto c3_23 = C3(network, weights, *cat22->getOutput(0), get_width(512, gw), get_width(256, gw), get_depth(3, gd), false, 1, 0.5, "model.23");
 
-    auto conv24 = convBlock(network, weightMap, *c3_23->getOutput(0), get_width(256, gw), 3, 2, 1, "model.24");
+    auto conv24 = convBlock(network, weights, *c3_23->getOutput(0), get_width(256, gw), 3, 2, 1, "model.24");
     ITensor* inputTensors25[] = { conv24->getOutput(0), conv20->getOutput(0) };
     auto cat25 = network->addConcatenation(inputTensors25, 2);
-    auto c3_26 = C3(network, weightMap, *cat25->getOutput(0), get_width(1024, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.26");
+    cat25->setName("model.25");
+    auto c3_26 = C3(network, weights, *cat25->getOutput(0), get_width(1024, gw), get_width(512, gw), get_depth(3, gd), false, 1, 0.5, "model.26");
 
-    auto conv27 = convBlock(network, weightMap, *c3_26->getOutput(0), get_width(512, gw), 3, 2, 1, "model.27");
+    auto conv27 = convBlock(network, weights, *c3_26->getOutput(0), get_width(512, gw), 3, 2, 1, "model.27");
     ITensor* inputTensors28[] = { conv27->getOutput(0), conv16->getOutput(0) };
     auto cat28 = network->addConcatenation(inputTensors28, 2);
-    auto c3_29 = C3(network, weightMap, *cat28->getOutput(0), get_width(1536, gw), get_width(768, gw), get_depth(3, gd), false, 1, 0.5, "model.29");
+    cat28->setName("model.28");
+    auto c3_29 = C3(network, weights, *cat28->getOutput(0), get_width(1536, gw), get_width(768, gw), get_depth(3, gd), false, 1, 0.5, "model.29");
 
-    auto conv30 = convBlock(network, weightMap, *c3_29->getOutput(0), get_width(768, gw), 3, 2, 1, "model.30");
+    auto conv30 = convBlock(network, weights, *c3_29->getOutput(0), get_width(768, gw), 3, 2, 1, "model.30");
     ITensor* inputTensors31[] = { conv30->getOutput(0), conv12->getOutput(0) };
     auto cat31 = network->addConcatenation(inputTensors31, 2);
-    auto c3_32 = C3(network, weightMap, *cat31->getOutput(0), get_width(2048, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.32");
+    cat31->setName("model.31");
+    auto c3_32 = C3(network, weights, *cat31->getOutput(0), get_width(2048, gw), get_width(1024, gw), get_depth(3, gd), false, 1, 0.5, "model.32");
 
     /* ------ detect ------ */
-    IConvolutionLayer* det0 = network->addConvolutionNd(*c3_23->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.33.m.0.weight"], weightMap["model.33.m.0.bias"]);
-    IConvolutionLayer* det1 = network->addConvolutionNd(*c3_26->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.33.m.1.weight"], weightMap["model.33.m.1.bias"]);
-    IConvolutionLayer* det2 = network->addConvolutionNd(*c3_29->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.33.m.2.weight"], weightMap["model.33.m.2.bias"]);
-    IConvolutionLayer* det3 = network->addConvolutionNd(*c3_32->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weightMap["model.33.m.3.weight"], weightMap["model.33.m.3.bias"]);
-
-    auto yolo = addYoLoLayer(network, weightMap, "model.33", std::vector<IConvolutionLayer*>{det0, det1, det2, det3});
+    IConvolutionLayer* det0 = network->addConvolutionNd(*c3_23->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.33.m.0.weight"), weights.get("model.33.m.0.bias"));
+    det0->setName("model.33.m.0");
+    IConvolutionLayer* det1 = network->addConvolutionNd(*c3_26->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.33.m.1.weight"), weights.get("model.33.m.1.bias"));
+    det1->setName("model.33.m.1");
+    IConvolutionLayer* det2 = network->addConvolutionNd(*c3_29->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.33.m.2.weight"), weights.get("model.33.m.2.bias"));
+    det2->setName("model.33.m.2");
+    IConvolutionLayer* det3 = network->addConvolutionNd(*c3_32->getOutput(0), 3 * (Yolo::CLASS_NUM + 5), DimsHW{ 1, 1 }, weights.get("model.33.m.3.weight"), weights.get("model.33.m.3.bias"));
+    det3->setName("model.33.m.3");
+
+    auto yolo = addYoLoLayer(network, weights, "model.33", std::vector<IConvolutionLayer*>{det0, det1, det2, det3});
     yolo->getOutput(0)->setName(outputBlobName.c_str());
     network->markOutput(*yolo->getOutput(0));
 }
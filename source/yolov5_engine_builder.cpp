@@ -0,0 +1,120 @@
+/*
+ * Offline engine-matrix builder: builds the TensorRT engines of a build
+ * matrix file concurrently, reusing Yolo::createEngine, and writes a JSON
+ * manifest with build times and engine sizes.
+ *
+ *   yolov5_engine_builder <matrix file> [manifest path]
+ *
+ * Weights are parsed once per model and shared by all jobs of that model.
+ */
+
+#include <map>
+#include <memory>
+
+#include "cuda_runtime_api.h"
+#include "build_matrix.h"
+#include "custom_config.h"
+#include "trt_utils.h"
+#include "yolo_trt.h"
+
+class BuildLogger : public nvinfer1::ILogger {
+    void log(Severity severity, const char* msg) noexcept override {
+        if (severity <= Severity::kWARNING) {
+            std::cerr << msg << std::endl;
+        }
+    }
+};
+
+static BuildLogger gLogger;
+
+static BuildResult buildEngine(const BuildJob& job,
+    const WeightStore& weights, size_t workspaceSize,
+    const std::string& precisionProfilePath)
+{
+    BuildResult result;
+    cudaSetDevice(job.gpuId);
+
+    NetworkInfo networkInfo;
+    networkInfo.networkType = job.model;
+    networkInfo.wtsFilePath = job.weightsPath;
+    networkInfo.deviceType = "kGPU";
+    networkInfo.inputBlobName = "data";
+    networkInfo.precisionProfilePath = precisionProfilePath;
+    networkInfo.sparseWeights = job.sparseWeights;
+    Yolo yolo(networkInfo);
+    yolo.setSharedWeights(&weights);
+
+    nvinfer1::IBuilder* builder = nvinfer1::createInferBuilder(gLogger);
+    nvinfer1::IBuilderConfig* config = builder->createBuilderConfig();
+    builder->setMaxBatchSize(job.batchSize);
+    config->setMaxWorkspaceSize(workspaceSize);
+    if (job.precision == "fp16") {
+        config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    }
+    else if (job.precision == "int8") {
+        config->setFlag(nvinfer1::BuilderFlag::kINT8);
+        config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    }
+
+    nvinfer1::ICudaEngine* engine = yolo.createEngine(builder, config);
+    if (engine) {
+        nvinfer1::IHostMemory* serialized = engine->serialize();
+        std::ofstream output(job.enginePath, std::ios::binary);
+        output.write(static_cast<const char*>(serialized->data()), serialized->size());
+        result.success = output.good();
+        result.engineBytes = serialized->size();
+        if (!result.success) {
+            result.error = "unable to write engine file";
+        }
+        serialized->destroy();
+        engine->destroy();
+    }
+    else {
+        result.error = "engine build failed";
+    }
+
+    config->destroy();
+    builder->destroy();
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix file> [manifest path]" << std::endl;
+        return 1;
+    }
+
+    CustomConfig matrix;
+    std::vector<BuildJob> jobs;
+    if (!matrix.load(argv[1]) || !planBuildMatrix(matrix, jobs)) {
+        return 1;
+    }
+    int workers = matrix.getInt("matrix", "workers", 2);
+    size_t workspaceSize = (size_t)matrix.getInt("matrix", "workspace-mb", 1024) << 20;
+    std::string manifestPath = argc > 2 ? argv[2] : "engines_manifest.json";
+    std::string precisionProfilePath = matrix.getString("matrix", "precision-profile");
+
+    // Parse every weights file once, up front, so concurrent jobs only read
+    std::map<std::string, std::unique_ptr<WeightStore>> weights;
+    for (const BuildJob& job : jobs) {
+        if (weights.count(job.weightsPath)) {
+            continue;
+        }
+        std::unique_ptr<WeightStore> store(new WeightStore());
+        if (!fileExists(job.weightsPath) || !store->load(job.weightsPath)) {
+            return 1;
+        }
+        weights[job.weightsPath] = std::move(store);
+    }
+
+    std::cout << "Building " << jobs.size() << " engines on " << workers << " workers" << std::endl;
+    std::vector<BuildResult> results = runBuildMatrix(jobs, workers,
+        [&](const BuildJob& job) { return buildEngine(job, *weights.at(job.weightsPath), workspaceSize, precisionProfilePath); });
+
+    bool ok = writeManifest(manifestPath, results);
+    for (const BuildResult& r : results) {
+        ok = ok && r.success;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Offline 2:4 structured-sparsity pruning of a yolov5 weights file, for
+ * engines built with sparse weights ([build] sparse-weights=1).
+ *
+ *   yolov5_prune <input wts> <output wts> [skip patterns]
+ *
+ * Skip patterns are a comma separated list of layer names, e.g.
+ * "model.0,model.24.*", whose convs are left dense. Runs on the CPU only.
+ */
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "custom_config.h"
+#include "weight_pruning.h"
+
+// Reads the written file back and checks the pruned convs and every other blob
+static bool verifyPrunedFile(const std::string& path, const std::vector<WeightBlob>& expected,
+    const std::vector<PruneReport>& reports)
+{
+    std::vector<WeightBlob> blobs;
+    if (!readWtsFile(path, blobs) || blobs.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < blobs.size(); i++) {
+        if (blobs[i].name != expected[i].name || blobs[i].values != expected[i].values) {
+            std::cerr << "Mismatch in " << blobs[i].name << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<float> weights;
+    for (const PruneReport& report : reports) {
+        if (!report.pruned) {
+            continue;
+        }
+        for (const WeightBlob& blob : blobs) {
+            if (blob.name != report.name) {
+                continue;
+            }
+            weights.resize(blob.values.size());
+            memcpy(weights.data(), blob.values.data(), weights.size() * sizeof(float));
+            if (!isSparse24(weights.data(), report.shape)) {
+                std::cerr << report.name << " is not 2:4 sparse" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input wts> <output wts> [skip patterns]" << std::endl;
+        return 1;
+    }
+
+    std::vector<WeightBlob> blobs;
+    if (!readWtsFile(argv[1], blobs)) {
+        return 1;
+    }
+    std::vector<std::string> skipPatterns;
+    if (argc > 3) {
+        skipPatterns = splitString(argv[3], ',');
+    }
+
+    std::vector<PruneReport> reports = pruneWeights24(blobs, skipPatterns);
+
+    size_t total = 0, zeros = 0;
+    int pruned = 0;
+    std::cout << std::left << std::setw(32) << "layer" << std::setw(18) << "shape (KxCxRxS)"
+              << std::setw(10) << "before" << std::setw(10) << "after" << "note" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (const PruneReport& report : reports) {
+        const ConvShape& s = report.shape;
+        size_t count = (size_t)s.outChannels * s.inChannels * s.kernelSize * s.kernelSize;
+        std::string shape = std::to_string(s.outChannels) + "x" + std::to_string(s.inChannels) + "x" +
+            std::to_string(s.kernelSize) + "x" + std::to_string(s.kernelSize);
+        std::cout << std::setw(32) << report.name << std::setw(18) << shape
+                  << std::setw(10) << report.sparsityBefore << std::setw(10) << report.sparsityAfter
+                  << (report.pruned ? "" : "dense, " + report.reason) << std::endl;
+        total += count;
+        zeros += (size_t)(report.sparsityAfter * count + 0.5f);
+        pruned += report.pruned;
+    }
+    std::cout << "Pruned " << pruned << " of " << reports.size() << " convs, conv weight sparsity "
+              << (total ? (float)zeros / total : 0.f) << std::endl;
+
+    if (!writeWtsFile(argv[2], blobs) || !verifyPrunedFile(argv[2], blobs, reports)) {
+        std::cerr << "Failed to write " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "zone_filter.h"
+#include "custom_config.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+ZoneMask::ZoneMask(int gridWidth, int gridHeight)
+    : m_GridWidth(gridWidth),
+      m_GridHeight(gridHeight),
+      m_WordsPerRow((gridWidth + 63) / 64),
+      m_Bits(m_WordsPerRow * gridHeight, 0)
+{
+    assert(gridWidth > 0 && gridHeight > 0);
+}
+
+void ZoneMask::addPolygon(const std::vector<ZonePoint>& polygon)
+{
+    if (polygon.size() < 3) {
+        return;
+    }
+    // First column whose center lies at or right of x. The estimate is
+    // corrected in the float arithmetic of the centers themselves, so a
+    // center on an edge follows the [x0, x1) rule exactly.
+    auto firstColumn = [this](float x) {
+        int col = (int)std::min(std::max(std::ceil(x * m_GridWidth - 0.5F), 0.F), (float)m_GridWidth);
+        while (col > 0 && (col - 0.5F) / m_GridWidth >= x) {
+            col--;
+        }
+        while (col < m_GridWidth && (col + 0.5F) / m_GridWidth < x) {
+            col++;
+        }
+        return col;
+    };
+
+    // Scanline fill through cell centers
+    std::vector<float> crossings;
+    for (int row = 0; row < m_GridHeight; row++) {
+        float y = (row + 0.5F) / m_GridHeight;
+        crossings.clear();
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            const ZonePoint& a = polygon[i];
+            const ZonePoint& b = polygon[j];
+            if ((a.y > y) != (b.y > y)) {
+                crossings.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        uint64_t* bits = &m_Bits[row * m_WordsPerRow];
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            // Cells whose center x lies in [x0, x1)
+            int c0 = firstColumn(crossings[k]);
+            int c1 = firstColumn(crossings[k + 1]);
+            for (int col = c0; col < c1; col++) {
+                bits[col >> 6] |= 1ULL << (col & 63);
+                m_Empty = false;
+            }
+        }
+    }
+}
+
+bool ZoneMask::test(float x, float y) const
+{
+    int col = std::min(std::max((int)(x * m_GridWidth), 0), m_GridWidth - 1);
+    int row = std::min(std::max((int)(y * m_GridHeight), 0), m_GridHeight - 1);
+    return (m_Bits[row * m_WordsPerRow + (col >> 6)] >> (col & 63)) & 1;
+}
+
+bool parseZonePolygon(const std::string& s, std::vector<ZonePoint>& polygon)
+{
+    polygon.clear();
+    for (const std::string& vertex : splitString(s, ';')) {
+        std::vector<std::string> xy = splitString(vertex, ',');
+        if (xy.size() != 2) {
+            return false;
+        }
+        ZonePoint p;
+        p.x = std::atof(xy[0].c_str());
+        p.y = std::atof(xy[1].c_str());
+        polygon.push_back(p);
+    }
+    return polygon.size() >= 3;
+}
+
+ZoneFilter::ZoneFilter(int gridWidth, int gridHeight, ZoneAnchor anchor)
+    : m_GridWidth(gridWidth),
+      m_GridHeight(gridHeight),
+      m_Anchor(anchor)
+{
+}
+
+bool ZoneFilter::loadFromConfig(const CustomConfig& config)
+{
+    for (const std::string& key : config.getKeys("zones")) {
+        bool include = key.compare(0, 7, "include") == 0;
+        bool exclude = key.compare(0, 7, "exclude") == 0;
+        if (!include && !exclude) {
+            continue;
+        }
+        int sourceId = -1;
+        if (key.size() > 8 && key[7] == '-') {
+            sourceId = std::atoi(key.c_str() + 8);
+        } else if (key.size() != 7) {
+            continue;
+        }
+
+        for (const std::string& s : splitString(config.getString("zones", key), '|')) {
+            std::vector<ZonePoint> polygon;
+            if (!parseZonePolygon(s, polygon)) {
+                std::cerr << "Invalid zone polygon for " << key << ": " << s << std::endl;
+                return false;
+            }
+            if (include) {
+                addInclude(sourceId, polygon);
+            } else {
+                addExclude(sourceId, polygon);
+            }
+        }
+    }
+    return true;
+}
+
+ZoneFilter::Zones& ZoneFilter::getZones(int sourceId)
+{
+    auto it = m_Zones.find(sourceId);
+    if (it == m_Zones.end()) {
+        Zones zones{ ZoneMask(m_GridWidth, m_GridHeight), ZoneMask(m_GridWidth, m_GridHeight) };
+        it = m_Zones.insert(std::make_pair(sourceId, zones)).first;
+    }
+    return it->second;
+}
+
+const ZoneFilter::Zones* ZoneFilter::findZones(int sourceId) const
+{
+    auto it = m_Zones.find(sourceId);
+    if (it == m_Zones.end()) {
+        it = m_Zones.find(-1);
+    }
+    return it == m_Zones.end() ? nullptr : &it->second;
+}
+
+void ZoneFilter::addInclude(int sourceId, const std::vector<ZonePoint>& polygon)
+{
+    getZones(sourceId).include.addPolygon(polygon);
+}
+
+void ZoneFilter::addExclude(int sourceId, const std::vector<ZonePoint>& polygon)
+{
+    getZones(sourceId).exclude.addPolygon(polygon);
+}
+
+bool ZoneFilter::hasZones(int sourceId) const
+{
+    return findZones(sourceId) != nullptr;
+}
+
+bool ZoneFilter::accept(int sourceId, const NvDsInferParseObjectInfo& obj,
+    float frameWidth, float frameHeight) const
+{
+    const Zones* zones = findZones(sourceId);
+    if (!zones) {
+        return true;
+    }
+    float x = (obj.left + obj.width / 2.F) / frameWidth;
+    float y = (m_Anchor == ZoneAnchor::kBottomCenter ? obj.top + obj.height
+                                                     : obj.top + obj.height / 2.F) / frameHeight;
+    if (!zones->include.empty() && !zones->include.test(x, y)) {
+        return false;
+    }
+    return zones->exclude.empty() || !zones->exclude.test(x, y);
+}
+
+void ZoneFilter::filter(int sourceId, std::vector<NvDsInferParseObjectInfo>& objects,
+    float frameWidth, float frameHeight) const
+{
+    const Zones* zones = findZones(sourceId);
+    if (!zones) {
+        return;
+    }
+    auto last = std::remove_if(objects.begin(), objects.end(),
+        [&](const NvDsInferParseObjectInfo& obj) {
+            return !accept(sourceId, obj, frameWidth, frameHeight);
+        });
+    objects.erase(last, objects.end());
+}
@@ -0,0 +1,83 @@
+#ifndef _ZONE_FILTER_H_
+#define _ZONE_FILTER_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "nvdsinfer.h"
+
+class CustomConfig;
+
+// Polygon vertex in coordinates normalized to [0, 1] of the frame
+struct ZonePoint
+{
+    float x;
+    float y;
+};
+
+/**
+ * Union of polygons rasterized onto a grid bitmap. A cell is set when its
+ * center lies inside any polygon (even-odd rule), so a lookup is one shift
+ * and mask however many polygons and vertices the zones have.
+ */
+class ZoneMask {
+public:
+    ZoneMask(int gridWidth, int gridHeight);
+
+    void addPolygon(const std::vector<ZonePoint>& polygon);
+    bool test(float x, float y) const;
+    bool empty() const { return m_Empty; }
+
+private:
+    int m_GridWidth;
+    int m_GridHeight;
+    int m_WordsPerRow;
+    bool m_Empty = true;
+    std::vector<uint64_t> m_Bits;
+};
+
+enum class ZoneAnchor { kBottomCenter, kCenter };
+
+/**
+ * Per-source include/exclude zones. An object is kept when its anchor point
+ * is inside an include zone (or the source has none) and outside every
+ * exclude zone. Source -1 holds the zones used for sources without zones
+ * of their own.
+ */
+class ZoneFilter {
+public:
+    explicit ZoneFilter(int gridWidth = 128, int gridHeight = 128, ZoneAnchor anchor = ZoneAnchor::kBottomCenter);
+
+    // Reads the [zones] section: include[-<source>] and exclude[-<source>]
+    // keys hold polygons as "x,y;x,y;..." separated by '|'
+    bool loadFromConfig(const CustomConfig& config);
+
+    void addInclude(int sourceId, const std::vector<ZonePoint>& polygon);
+    void addExclude(int sourceId, const std::vector<ZonePoint>& polygon);
+
+    bool hasZones(int sourceId) const;
+    bool accept(int sourceId, const NvDsInferParseObjectInfo& obj, float frameWidth, float frameHeight) const;
+    void filter(int sourceId, std::vector<NvDsInferParseObjectInfo>& objects,
+        float frameWidth, float frameHeight) const;
+
+private:
+    struct Zones
+    {
+        ZoneMask include;
+        ZoneMask exclude;
+    };
+
+    Zones& getZones(int sourceId);
+    const Zones* findZones(int sourceId) const;
+
+    int m_GridWidth;
+    int m_GridHeight;
+    ZoneAnchor m_Anchor;
+    std::map<int, Zones> m_Zones;
+};
+
+// Parses "x,y;x,y;..." into a polygon, false when malformed
+bool parseZonePolygon(const std::string& s, std::vector<ZonePoint>& polygon);
+
+#endif // _ZONE_FILTER_H_